@@ -45,6 +45,8 @@ AppUI::AppUI(QMainWindow *owner)
   this->panoramicDialog = new PanoramicDialog(owner);
   this->logDialog = new LogDialog(owner);
   this->backgroundTasksDialog = new BackgroundTasksDialog(owner);
+  this->recordingsDialog = new RecordingsDialog(owner);
+  this->captureOverviewDialog = new CaptureOverviewDialog(owner);
   this->addBookmarkDialog = new AddBookmarkDialog(owner);
   this->bookmarkManagerDialog = new BookmarkManagerDialog(owner);
 }
@@ -52,6 +52,8 @@ Application::Application(QWidget *parent) : QMainWindow(parent), ui(this)
   this->deviceDetectWorker = new DeviceDetectWorker();
   this->deviceDetectWorker->moveToThread(this->deviceDetectThread);
   this->deviceDetectThread->start();
+
+  SampleBus::getInstance()->subscribe(SIGDIGGER_AUDIO_INSPECTOR_MAGIC_ID, this);
 }
 
 Suscan::Object &&
@@ -105,6 +107,18 @@ Application::getSaver(void) const
   return this->dataSaver.get();
 }
 
+PreRollBuffer *
+Application::getPreRoll(void)
+{
+  return &this->preRoll;
+}
+
+SubbandExtractor *
+Application::getSubband(void)
+{
+  return &this->subband;
+}
+
 SUPRIVATE SUBOOL
 onBaseBandData(
     void *privdata,
@@ -113,10 +127,10 @@ onBaseBandData(
     SUSCOUNT length)
 {
   Application *app = static_cast<Application *>(privdata);
-  FileDataSaver *saver;
 
-  if ((saver = app->getSaver()) != nullptr)
-    saver->write(samples, length);
+  // Forwards samples to the data saver too, if any
+  app->getPreRoll()->feed(samples, length);
+  app->getSubband()->feed(samples, length);
 
   return SU_TRUE;
 }
@@ -124,7 +138,28 @@ onBaseBandData(
 void
 Application::uninstallDataSaver()
 {
+  this->preRoll.detach();
+  this->subband.detach();
   this->dataSaver = nullptr;
+
+  // In case the saver left before writing the pre-roll
+  this->preRoll.thaw();
+}
+
+void
+Application::installPreRoll(void)
+{
+  size_t len =
+      static_cast<size_t>(this->ui.sourcePanel->getRecordPreRoll())
+      * this->mediator->getProfile()->getDecimatedSampleRate();
+
+  if (!this->preRoll.setLength(len))
+    return;
+
+  if (len > 0 && this->analyzer.get() != nullptr && !this->filterInstalled) {
+    this->analyzer->registerBaseBandFilter(onBaseBandData, this);
+    this->filterInstalled = true;
+  }
 }
 
 void
@@ -184,19 +219,76 @@ Application::connectAudioFileSaver()
 }
 
 
+void
+Application::attachDataSaver(void)
+{
+  this->dataSaver->setSampleRate(this->getRecordSampleRate());
+  this->dataSaver->setSyncInterval(
+        this->ui.sourcePanel->getRecordSyncInterval());
+  if (!this->filterInstalled) {
+    this->analyzer->registerBaseBandFilter(onBaseBandData, this);
+    this->filterInstalled = true;
+  }
+  this->connectDataSaver();
+
+  // Channel recordings get their samples from the extractor only
+  if (this->recordSubband)
+    this->subband.attach(this->dataSaver.get(), this->subbandParams);
+  else
+    this->preRoll.attach(this->dataSaver.get());
+}
+
 void
 Application::installDataSaver(int fd)
 {
   if (this->dataSaver.get() == nullptr && this->analyzer.get() != nullptr) {
     this->dataSaver = std::make_unique<FileDataSaver>(fd, this);
-    this->dataSaver->setSampleRate(
+    this->attachDataSaver();
+  }
+}
+
+void
+Application::installDataSaver(FileDataSaver::SegmentParams const &params)
+{
+  if (this->dataSaver.get() == nullptr && this->analyzer.get() != nullptr) {
+    this->dataSaver = std::make_unique<FileDataSaver>(params, this);
+    this->attachDataSaver();
+  }
+}
+
+bool
+Application::openDataSaver(void)
+{
+  FileDataSaver::SegmentParams params;
+  int fd;
+
+  params.maxSize     = this->ui.sourcePanel->getRecordSegmentSize();
+  params.maxDuration = this->ui.sourcePanel->getRecordSegmentDuration();
+
+  // The channel is fixed when the recording starts
+  this->recordSubband = this->ui.sourcePanel->getRecordSubband();
+  if (this->recordSubband) {
+    this->subbandParams.sampRate = static_cast<SUFLOAT>(
           this->mediator->getProfile()->getDecimatedSampleRate());
-    if (!this->filterInstalled) {
-      this->analyzer->registerBaseBandFilter(onBaseBandData, this);
-      this->filterInstalled = true;
-    }
-    this->connectDataSaver();
+    this->subbandParams.offset = static_cast<SUFLOAT>(
+          this->ui.spectrum->getLoFreq());
+    this->subbandParams.bandwidth = static_cast<SUFLOAT>(
+          this->ui.spectrum->getBandwidth());
+  }
+
+  if (params.enabled()) {
+    params.prefix   = this->captureFilePrefix();
+    params.quota    = this->ui.sourcePanel->getRecordQuota();
+    params.sampRate = this->getRecordSampleRate();
+
+    this->installDataSaver(params);
+    return true;
   }
+
+  if ((fd = this->openCaptureFile()) != -1)
+    this->installDataSaver(fd);
+
+  return fd != -1;
 }
 
 void
@@ -216,6 +308,11 @@ Application::setAudioInspectorParams(
     cfg.set("audio.squelch", squelch);
     cfg.set("audio.squelch-level", squelchLevel);
     this->analyzer->setInspectorConfig(this->audioInspHandle, cfg, 0);
+
+    // Recorded channels are demodulated alike
+    if (this->audioChanInspectorOpened)
+      this->analyzer->setInspectorConfig(this->audioChanInspHandle, cfg, 0);
+
     this->assertAudioInspectorLo();
   } else {
     this->delayedRate      = rate;
@@ -238,8 +335,28 @@ Application::openAudioFileSaver(void)
     params.frequency  =
         this->ui.spectrum->getCenterFreq() + this->ui.spectrum->getLoFreq();
     params.modulation = this->ui.audioPanel->getDemod();
+    params.format     = this->ui.audioPanel->getRecordFormat();
+
+    if (this->ui.audioPanel->getRecordChannelEnabled()
+        && this->mediator->getState() == UIMediator::RUNNING) {
+      if (this->openAudioChannelInspector()) {
+        params.extraFrequencies.push_back(
+              this->ui.audioPanel->getRecordChannelFrequency());
+      } else {
+        QMessageBox::warning(
+              this,
+              "Audio recording",
+              "The second audio channel is outside the captured band. "
+              "Only the main channel will be recorded.",
+              QMessageBox::Ok);
+      }
+    }
 
     this->audioFileSaver = std::make_unique<AudioFileSaver>(params, nullptr);
+    if (params.extraFrequencies.size() > 0)
+      this->audioFileSaver->feedChannelFrom(
+            1,
+            SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_MAGIC_ID);
     this->connectAudioFileSaver();
     opened = true;
   }
@@ -250,6 +367,8 @@ Application::openAudioFileSaver(void)
 void
 Application::closeAudioFileSaver(void)
 {
+  this->closeAudioChannelInspector();
+
   if (this->audioFileSaver != nullptr)
     this->audioFileSaver = nullptr;
 
@@ -357,9 +476,8 @@ Application::getAudioInspectorBandwidth(void) const
 }
 
 SUFREQ
-Application::getAudioInspectorLo(void) const
+Application::getAudioSidebandOffset(void) const
 {
-  SUFREQ lo = this->ui.spectrum->getLoFreq();
   SUFREQ bw = this->getAudioInspectorBandwidth();
   SUFREQ delta = 0;
 
@@ -368,7 +486,63 @@ Application::getAudioInspectorLo(void) const
   else if (this->ui.audioPanel->getDemod() == AudioDemod::LSB)
     delta -= .5 * bw;
 
-  return lo + delta;
+  return delta;
+}
+
+SUFREQ
+Application::getAudioInspectorLo(void) const
+{
+  return this->ui.spectrum->getLoFreq() + this->getAudioSidebandOffset();
+}
+
+SUFREQ
+Application::getAudioChannelLo(void) const
+{
+  // The channel is tuned to an absolute frequency, not to the LO
+  return this->ui.audioPanel->getRecordChannelFrequency()
+      - this->ui.spectrum->getCenterFreq()
+      + this->getAudioSidebandOffset();
+}
+
+bool
+Application::openAudioChannelInspector(void)
+{
+  Suscan::Channel ch;
+  SUFREQ maxFc = this->analyzer->getSampleRate() / 2;
+  SUFREQ fc = this->getAudioChannelLo();
+
+  if (fc > maxFc || fc < -maxFc)
+    return false;
+
+  ch.bw    = this->maxAudioBw;
+  ch.ft    = 0;
+  ch.fc    = fc;
+  ch.fLow  = -.5 * this->maxAudioBw;
+  ch.fHigh = .5 * this->maxAudioBw;
+
+  try {
+    this->analyzer->openPrecise(
+          "audio",
+          ch,
+          SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_REQID);
+  } catch (Suscan::Exception const &) {
+    return false;
+  }
+
+  this->lastAudioChanLo = fc;
+
+  return true;
+}
+
+void
+Application::closeAudioChannelInspector(void)
+{
+  if (this->mediator->getState() == UIMediator::RUNNING
+      && this->audioChanInspectorOpened)
+    this->analyzer->closeInspector(this->audioChanInspHandle, 0);
+
+  this->audioChanInspectorOpened = false;
+  this->audioChanInspHandle = 0;
 }
 
 
@@ -405,6 +579,18 @@ Application::connectUI(void)
         this,
         SLOT(onToggleRecord(void)));
 
+  connect(
+        this->mediator,
+        SIGNAL(preRollChanged(void)),
+        this,
+        SLOT(onPreRollChanged(void)));
+
+  connect(
+        &this->subband,
+        SIGNAL(swamped(void)),
+        this,
+        SLOT(onSaveSwamped(void)));
+
   connect(
         this->mediator,
         SIGNAL(throttleConfigChanged(void)),
@@ -771,13 +957,11 @@ Application::startCapture(void)
 
       // All set, move to application
       this->analyzer = std::move(analyzer);
+      this->installPreRoll();
 
       // If there is a capture file configured, install data saver
-      if (this->ui.sourcePanel->getRecordState()) {
-        int fd = this->openCaptureFile();
-        if (fd != -1)
-          this->installDataSaver(fd);
-      }
+      if (this->ui.sourcePanel->getRecordState())
+        this->openDataSaver();
 
       this->connectAnalyzer();
 
@@ -804,6 +988,7 @@ Application::orderedHalt(void)
   this->mediator->setState(UIMediator::HALTING);
   this->analyzer = nullptr;
   this->uninstallDataSaver();
+  this->preRoll.clear();
   this->mediator->setRecordState(false);
   this->mediator->detachAllInspectors();
   this->closeAudio();
@@ -869,27 +1054,20 @@ Application::onSourceInfoMessage(const Suscan::SourceInfoMessage &msg)
 }
 
 void
-Application::onInspectorSamples(const Suscan::SamplesMessage &msg)
+Application::consume(SampleBuffer const &buffer)
 {
-  Inspector *insp;
-
-  if (msg.getInspectorId() == SIGDIGGER_AUDIO_INSPECTOR_MAGIC_ID) {
-    if (this->playBack != nullptr)
-      this->playBack->write(msg.getSamples(), msg.getCount());
-    if (this->audioFileSaver != nullptr)
-      this->audioFileSaver->write(msg.getSamples(), msg.getCount());
-  } else {
-    switch (msg.getInspectorId()) {
-      case SIGDIGGER_RAW_INSPECTOR_MAGIC_ID:
-        this->mediator->feedRawInspector(msg.getSamples(), msg.getCount());
-        break;
+  if (this->playBack != nullptr)
+    this->playBack->write(buffer.data(), buffer.size());
+  if (this->audioFileSaver != nullptr)
+    this->audioFileSaver->writeChannel(0, buffer.data(), buffer.size());
+}
 
-      default:
-        if ((insp = this->mediator->lookupInspector(msg.getInspectorId()))
-                     != nullptr)
-            insp->feed(msg.getSamples(), msg.getCount());
-    }
-  }
+void
+Application::onInspectorSamples(const Suscan::SamplesMessage &msg)
+{
+  // Consumers (audio, raw inspector and inspector tabs) get a reference
+  // to the message payload, not a copy
+  SampleBus::getInstance()->publish(msg.getInspectorId(), SampleBuffer(msg));
 }
 
 void
@@ -919,7 +1097,37 @@ Application::onInspectorMessage(const Suscan::InspectorMessage &msg)
     case SUSCAN_ANALYZER_INSPECTOR_MSGKIND_OPEN:
       // Audio path: set inspector Id
 
-      if (msg.getClass() == "audio") {
+      if (msg.getClass() == "audio"
+          && msg.getRequestId() == SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_REQID) {
+        if (this->audioChanInspectorOpened
+            || this->audioFileSaver == nullptr
+            || this->audioFileSaver->getChannelCount() < 2) {
+          // The recording it was opened for is gone
+          this->analyzer->closeInspector(msg.getHandle(), 0);
+        } else {
+          this->audioChanInspHandle = msg.getHandle();
+          this->audioChanInspectorOpened = true;
+          this->analyzer->setInspectorId(
+                msg.getHandle(),
+                SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_MAGIC_ID,
+                0);
+          this->analyzer->setInspectorWatermark(
+                msg.getHandle(),
+                SIGDIGGER_AUDIO_BUFFER_SIZE / 2,
+                0);
+          this->analyzer->setInspectorBandwidth(
+                msg.getHandle(),
+                this->getAudioInspectorBandwidth(),
+                0);
+
+          this->setAudioInspectorParams(
+                this->audioSampleRate,
+                this->ui.audioPanel->getCutOff(),
+                this->ui.audioPanel->getDemod() + 1,
+                this->ui.audioPanel->getSquelchEnabled(),
+                this->ui.audioPanel->getSquelchLevel());
+        }
+      } else if (msg.getClass() == "audio") {
         this->audioInspHandle = msg.getHandle();
         this->audioInspectorOpened = true;
         this->analyzer->setInspectorId(
@@ -1025,6 +1233,8 @@ Application::onAnalyzerReadError(void)
 
 Application::~Application()
 {
+  SampleBus::getInstance()->unsubscribe(this);
+
   if (this->audioCfgTemplate != nullptr)
     suscan_config_destroy(this->audioCfgTemplate);
 
@@ -1095,8 +1305,13 @@ Application::onFrequencyChanged(qint64 freq, qint64 lnb)
   this->mediator->getProfile()->setFreq(freq);
   this->mediator->getProfile()->setLnbFreq(lnb);
 
-  if (this->mediator->getState() == UIMediator::RUNNING)
+  if (this->mediator->getState() == UIMediator::RUNNING) {
     this->analyzer->setFrequency(freq, lnb);
+
+    // The second audio channel stays on its absolute frequency
+    if (this->audioConfigured)
+      this->assertAudioInspectorLo();
+  }
 }
 
 void
@@ -1196,10 +1411,35 @@ Application::onThrottleConfigChanged(void)
 //
 // sigdigger_XXXXXXXX_XXXXXXZ_XXXXXXXXXX_XXXXXXXXXXXXXXXXXXXX_float32_iq.raw
 //
-int
-Application::openCaptureFile(void)
+unsigned int
+Application::getRecordSampleRate(void) const
+{
+  unsigned int rate = this->mediator->getProfile()->getDecimatedSampleRate();
+
+  if (this->recordSubband)
+    rate = static_cast<unsigned int>(
+          round(static_cast<qreal>(rate)
+          / SubbandDDC::decimationFor(
+            this->subbandParams.sampRate,
+            this->subbandParams.bandwidth)));
+
+  return rate;
+}
+
+SUFREQ
+Application::getRecordFrequency(void) const
+{
+  SUFREQ freq = this->mediator->getProfile()->getFreq();
+
+  if (this->recordSubband)
+    freq += static_cast<SUFREQ>(this->subbandParams.offset);
+
+  return freq;
+}
+
+std::string
+Application::captureFilePrefix(void) const
 {
-  int fd = -1;
   char baseName[80];
   char datetime[17];
   time_t unixtime;
@@ -1212,13 +1452,19 @@ Application::openCaptureFile(void)
   snprintf(
         baseName,
         sizeof(baseName),
-        "sigdigger_%s_%d_%.0lf_float32_iq.raw",
+        "sigdigger_%s_%d_%.0lf_float32_iq",
         datetime,
-        this->mediator->getProfile()->getDecimatedSampleRate(),
-        this->mediator->getProfile()->getFreq());
+        this->getRecordSampleRate(),
+        this->getRecordFrequency());
+
+  return this->ui.sourcePanel->getRecordSavePath() + "/" + baseName;
+}
 
-  std::string fullPath =
-      this->ui.sourcePanel->getRecordSavePath() + "/" + baseName;
+int
+Application::openCaptureFile(void)
+{
+  int fd = -1;
+  std::string fullPath = this->captureFilePrefix() + ".raw";
 
   if ((fd = creat(fullPath.c_str(), 0600)) == -1) {
     QMessageBox::warning(
@@ -1236,20 +1482,27 @@ void
 Application::onToggleRecord(void)
 {
   if (this->ui.sourcePanel->getRecordState()) {
-    if (this->mediator->getState() == UIMediator::RUNNING) {
-      int fd = this->openCaptureFile();
-      if (fd != -1)
-        this->installDataSaver(fd);
-
-      this->ui.sourcePanel->setRecordState(fd != -1);
-    }
+    if (this->mediator->getState() == UIMediator::RUNNING)
+      this->ui.sourcePanel->setRecordState(this->openDataSaver());
   } else {
     this->uninstallDataSaver();
     this->mediator->setCaptureSize(0);
     this->ui.sourcePanel->setRecordState(false);
+
+    // Pre-roll length changes are deferred while recording
+    if (this->mediator->getState() == UIMediator::RUNNING)
+      this->installPreRoll();
   }
 }
 
+void
+Application::onPreRollChanged(void)
+{
+  if (this->mediator->getState() == UIMediator::RUNNING
+      && this->dataSaver.get() == nullptr)
+    this->installPreRoll();
+}
+
 void
 Application::onSaveError(void)
 {
@@ -1292,6 +1545,7 @@ void
 Application::onCommit(void)
 {
   this->mediator->setCaptureSize(this->dataSaver->getSize());
+  this->mediator->setCaptureStats(this->dataSaver->getStats());
 }
 
 void
@@ -1331,8 +1585,8 @@ Application::onAudioSaveRate(qreal rate)
 void
 Application::onAudioCommit(void)
 {
-  this->mediator->setAudioRecordSize(
-        this->audioFileSaver->getSize() * sizeof(uint16_t) / sizeof(SUCOMPLEX));
+  this->mediator->setAudioRecordSize(this->audioFileSaver->getFileSize());
+  this->mediator->setAudioRecordStats(this->audioFileSaver->getStats());
 }
 
 
@@ -1352,6 +1606,15 @@ Application::assertAudioInspectorLo(void)
     this->analyzer->setInspectorFreq(this->audioInspHandle, lo, 0);
     this->lastAudioLo = lo;
   }
+
+  if (this->audioChanInspectorOpened) {
+    lo = this->getAudioChannelLo();
+
+    if (fabs(lo - this->lastAudioChanLo) > 1e-8) {
+      this->analyzer->setInspectorFreq(this->audioChanInspHandle, lo, 0);
+      this->lastAudioChanLo = lo;
+    }
+  }
 }
 
 void
@@ -1362,6 +1625,10 @@ Application::onChannelBandwidthChanged(qreal)
     bw = this->getAudioInspectorBandwidth();
 
     this->analyzer->setInspectorBandwidth(this->audioInspHandle, bw, 0);
+
+    if (this->audioChanInspectorOpened)
+      this->analyzer->setInspectorBandwidth(this->audioChanInspHandle, bw, 0);
+
     this->assertAudioInspectorLo();
   }
 }
@@ -19,7 +19,11 @@
 
 #include <AudioFileSaver.h>
 #include <sndfile.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 using namespace SigDigger;
 
@@ -29,15 +33,26 @@ namespace SigDigger {
     std::string fullPath;
     std::string lastError;
     SNDFILE *sfp = nullptr;
+    std::vector<SUFLOAT> realData;
+    unsigned int channels;
+
+    // Updated by the writer thread, read by the GUI
+    std::atomic<quint64> fileSize;
+
+    void refreshFileSize(void);
 
   public:
     AudioFileWriter(AudioFileSaver::AudioFileParams const &params);
     ~AudioFileWriter();
 
+    quint64 getFileSize(void) const;
+
     bool prepare(void);
     bool canWrite(void) const;
     std::string getError(void) const;
     ssize_t write(const SUCOMPLEX *data, size_t len);
+    bool canSync(void) const;
+    bool sync(void);
     bool close(void);
   };
 }
@@ -48,14 +63,31 @@ AudioFileWriter::getError(void) const
   return this->lastError;
 }
 
+void
+AudioFileWriter::refreshFileSize(void)
+{
+  struct stat sbuf;
+
+  if (stat(this->fullPath.c_str(), &sbuf) != -1)
+    this->fileSize = static_cast<quint64>(sbuf.st_size);
+}
+
+quint64
+AudioFileWriter::getFileSize(void) const
+{
+  return this->fileSize;
+}
+
 bool
 AudioFileWriter::prepare(void)
 {
   if (this->sfp == nullptr) {
-    char fileName[128];
+    char fileName[256];
+    char freq[32];
     unsigned int index = 1;
     SF_INFO sfinfo;
     std::string modulation;
+    std::string frequencies;
 
     switch (this->params.modulation) {
       case AM:
@@ -75,21 +107,52 @@ AudioFileWriter::prepare(void)
         break;
     }
 
+    // All channel frequencies go in the name, e.g. 145800000+437800000
+    snprintf(freq, sizeof(freq), "%.0lf", this->params.frequency);
+    frequencies = freq;
+
+    for (auto f : this->params.extraFrequencies) {
+      snprintf(freq, sizeof(freq), "+%.0lf", f);
+      frequencies += freq;
+    }
+
     do {
       snprintf(
             fileName,
             sizeof(fileName),
-            "audio-%s-%.0lf-%d-%04d.wav",
+            "audio-%s-%s-%d-%04d.%s",
             modulation.c_str(),
-            this->params.frequency,
+            frequencies.c_str(),
             this->params.sampRate,
-            index++);
+            index++,
+            AudioFileSaver::formatExtension(this->params.format).c_str());
       this->fullPath = this->params.savePath + "/" + fileName;
     } while (access(this->fullPath.c_str(), F_OK) != -1);
 
-    sfinfo.channels = 1;
+    sfinfo.channels = static_cast<int>(this->channels);
     sfinfo.samplerate = static_cast<int>(this->params.sampRate);
-    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+
+    // Compression happens in sf_writef_float, i.e. in the writer thread
+    switch (this->params.format) {
+      case AUDIO_FILE_FORMAT_WAV:
+        sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+        break;
+
+      case AUDIO_FILE_FORMAT_FLAC:
+        sfinfo.format = SF_FORMAT_FLAC | SF_FORMAT_PCM_16;
+        break;
+
+      case AUDIO_FILE_FORMAT_OGG:
+        sfinfo.format = SF_FORMAT_OGG | SF_FORMAT_VORBIS;
+        break;
+    }
+
+    if (!sf_format_check(&sfinfo)) {
+      this->lastError =
+          "Audio format not supported by libsndfile (check that it has been "
+          "built with FLAC and Ogg/Vorbis support)";
+      return false;
+    }
 
     if ((this->sfp = sf_open(this->fullPath.c_str(), SFM_WRITE, &sfinfo))
         == nullptr) {
@@ -100,14 +163,19 @@ AudioFileWriter::prepare(void)
           + sf_strerror(nullptr);
       return false;
     }
+
+    this->refreshFileSize();
   }
 
   return true;
 }
 
-AudioFileWriter::AudioFileWriter(AudioFileSaver::AudioFileParams const &p)
+AudioFileWriter::AudioFileWriter(AudioFileSaver::AudioFileParams const &p) :
+  fileSize(0)
 {
   this->params = p;
+  this->channels =
+      1 + static_cast<unsigned int>(p.extraFrequencies.size());
 }
 
 AudioFileWriter::~AudioFileWriter(void)
@@ -121,24 +189,48 @@ AudioFileWriter::canWrite(void) const
   return this->sfp != nullptr;
 }
 
+// Data comes as interleaved frames, one channel sample per real part
 ssize_t
 AudioFileWriter::write(const SUCOMPLEX *data, size_t len)
 {
-  ssize_t result;
-  std::vector<SUFLOAT> realData;
-  unsigned int i;
+  sf_count_t result;
+  size_t i;
 
   if (this->sfp == nullptr)
     return 0;
 
-  realData.resize(len);
+  if (this->realData.size() < len)
+    this->realData.resize(len);
 
   for (i = 0; i < len; ++i)
-    realData[i] = SU_C_REAL(data[i]);
+    this->realData[i] = SU_C_REAL(data[i]);
+
+  result = sf_writef_float(
+        this->sfp,
+        this->realData.data(),
+        static_cast<sf_count_t>(len / this->channels));
+
+  if (result < 1)
+    this->lastError = std::string("Audio write failed: ") + sf_strerror(this->sfp);
+
+  this->refreshFileSize();
+
+  return static_cast<ssize_t>(result) * this->channels;
+}
+
+bool
+AudioFileWriter::canSync(void) const
+{
+  return true;
+}
 
-  result = sf_write_float(this->sfp, realData.data(), len);
+bool
+AudioFileWriter::sync(void)
+{
+  if (this->sfp != nullptr)
+    sf_write_sync(this->sfp);
 
-  return result;
+  return true;
 }
 
 bool
@@ -147,15 +239,36 @@ AudioFileWriter::close(void)
   if (this->sfp != nullptr) {
     sf_close(this->sfp);
     this->sfp = nullptr;
+
+    // Encoders flush their last blocks and headers on close
+    this->refreshFileSize();
   }
 
   return true;
 }
+////////////////////////////// AudioChannelFeeder /////////////////////////////
+AudioChannelFeeder::AudioChannelFeeder(
+    AudioFileSaver *saver,
+    unsigned int channel)
+{
+  this->saver   = saver;
+  this->channel = channel;
+}
+
+void
+AudioChannelFeeder::consume(SampleBuffer const &buffer)
+{
+  this->saver->writeChannel(this->channel, buffer.data(), buffer.size());
+}
+
 //////////////////////////////// AudioFileSaver ///////////////////////////////
 
 
 AudioFileSaver::~AudioFileSaver()
 {
+  for (auto &feeder : this->feeders)
+    SampleBus::getInstance()->unsubscribe(feeder.get());
+
   if (this->writer != nullptr)
     delete this->writer;
 }
@@ -166,5 +279,110 @@ AudioFileSaver::AudioFileSaver(
   GenericDataSaver(this->writer = new AudioFileWriter(params), parent)
 {
   this->params = params;
-  this->setSampleRate(params.sampRate);
+  this->staging.resize(this->getChannelCount());
+  this->started.resize(this->getChannelCount(), false);
+  this->setSampleRate(params.sampRate * this->getChannelCount());
+}
+
+unsigned int
+AudioFileSaver::getChannelCount(void) const
+{
+  return 1 + static_cast<unsigned int>(this->params.extraFrequencies.size());
+}
+
+quint64
+AudioFileSaver::getFileSize(void) const
+{
+  return this->writer->getFileSize();
+}
+
+void
+AudioFileSaver::feedChannelFrom(unsigned int channel, Suscan::InspectorId id)
+{
+  this->feeders.push_back(
+        std::make_unique<AudioChannelFeeder>(this, channel));
+  SampleBus::getInstance()->subscribe(id, this->feeders.back().get());
+}
+
+void
+AudioFileSaver::writeChannel(
+    unsigned int channel,
+    const SUCOMPLEX *data,
+    size_t len)
+{
+  unsigned int channels = this->getChannelCount();
+  size_t i, c, avail, maxLen = 0;
+  size_t maxLag = this->params.sampRate;
+
+  if (channels == 1) {
+    this->write(data, len);
+    return;
+  }
+
+  if (channel >= channels)
+    return;
+
+  // The last channel to start sets the start of the file
+  if (!this->started[channel]) {
+    this->started[channel] = true;
+
+    if (std::all_of(
+          this->started.begin(),
+          this->started.end(),
+          [] (bool s) { return s; }))
+      for (auto &s : this->staging)
+        s.clear();
+  }
+
+  for (i = 0; i < len; ++i)
+    this->staging[channel].push_back(SU_C_REAL(data[i]));
+
+  for (auto &s : this->staging)
+    if (s.size() > maxLen)
+      maxLen = s.size();
+
+  // Stalled channels (or channels that never started) are padded with
+  // silence
+  if (maxLen > maxLag)
+    for (c = 0; c < channels; ++c)
+      if (this->staging[c].size() < maxLen - maxLag) {
+        this->staging[c].resize(maxLen - maxLag, 0);
+        this->started[c] = true;
+      }
+
+  avail = maxLen;
+  for (auto &s : this->staging)
+    if (s.size() < avail)
+      avail = s.size();
+
+  if (avail == 0)
+    return;
+
+  this->frames.resize(avail * channels);
+
+  for (i = 0; i < avail; ++i)
+    for (c = 0; c < channels; ++c)
+      this->frames[i * channels + c] = this->staging[c][i];
+
+  for (auto &s : this->staging)
+    s.erase(s.begin(), s.begin() + static_cast<long>(avail));
+
+  this->write(this->frames.data(), this->frames.size());
+}
+
+std::string
+AudioFileSaver::formatExtension(AudioFileFormat format)
+{
+  switch (format) {
+    case AUDIO_FILE_FORMAT_WAV:
+      return "wav";
+
+    case AUDIO_FILE_FORMAT_FLAC:
+      return "flac";
+
+    case AUDIO_FILE_FORMAT_OGG:
+      return "ogg";
+  }
+
+  return "wav";
 }
@@ -44,9 +44,12 @@ AudioPanelConfig::deserialize(Suscan::Object const &conf)
   LOAD(cutOff);
   LOAD(volume);
   LOAD(savePath);
+  LOAD(format);
   LOAD(squelch);
   LOAD(amSquelch);
   LOAD(ssbSquelch);
+  LOAD(channel);
+  LOAD(channelFreq);
 }
 
 Suscan::Object &&
@@ -62,9 +65,12 @@ AudioPanelConfig::serialize(void)
   STORE(cutOff);
   STORE(volume);
   STORE(savePath);
+  STORE(format);
   STORE(squelch);
   STORE(amSquelch);
   STORE(ssbSquelch);
+  STORE(channel);
+  STORE(channelFreq);
 
   return this->persist(obj);
 }
@@ -105,6 +111,17 @@ AudioPanel::demodToStr(AudioDemod demod)
   return "AM"; // Default
 }
 
+AudioFileFormat
+AudioPanel::strToFormat(std::string const &str)
+{
+  if (str == "flac")
+    return AUDIO_FILE_FORMAT_FLAC;
+  else if (str == "ogg")
+    return AUDIO_FILE_FORMAT_OGG;
+
+  return AUDIO_FILE_FORMAT_WAV;
+}
+
 void
 AudioPanel::connectAll(void)
 {
@@ -167,6 +184,30 @@ AudioPanel::connectAll(void)
         SIGNAL(valueChanged(qreal)),
         this,
         SLOT(onSquelchLevelChanged(void)));
+
+  connect(
+        this->ui->formatCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onFormatChanged(void)));
+
+  connect(
+        this->ui->channelCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onChannelChanged(void)));
+
+  connect(
+        this->ui->channelFreqSpin,
+        SIGNAL(valueChanged(double)),
+        this,
+        SLOT(onChannelChanged(void)));
+
+  connect(
+        this->ui->statsButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onSaveStats(void)));
 }
 
 void
@@ -241,6 +282,10 @@ AudioPanel::AudioPanel(QWidget *parent) :
 
   this->setRecordSavePath(QDir::currentPath().toStdString());
 
+  this->ui->channelFreqSpin->setMinimum(0);
+  this->ui->channelFreqSpin->setMaximum(300e9);
+  this->ui->channelFreqSpin->setAutoUnitMultiplierEnabled(true);
+
   this->assertConfig();
   this->populateRates();
   this->connectAll();
@@ -319,6 +364,29 @@ AudioPanel::setVolume(SUFLOAT volume)
         QString::number(this->ui->volumeSlider->value()) + " dB");
 }
 
+void
+AudioPanel::setRecordFormat(AudioFileFormat format)
+{
+  this->panelConfig->format = AudioFileSaver::formatExtension(format);
+  this->ui->formatCombo->setCurrentIndex(static_cast<int>(format));
+}
+
+void
+AudioPanel::setRecordChannelEnabled(bool enabled)
+{
+  this->panelConfig->channel = enabled;
+  this->ui->channelCheck->setChecked(enabled);
+  this->ui->channelFreqSpin->setEnabled(
+        enabled && this->ui->channelCheck->isEnabled());
+}
+
+void
+AudioPanel::setRecordChannelFrequency(SUFREQ freq)
+{
+  this->panelConfig->channelFreq = freq;
+  this->ui->channelFreqSpin->setValue(freq);
+}
+
 void
 AudioPanel::setMuted(bool muted)
 {
@@ -383,11 +451,11 @@ formatCaptureSize(quint64 size)
   return QString::number(size >> 30) + " GiB";
 }
 
+// Bytes on disk, as the file size depends on the format
 void
 AudioPanel::setCaptureSize(quint64 size)
 {
-  this->ui->captureSizeLabel->setText(
-        formatCaptureSize(size * sizeof(float _Complex)));
+  this->ui->captureSizeLabel->setText(formatCaptureSize(size));
 }
 
 void
@@ -409,11 +477,24 @@ AudioPanel::setIORate(qreal)
   this->refreshDiskUsage();
 }
 
+void
+AudioPanel::setStats(DataSaverStats const &stats)
+{
+  GenericDataSaverUI::setStats(stats);
+
+  this->ui->captureSizeLabel->setToolTip(stats.summary());
+  this->ui->statsButton->setEnabled(true);
+}
+
 void
 AudioPanel::setRecordState(bool state)
 {
   this->ui->recordStartStopButton->setChecked(state);
   this->ui->recordStartStopButton->setText(state ? "Stop" : "Record");
+  this->ui->formatCombo->setEnabled(!state);
+  this->ui->channelCheck->setEnabled(!state);
+  this->ui->channelFreqSpin->setEnabled(
+        !state && this->ui->channelCheck->isChecked());
 }
 
 // Getters
@@ -500,6 +581,24 @@ AudioPanel::getRecordState(void) const
   return this->ui->recordStartStopButton->isChecked();
 }
 
+AudioFileFormat
+AudioPanel::getRecordFormat(void) const
+{
+  return static_cast<AudioFileFormat>(this->ui->formatCombo->currentIndex());
+}
+
+bool
+AudioPanel::getRecordChannelEnabled(void) const
+{
+  return this->ui->channelCheck->isChecked();
+}
+
+SUFREQ
+AudioPanel::getRecordChannelFrequency(void) const
+{
+  return this->ui->channelFreqSpin->value();
+}
+
 std::string
 AudioPanel::getRecordSavePath(void) const
 {
@@ -522,6 +621,9 @@ AudioPanel::applyConfig(void)
   this->setDemod(strToDemod(this->panelConfig->demod));
   this->setEnabled(this->panelConfig->enabled);
   this->setSquelchEnabled(this->panelConfig->squelch);
+  this->setRecordFormat(strToFormat(this->panelConfig->format));
+  this->setRecordChannelFrequency(this->panelConfig->channelFreq);
+  this->setRecordChannelEnabled(this->panelConfig->channel);
 
   if (this->panelConfig->savePath.size() > 0)
     this->setRecordSavePath(this->panelConfig->savePath);
@@ -604,14 +706,25 @@ AudioPanel::onChangeSavePath(void)
 void
 AudioPanel::onRecordStartStop(void)
 {
-  this->ui->recordStartStopButton->setText(
-        this->ui->recordStartStopButton->isChecked()
-        ? "Stop"
-        : "Record");
+  // Recorder settings cannot change under a file being written
+  this->setRecordState(this->ui->recordStartStopButton->isChecked());
 
   emit recordStateChanged(this->ui->recordStartStopButton->isChecked());
 }
 
+void
+AudioPanel::onFormatChanged(void)
+{
+  this->setRecordFormat(this->getRecordFormat());
+}
+
+void
+AudioPanel::onChannelChanged(void)
+{
+  this->setRecordChannelFrequency(this->getRecordChannelFrequency());
+  this->setRecordChannelEnabled(this->getRecordChannelEnabled());
+}
+
 void
 AudioPanel::onToggleSquelch(void)
 {
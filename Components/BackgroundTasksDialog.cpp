@@ -21,9 +21,11 @@
 #include "ui_BackgroundTasksDialog.h"
 
 #include <MultitaskControllerModel.h>
+#include <Suscan/MultitaskController.h>
 #include <QSortFilterProxyModel>
 #include <QMouseEvent>
 #include <QMessageBox>
+#include <QFileDialog>
 #include "TableDelegates.h"
 
 using namespace SigDigger;
@@ -84,6 +86,12 @@ BackgroundTasksDialog::connectAll(void)
         this,
         SLOT(onCancelAll(void)));
 
+  connect(
+        this->ui->exportHistoryButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onExportHistory(void)));
+
   connect(
         this->ui->buttonBox,
         SIGNAL(rejected()),
@@ -107,11 +115,11 @@ BackgroundTasksDialog::setController(Suscan::MultitaskController *controller)
   this->ui->tableView->setSortingEnabled(false);
 
   this->ui->tableView->setItemDelegateForColumn(
-        4,
+        5,
         new ProgressBarDelegate(this));
 
   this->ui->tableView->setItemDelegateForColumn(
-        5,
+        6,
         delegate);
 
   connect(
@@ -120,6 +128,11 @@ BackgroundTasksDialog::setController(Suscan::MultitaskController *controller)
         this,
         SLOT(onError(QString, QString)));
 
+  connect(
+        this->model,
+        SIGNAL(historyChanged(void)),
+        this,
+        SLOT(onHistoryChanged(void)));
 
   connect(
         this->model,
@@ -144,6 +157,22 @@ BackgroundTasksDialog::setController(Suscan::MultitaskController *controller)
         SLOT(onCancelClicked(QModelIndex)));
 }
 
+void
+BackgroundTasksDialog::refreshSummary(void)
+{
+  int running = this->controller->runningCount();
+  int queued  = this->controller->queuedCount();
+
+  if (running == 0 && queued == 0)
+    this->ui->summaryLabel->setText("No tasks");
+  else
+    this->ui->summaryLabel->setText(
+          QString::number(running)
+          + " running, "
+          + QString::number(queued)
+          + " queued");
+}
+
 /////////////////////////////////// Slots //////////////////////////////////////
 void
 BackgroundTasksDialog::onClose(void)
@@ -172,6 +201,7 @@ BackgroundTasksDialog::onLayoutChanged(void)
 
   this->ui->tableView->setColumnWidth(3, 120);
   this->ui->cancelAllButton->setEnabled(rows > 0);
+  this->refreshSummary();
 }
 
 void
@@ -180,6 +210,38 @@ BackgroundTasksDialog::onCancelClicked(QModelIndex index)
   this->controller->cancelByIndex(index.row());
 }
 
+void
+BackgroundTasksDialog::onHistoryChanged(void)
+{
+  this->ui->exportHistoryButton->setEnabled(
+        !this->model->getHistory().isEmpty());
+}
+
+void
+BackgroundTasksDialog::onExportHistory(void)
+{
+  QFileDialog dialog(this);
+
+  dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+  dialog.setAcceptMode(QFileDialog::AcceptSave);
+  dialog.setWindowTitle(QString("Export task history"));
+  dialog.setNameFilters(
+        QStringList()
+        << "Comma-separated values (*.csv)"
+        << "JSON files (*.json)");
+
+  if (dialog.exec()) {
+    QString path = dialog.selectedFiles().first();
+
+    if (!this->model->saveHistory(path.toStdString()))
+      QMessageBox::critical(
+            this,
+            "Export task history",
+            "Failed to save task history to " + path,
+            QMessageBox::Ok);
+  }
+}
+
 void
 BackgroundTasksDialog::onError(QString title, QString err)
 {
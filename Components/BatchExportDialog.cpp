@@ -0,0 +1,353 @@
+//
+//    BatchExportDialog.cpp: Export many selections at once
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <BatchExportDialog.h>
+#include "ui_BatchExportDialog.h"
+
+#include <SigDiggerHelpers.h>
+#include <SuWidgetsHelpers.h>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QPushButton>
+#include <set>
+
+using namespace SigDigger;
+
+BatchExportDialog::BatchExportDialog(QWidget *parent) :
+  QDialog(parent),
+  ui(new Ui::BatchExportDialog)
+{
+  ui->setupUi(this);
+
+  this->ui->formatCombo->addItems(SigDiggerHelpers::sampleFileFilters());
+  this->ui->directoryEdit->setText(QDir::homePath());
+  this->ui->buttonBox->button(QDialogButtonBox::Ok)->setText("&Export");
+
+  this->connectAll();
+  this->refreshUi();
+}
+
+BatchExportDialog::~BatchExportDialog()
+{
+  delete ui;
+}
+
+void
+BatchExportDialog::connectAll(void)
+{
+  connect(
+        this->ui->removeButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onRemove(void)));
+
+  connect(
+        this->ui->clearButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onClear(void)));
+
+  connect(
+        this->ui->browseButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onBrowse(void)));
+
+  connect(
+        this->ui->patternEdit,
+        SIGNAL(textChanged(QString)),
+        this,
+        SLOT(onPatternChanged(void)));
+
+  connect(
+        this->ui->formatCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onPatternChanged(void)));
+
+  connect(
+        this->ui->buttonBox,
+        SIGNAL(accepted()),
+        this,
+        SLOT(onAccept(void)));
+
+  connect(
+        this->ui->buttonBox,
+        SIGNAL(rejected()),
+        this,
+        SLOT(hide()));
+}
+
+QString
+BatchExportDialog::expandPattern(
+    QString const &pattern,
+    size_t index,
+    size_t count,
+    int start,
+    qreal fs)
+{
+  QString result;
+  int width = QString::number(count).size();
+
+  for (int i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%' || i + 1 == pattern.size()) {
+      result += pattern[i];
+      continue;
+    }
+
+    switch (pattern[++i].toLatin1()) {
+      case 'n':
+        result += QString("%1").arg(index + 1, width, 10, QChar('0'));
+        break;
+
+      case 's':
+        result += QString::number(start);
+        break;
+
+      case 't':
+        result += QString::number(start / fs, 'f', 6);
+        break;
+
+      case '%':
+        result += '%';
+        break;
+
+      default:
+        result += '%';
+        result += pattern[i];
+    }
+  }
+
+  return result;
+}
+
+QString
+BatchExportDialog::getExtension(void) const
+{
+  return SigDiggerHelpers::sampleFileExtension(
+        this->ui->formatCombo->currentText());
+}
+
+QString
+BatchExportDialog::getFormat(void) const
+{
+  return SigDiggerHelpers::sampleFileFormat(
+        this->ui->formatCombo->currentText());
+}
+
+QString
+BatchExportDialog::getFileName(size_t index) const
+{
+  return expandPattern(
+        this->ui->patternEdit->text(),
+        index,
+        this->selections.size(),
+        this->selections[index].first,
+        this->fs)
+      + "."
+      + this->getExtension();
+}
+
+void
+BatchExportDialog::refreshUi(void)
+{
+  int count = static_cast<int>(this->selections.size());
+
+  this->ui->selectionTable->setRowCount(count);
+
+  for (int i = 0; i < count; ++i) {
+    auto const &sel = this->selections[static_cast<size_t>(i)];
+
+    this->ui->selectionTable->setItem(
+          i,
+          0,
+          new QTableWidgetItem(QString::number(i + 1)));
+    this->ui->selectionTable->setItem(
+          i,
+          1,
+          new QTableWidgetItem(
+            SuWidgetsHelpers::formatQuantity(sel.first / this->fs, "s")));
+    this->ui->selectionTable->setItem(
+          i,
+          2,
+          new QTableWidgetItem(
+            SuWidgetsHelpers::formatQuantity(
+              (sel.second - sel.first) / this->fs,
+              "s")));
+    this->ui->selectionTable->setItem(
+          i,
+          3,
+          new QTableWidgetItem(this->getFileName(static_cast<size_t>(i))));
+  }
+
+  this->ui->selectionTable->resizeColumnsToContents();
+
+  if (count == 0)
+    this->ui->summaryLabel->setText("No selections marked");
+  else
+    this->ui->summaryLabel->setText(
+          QString::number(count)
+          + (count == 1 ? " selection" : " selections")
+          + " marked");
+
+  this->ui->removeButton->setEnabled(count > 0);
+  this->ui->clearButton->setEnabled(count > 0);
+  this->ui->buttonBox->button(QDialogButtonBox::Ok)->setEnabled(count > 0);
+}
+
+void
+BatchExportDialog::setSampleRate(qreal fs)
+{
+  this->fs = fs;
+  this->refreshUi();
+}
+
+void
+BatchExportDialog::addSelection(int start, int end)
+{
+  if (end > start) {
+    this->selections.push_back(std::make_pair(start, end));
+    this->refreshUi();
+    emit selectionsChanged();
+  }
+}
+
+void
+BatchExportDialog::clear(void)
+{
+  if (!this->selections.empty()) {
+    this->selections.clear();
+    this->refreshUi();
+    emit selectionsChanged();
+  }
+}
+
+size_t
+BatchExportDialog::getSelectionCount(void) const
+{
+  return this->selections.size();
+}
+
+std::vector<BatchExportItem>
+BatchExportDialog::makeItems(void) const
+{
+  std::vector<BatchExportItem> items;
+  QDir dir(this->ui->directoryEdit->text());
+
+  for (size_t i = 0; i < this->selections.size(); ++i) {
+    BatchExportItem item;
+
+    item.path  = dir.filePath(this->getFileName(i));
+    item.start = this->selections[i].first;
+    item.end   = this->selections[i].second;
+
+    items.push_back(item);
+  }
+
+  return items;
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+BatchExportDialog::onRemove(void)
+{
+  std::set<int> rows;
+
+  for (auto index : this->ui->selectionTable->selectionModel()->selectedRows())
+    rows.insert(index.row());
+
+  // Back to front, so that indices remain valid
+  for (auto p = rows.rbegin(); p != rows.rend(); ++p)
+    this->selections.erase(this->selections.begin() + *p);
+
+  if (!rows.empty()) {
+    this->refreshUi();
+    emit selectionsChanged();
+  }
+}
+
+void
+BatchExportDialog::onClear(void)
+{
+  this->clear();
+}
+
+void
+BatchExportDialog::onBrowse(void)
+{
+  QString dir = QFileDialog::getExistingDirectory(
+        this,
+        "Save selections to",
+        this->ui->directoryEdit->text());
+
+  if (!dir.isEmpty())
+    this->ui->directoryEdit->setText(dir);
+}
+
+void
+BatchExportDialog::onPatternChanged(void)
+{
+  this->refreshUi();
+}
+
+void
+BatchExportDialog::onAccept(void)
+{
+  std::vector<BatchExportItem> items = this->makeItems();
+  std::set<QString> names;
+  int existing = 0;
+
+  if (!QFileInfo(this->ui->directoryEdit->text()).isDir()) {
+    QMessageBox::critical(
+          this,
+          "Batch export",
+          "The directory "
+          + this->ui->directoryEdit->text()
+          + " does not exist");
+    return;
+  }
+
+  for (auto const &item : items) {
+    if (!names.insert(item.path).second) {
+      QMessageBox::critical(
+            this,
+            "Batch export",
+            "The file name pattern gives the same name to different "
+            "selections. Please include %n in it.");
+      return;
+    }
+
+    if (QFileInfo(item.path).exists())
+      ++existing;
+  }
+
+  if (existing > 0
+      && QMessageBox::question(
+        this,
+        "Batch export",
+        QString::number(existing)
+        + " of the files already exist. Overwrite them?",
+        QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
+    return;
+
+  emit exportRequested();
+  this->hide();
+}
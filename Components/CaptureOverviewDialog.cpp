@@ -0,0 +1,329 @@
+//
+//    CaptureOverviewDialog.cpp: Browse huge capture files
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <CaptureOverviewDialog.h>
+#include "ui_CaptureOverviewDialog.h"
+
+#include <CaptureOverviewView.h>
+#include <CaptureIndexer.h>
+#include <TimeWindow.h>
+#include <Suscan/Library.h>
+#include <Suscan/MultitaskController.h>
+#include <SuWidgetsHelpers.h>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QRegularExpression>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+using namespace SigDigger;
+
+CaptureOverviewDialog::CaptureOverviewDialog(QWidget *parent) :
+  QDialog(parent),
+  ui(new Ui::CaptureOverviewDialog)
+{
+  ui->setupUi(this);
+
+  this->view = new CaptureOverviewView(this);
+  this->ui->overviewGrid->addWidget(this->view, 0, 0);
+
+  this->timeWindow = new TimeWindow(this);
+
+  this->connectAll();
+  this->refreshUi();
+}
+
+CaptureOverviewDialog::~CaptureOverviewDialog()
+{
+  delete ui;
+}
+
+void
+CaptureOverviewDialog::connectAll(void)
+{
+  connect(
+        this->ui->openButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onOpenCapture(void)));
+
+  connect(
+        this->ui->openRegionButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onOpenRegion(void)));
+
+  connect(
+        this->view,
+        SIGNAL(selectionChanged(qreal, qreal)),
+        this,
+        SLOT(onSelectionChanged(qreal, qreal)));
+
+  connect(
+        this->view,
+        SIGNAL(regionActivated(qreal, qreal)),
+        this,
+        SLOT(onOpenRegion(void)));
+
+  connect(
+        this->ui->buttonBox,
+        SIGNAL(rejected()),
+        this,
+        SLOT(hide()));
+}
+
+void
+CaptureOverviewDialog::parseFileName(void)
+{
+  // Recordings are named sigdigger_<date>_<time>_<rate>_<freq>_float32_iq
+  QRegularExpression re("_(\\d+)_(\\d+)_float32_iq");
+  QRegularExpressionMatch match =
+      re.match(QFileInfo(QString::fromStdString(this->path)).fileName());
+
+  if (match.hasMatch()) {
+    this->ui->sampleRateSpin->setValue(match.captured(1).toInt());
+    this->ui->frequencySpin->setValue(match.captured(2).toDouble());
+  }
+}
+
+void
+CaptureOverviewDialog::refreshUi(void)
+{
+  bool haveFile = !this->path.empty();
+  bool haveSelection =
+      this->view->hasOverview()
+      && this->view->getSelectionEnd() > this->view->getSelectionStart();
+  qreal fs = this->ui->sampleRateSpin->value();
+
+  this->ui->openRegionButton->setEnabled(haveSelection);
+
+  if (!haveFile) {
+    this->ui->fileLabel->setText("No capture file opened");
+  } else {
+    QString text = QFileInfo(QString::fromStdString(this->path)).fileName();
+
+    if (this->samples > 0 && fs > 0)
+      text += " ("
+          + SuWidgetsHelpers::formatQuantity(this->samples / fs, "s")
+          + ")";
+
+    this->ui->fileLabel->setText(text);
+  }
+
+  if (haveSelection && fs > 0) {
+    qreal t0 = this->view->getSelectionStart() * this->samples / fs;
+    qreal t1 = this->view->getSelectionEnd() * this->samples / fs;
+
+    this->ui->selectionLabel->setText(
+          "Selection: "
+          + SuWidgetsHelpers::formatQuantity(t0, "s")
+          + " to "
+          + SuWidgetsHelpers::formatQuantity(t1, "s"));
+  } else if (!this->indexing.empty() && this->indexing == this->path) {
+    this->ui->selectionLabel->setText(
+          "Building overview in the background. Check Background tasks for "
+          "progress.");
+  } else if (this->view->hasOverview()) {
+    this->ui->selectionLabel->setText(
+          "Drag over the overview to select a region, or double click on it "
+          "to open it.");
+  } else {
+    this->ui->selectionLabel->setText("");
+  }
+}
+
+void
+CaptureOverviewDialog::openCapture(QString const &path)
+{
+  CaptureOverview overview;
+
+  this->path = path.toStdString();
+  this->samples = 0;
+  this->view->clear();
+  this->parseFileName();
+
+  if (overview.load(this->path)) {
+    this->samples = overview.samples;
+    this->view->setOverview(overview);
+  } else if (this->indexing.empty()) {
+    CaptureIndexer *task = new CaptureIndexer(this->path);
+
+    connect(
+          task,
+          SIGNAL(done(void)),
+          this,
+          SLOT(onIndexDone(void)));
+
+    connect(
+          task,
+          SIGNAL(error(QString)),
+          this,
+          SLOT(onIndexError(QString)));
+
+    connect(
+          task,
+          SIGNAL(cancelled(void)),
+          this,
+          SLOT(onIndexCancelled(void)));
+
+    this->indexing = this->path;
+
+    Suscan::Singleton::get_instance()->getBackgroundTaskController()->pushTask(
+          task,
+          "Build overview of " + QFileInfo(path).fileName(),
+          Suscan::TaskPriority::INTERACTIVE);
+  } else {
+    QMessageBox::warning(
+          this,
+          "Capture overview",
+          "Another capture file is being indexed. Please wait until it "
+          "finishes and try again.");
+  }
+
+  this->refreshUi();
+}
+
+bool
+CaptureOverviewDialog::loadRegion(quint64 start, quint64 len)
+{
+  std::vector<SUCOMPLEX> region;
+  FILE *fp;
+  bool ok = false;
+
+  if ((fp = fopen(this->path.c_str(), "rb")) == nullptr)
+    return false;
+
+  region.resize(len);
+
+  if (fseeko(fp, static_cast<off_t>(start * sizeof(SUCOMPLEX)), SEEK_SET) == 0)
+    ok = fread(region.data(), sizeof(SUCOMPLEX), len, fp) == len;
+
+  fclose(fp);
+
+  if (ok) {
+    this->timeWindow->setData(
+          std::make_shared<std::vector<SUCOMPLEX>>(std::move(region)),
+          this->ui->sampleRateSpin->value());
+    this->timeWindow->setCenterFreq(this->ui->frequencySpin->value());
+    this->timeWindow->show();
+    this->timeWindow->raise();
+    this->timeWindow->activateWindow();
+    this->timeWindow->setWindowState(Qt::WindowState::WindowActive);
+    this->timeWindow->onFit();
+  }
+
+  return ok;
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+CaptureOverviewDialog::onOpenCapture(void)
+{
+  QString path = QFileDialog::getOpenFileName(
+        this,
+        "Open capture file",
+        QString(),
+        "Raw I/Q captures (*.raw *.cf32 *_float32_iq);;All files (*)");
+
+  if (!path.isEmpty())
+    this->openCapture(path);
+}
+
+void
+CaptureOverviewDialog::onIndexDone(void)
+{
+  CaptureOverview overview;
+  bool current = this->indexing == this->path;
+
+  this->indexing.clear();
+
+  // The user may have moved on to another file in the meantime
+  if (current) {
+    if (overview.load(this->path)) {
+      this->samples = overview.samples;
+      this->view->setOverview(overview);
+    } else {
+      QMessageBox::critical(
+            this,
+            "Capture overview",
+            "The capture file changed while it was being indexed.");
+    }
+  }
+
+  this->refreshUi();
+}
+
+void
+CaptureOverviewDialog::onIndexError(QString message)
+{
+  bool current = this->indexing == this->path;
+
+  this->indexing.clear();
+
+  if (current && !message.isEmpty())
+    QMessageBox::critical(this, "Capture overview", message);
+
+  this->refreshUi();
+}
+
+void
+CaptureOverviewDialog::onIndexCancelled(void)
+{
+  this->onIndexError(QString());
+}
+
+void
+CaptureOverviewDialog::onSelectionChanged(qreal, qreal)
+{
+  this->refreshUi();
+}
+
+void
+CaptureOverviewDialog::onOpenRegion(void)
+{
+  quint64 start = static_cast<quint64>(
+        this->view->getSelectionStart() * this->samples);
+  quint64 end = static_cast<quint64>(
+        this->view->getSelectionEnd() * this->samples);
+
+  if (end <= start)
+    return;
+
+  if (end - start > SIGDIGGER_CAPTURE_OVERVIEW_MAX_REGION) {
+    QMessageBox::warning(
+          this,
+          "Capture overview",
+          "Selection is too big to be loaded at once. Only the first "
+          + SuWidgetsHelpers::formatBinaryQuantity(
+            SIGDIGGER_CAPTURE_OVERVIEW_MAX_REGION * sizeof(SUCOMPLEX))
+          + " will be opened.");
+    end = start + SIGDIGGER_CAPTURE_OVERVIEW_MAX_REGION;
+  }
+
+  if (!this->loadRegion(start, end - start))
+    QMessageBox::critical(
+          this,
+          "Capture overview",
+          "Cannot read the selected region from "
+          + QString::fromStdString(this->path)
+          + ": "
+          + QString(strerror(errno)));
+}
@@ -0,0 +1,231 @@
+//
+//    CaptureOverviewView.cpp: Spectrogram and envelope of a capture file
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <CaptureOverviewView.h>
+#include <SigDiggerHelpers.h>
+#include <QPainter>
+#include <QMouseEvent>
+#include <algorithm>
+
+using namespace SigDigger;
+
+CaptureOverviewView::CaptureOverviewView(QWidget *parent) : QWidget(parent)
+{
+  this->setMinimumSize(
+        320,
+        3 * SIGDIGGER_CAPTURE_OVERVIEW_ENVELOPE_HEIGHT);
+  this->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void
+CaptureOverviewView::renderImage(void)
+{
+  const Palette *palette = SigDiggerHelpers::instance()->getPalette("Suscan");
+  const CaptureOverview &ov = this->overview;
+  std::vector<SUFLOAT> sorted = ov.spectrogram;
+  SUFLOAT floor, ceil, range;
+  unsigned int row, bin;
+
+  // Percentiles, so a few strong bins do not wash out the rest
+  std::sort(sorted.begin(), sorted.end());
+  floor = sorted[sorted.size() / 20];
+  ceil  = sorted[sorted.size() - 1 - sorted.size() / 1000];
+  range = ceil > floor ? ceil - floor : 1;
+
+  this->image = QImage(
+        static_cast<int>(ov.rows),
+        static_cast<int>(ov.bins),
+        QImage::Format_RGB32);
+
+  for (row = 0; row < ov.rows; ++row) {
+    const SUFLOAT *spectrum = ov.spectrogram.data() + row * ov.bins;
+
+    for (bin = 0; bin < ov.bins; ++bin) {
+      int index = static_cast<int>(255 * (spectrum[bin] - floor) / range);
+      int y = static_cast<int>(ov.bins - 1 - bin);
+
+      index = qBound(0, index, 255);
+
+      this->image.setPixel(
+            static_cast<int>(row),
+            y,
+            palette != nullptr
+            ? palette->getGradient()[index].rgb()
+            : qRgb(index, index, index));
+    }
+  }
+
+  auto minmax = std::minmax_element(ov.envelope.begin(), ov.envelope.end());
+  this->envMin = *minmax.first;
+  this->envMax = *minmax.second;
+}
+
+qreal
+CaptureOverviewView::xToTime(int x) const
+{
+  return qBound(0., static_cast<qreal>(x) / this->width(), 1.);
+}
+
+int
+CaptureOverviewView::timeToX(qreal t) const
+{
+  return static_cast<int>(t * this->width());
+}
+
+void
+CaptureOverviewView::setOverview(CaptureOverview const &overview)
+{
+  this->overview = overview;
+  this->selStart = this->selEnd = 0;
+  this->renderImage();
+  this->update();
+}
+
+void
+CaptureOverviewView::clear(void)
+{
+  this->overview = CaptureOverview();
+  this->image = QImage();
+  this->selStart = this->selEnd = 0;
+  this->update();
+}
+
+bool
+CaptureOverviewView::hasOverview(void) const
+{
+  return this->overview.rows > 0;
+}
+
+qreal
+CaptureOverviewView::getSelectionStart(void) const
+{
+  return qMin(this->selStart, this->selEnd);
+}
+
+qreal
+CaptureOverviewView::getSelectionEnd(void) const
+{
+  return qMax(this->selStart, this->selEnd);
+}
+
+void
+CaptureOverviewView::paintEvent(QPaintEvent *)
+{
+  QPainter p(this);
+  int envHeight = SIGDIGGER_CAPTURE_OVERVIEW_ENVELOPE_HEIGHT;
+  int specHeight = this->height() - envHeight;
+  const CaptureOverview &ov = this->overview;
+
+  p.fillRect(this->rect(), Qt::black);
+
+  if (!this->hasOverview()) {
+    p.setPen(Qt::gray);
+    p.drawText(this->rect(), Qt::AlignCenter, "No overview available");
+    return;
+  }
+
+  p.drawImage(QRect(0, 0, this->width(), specHeight), this->image);
+
+  // Power envelope, one point per envelope sample
+  if (ov.envelope.size() > 1) {
+    QPolygonF poly;
+    SUFLOAT range = this->envMax > this->envMin
+        ? this->envMax - this->envMin
+        : 1;
+    size_t i, n = ov.envelope.size();
+
+    poly.reserve(static_cast<int>(n));
+    for (i = 0; i < n; ++i)
+      poly.append(
+            QPointF(
+              static_cast<qreal>(i) * this->width() / (n - 1),
+              this->height() - 2
+              - (envHeight - 4) * (ov.envelope[i] - this->envMin) / range));
+
+    p.setPen(QColor(0, 0xff, 0));
+    p.drawPolyline(poly);
+  }
+
+  p.setPen(Qt::darkGray);
+  p.drawLine(0, specHeight, this->width(), specHeight);
+
+  // Selection
+  if (this->getSelectionEnd() > this->getSelectionStart()) {
+    int x0 = this->timeToX(this->getSelectionStart());
+    int x1 = this->timeToX(this->getSelectionEnd());
+
+    p.fillRect(
+          QRect(x0, 0, qMax(x1 - x0, 1), this->height()),
+          QColor(0xff, 0xff, 0xff, 0x40));
+    p.setPen(Qt::white);
+    p.drawLine(x0, 0, x0, this->height());
+    p.drawLine(x1, 0, x1, this->height());
+  }
+}
+
+void
+CaptureOverviewView::mousePressEvent(QMouseEvent *event)
+{
+  if (this->hasOverview() && event->button() == Qt::LeftButton) {
+    this->selecting = true;
+    this->selStart = this->selEnd = this->xToTime(event->x());
+    this->update();
+  }
+}
+
+void
+CaptureOverviewView::mouseMoveEvent(QMouseEvent *event)
+{
+  if (this->selecting) {
+    this->selEnd = this->xToTime(event->x());
+    this->update();
+  }
+}
+
+void
+CaptureOverviewView::mouseReleaseEvent(QMouseEvent *event)
+{
+  if (this->selecting && event->button() == Qt::LeftButton) {
+    this->selecting = false;
+    this->selEnd = this->xToTime(event->x());
+    this->update();
+
+    emit selectionChanged(this->getSelectionStart(), this->getSelectionEnd());
+  }
+}
+
+void
+CaptureOverviewView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+  qreal t, half;
+
+  if (!this->hasOverview() || event->button() != Qt::LeftButton)
+    return;
+
+  // The first click already cleared the selection: open the row under
+  // the cursor
+  t = this->xToTime(event->x());
+  half = .5 / this->overview.rows;
+  this->selStart = qMax(0., t - half);
+  this->selEnd   = qMin(1., t + half);
+  this->update();
+
+  emit selectionChanged(this->getSelectionStart(), this->getSelectionEnd());
+  emit regionActivated(this->getSelectionStart(), this->getSelectionEnd());
+}
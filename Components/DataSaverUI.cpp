@@ -33,6 +33,13 @@ void
 DataSaverConfig::deserialize(Suscan::Object const &conf)
 {
   LOAD(path);
+  LOAD(splitSize);
+  LOAD(splitTime);
+  LOAD(quota);
+  LOAD(preRoll);
+  LOAD(sync);
+  LOAD(format);
+  LOAD(subband);
 }
 
 Suscan::Object &&
@@ -43,11 +50,44 @@ DataSaverConfig::serialize(void)
   obj.setClass("DataSaverConfig");
 
   STORE(path);
+  STORE(splitSize);
+  STORE(splitTime);
+  STORE(quota);
+  STORE(preRoll);
+  STORE(sync);
+  STORE(format);
+  STORE(subband);
 
   return this->persist(obj);
 }
 
 ////////////////////////////// DataSaverUI /////////////////////////////////////
+RealSampleFormat
+DataSaverUI::strToFormat(std::string const &str)
+{
+  if (str == "float")
+    return REAL_SAMPLE_FORMAT_FLOAT32;
+  else if (str == "int16")
+    return REAL_SAMPLE_FORMAT_INT16;
+
+  return REAL_SAMPLE_FORMAT_COMPLEX;
+}
+
+std::string
+DataSaverUI::formatToStr(RealSampleFormat format)
+{
+  switch (format) {
+    case REAL_SAMPLE_FORMAT_COMPLEX:
+      return "complex";
+
+    case REAL_SAMPLE_FORMAT_INT16:
+      return "int16";
+
+    default:
+      return "float";
+  }
+}
+
 void
 DataSaverUI::connectAll(void)
 {
@@ -62,6 +102,54 @@ DataSaverUI::connectAll(void)
         SIGNAL(clicked(bool)),
         this,
         SLOT(onRecordStartStop(void)));
+
+  connect(
+        this->ui->splitSizeSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onSegmentationChanged(void)));
+
+  connect(
+        this->ui->splitTimeSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onSegmentationChanged(void)));
+
+  connect(
+        this->ui->quotaSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onSegmentationChanged(void)));
+
+  connect(
+        this->ui->preRollSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onPreRollChanged(void)));
+
+  connect(
+        this->ui->syncSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onSyncChanged(void)));
+
+  connect(
+        this->ui->formatCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onFormatChanged(void)));
+
+  connect(
+        this->ui->subbandCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onSubbandChanged(void)));
+
+  connect(
+        this->ui->statsButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onSaveStats(void)));
 }
 
 // Setters
@@ -117,6 +205,47 @@ DataSaverUI::setRecordState(bool state)
 
   if (!state)
     this->ui->ioBwProgress->setValue(0);
+
+  this->ui->formatCombo->setEnabled(!state);
+  this->ui->subbandCheck->setEnabled(!state);
+  this->ui->syncSpin->setEnabled(!state);
+}
+
+void
+DataSaverUI::setStats(DataSaverStats const &stats)
+{
+  GenericDataSaverUI::setStats(stats);
+
+  this->ui->ioBwProgress->setToolTip(stats.summary());
+  this->ui->statsButton->setEnabled(true);
+}
+
+void
+DataSaverUI::setPreRollVisible(bool visible)
+{
+  this->ui->preRollLabel->setVisible(visible);
+  this->ui->preRollSpin->setVisible(visible);
+}
+
+// Only inspectors record real-valued samples
+void
+DataSaverUI::setFormatVisible(bool visible)
+{
+  this->ui->formatLabel->setVisible(visible);
+  this->ui->formatCombo->setVisible(visible);
+}
+
+void
+DataSaverUI::setSubbandVisible(bool visible)
+{
+  this->ui->subbandCheck->setVisible(visible);
+}
+
+void
+DataSaverUI::setRealFormat(RealSampleFormat format)
+{
+  this->config->format = formatToStr(format);
+  this->ui->formatCombo->setCurrentIndex(static_cast<int>(format));
 }
 
 // Getters
@@ -132,6 +261,49 @@ DataSaverUI::getRecordSavePath(void) const
   return this->ui->savePath->text().toStdString();
 }
 
+quint64
+DataSaverUI::getSegmentSize(void) const
+{
+  return static_cast<quint64>(this->ui->splitSizeSpin->value()) << 20;
+}
+
+quint64
+DataSaverUI::getSegmentDuration(void) const
+{
+  return static_cast<quint64>(this->ui->splitTimeSpin->value());
+}
+
+quint64
+DataSaverUI::getQuota(void) const
+{
+  return static_cast<quint64>(this->ui->quotaSpin->value()) << 20;
+}
+
+unsigned int
+DataSaverUI::getPreRoll(void) const
+{
+  return static_cast<unsigned int>(this->ui->preRollSpin->value());
+}
+
+// Milliseconds, as GenericDataSaver::setSyncInterval takes them
+unsigned int
+DataSaverUI::getSyncInterval(void) const
+{
+  return static_cast<unsigned int>(this->ui->syncSpin->value()) * 1000;
+}
+
+RealSampleFormat
+DataSaverUI::getRealFormat(void) const
+{
+  return static_cast<RealSampleFormat>(this->ui->formatCombo->currentIndex());
+}
+
+bool
+DataSaverUI::getSubband(void) const
+{
+  return this->ui->subbandCheck->isChecked();
+}
+
 
 DataSaverUI::DataSaverUI(QWidget *parent) :
   GenericDataSaverUI(parent),
@@ -139,7 +311,11 @@ DataSaverUI::DataSaverUI(QWidget *parent) :
 {
   ui->setupUi(this);
 
+  // Inspectors do not load a persisted config, but the slots need one
+  this->assertConfig();
+
   this->setRecordSavePath(QDir::currentPath().toStdString());
+  this->setFormatVisible(false);
 
   this->connectAll();
 }
@@ -160,8 +336,23 @@ DataSaverUI::allocConfig(void)
 void
 DataSaverUI::applyConfig(void)
 {
+  // Setting one spin box updates the whole config: keep a copy.
+  unsigned int splitSize = this->config->splitSize;
+  unsigned int splitTime = this->config->splitTime;
+  unsigned int quota     = this->config->quota;
+
   if (this->config->path.size() > 0)
     this->setRecordSavePath(this->config->path);
+
+  this->ui->splitSizeSpin->setValue(static_cast<int>(splitSize));
+  this->ui->splitTimeSpin->setValue(static_cast<int>(splitTime));
+  this->ui->quotaSpin->setValue(static_cast<int>(quota));
+  this->ui->preRollSpin->setValue(static_cast<int>(this->config->preRoll));
+  this->ui->syncSpin->setValue(static_cast<int>(this->config->sync));
+  this->setRealFormat(strToFormat(this->config->format));
+  this->ui->subbandCheck->setChecked(this->config->subband);
+
+  this->onSegmentationChanged();
 }
 
 ///////////////////////////////// Slots ////////////////////////////////////////
@@ -193,3 +384,45 @@ DataSaverUI::onRecordStartStop(void)
 
   emit recordStateChanged(this->ui->recordStartStopButton->isChecked());
 }
+
+void
+DataSaverUI::onSegmentationChanged(void)
+{
+  this->config->splitSize =
+      static_cast<unsigned int>(this->ui->splitSizeSpin->value());
+  this->config->splitTime =
+      static_cast<unsigned int>(this->ui->splitTimeSpin->value());
+  this->config->quota =
+      static_cast<unsigned int>(this->ui->quotaSpin->value());
+
+  // Retention only makes sense for split recordings
+  this->ui->quotaSpin->setEnabled(
+        this->config->splitSize > 0 || this->config->splitTime > 0);
+}
+
+void
+DataSaverUI::onPreRollChanged(void)
+{
+  this->config->preRoll =
+      static_cast<unsigned int>(this->ui->preRollSpin->value());
+
+  emit preRollChanged();
+}
+
+void
+DataSaverUI::onSyncChanged(void)
+{
+  this->config->sync = static_cast<unsigned int>(this->ui->syncSpin->value());
+}
+
+void
+DataSaverUI::onFormatChanged(void)
+{
+  this->setRealFormat(this->getRealFormat());
+}
+
+void
+DataSaverUI::onSubbandChanged(void)
+{
+  this->config->subband = this->ui->subbandCheck->isChecked();
+}
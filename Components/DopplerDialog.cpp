@@ -18,6 +18,7 @@
 //
 #include "DopplerDialog.h"
 #include "ui_DopplerDialog.h"
+#include <DopplerTracker.h>
 #include <SuWidgetsHelpers.h>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -52,6 +53,12 @@ DopplerDialog::connectAll(void)
         SIGNAL(clicked(void)),
         this,
         SLOT(onZoomReset(void)));
+
+  connect(
+        this->ui->smoothingSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onSmoothingChanged(void)));
 }
 
 bool
@@ -77,12 +84,33 @@ DopplerDialog::exportToMatlab(QString const &path)
   of << "deltaV = " << 1 / this->fs << ";\n";
   of << "v = [ ";
 
-  for (int i = 0; i <= length; ++i)
+  for (int i = 0; i < length; ++i)
     of << SU_C_REAL(data[i]) << ", ";
 
   of << "];\n";
 
-  return true;
+  if (!this->trackVelocity.empty()) {
+    of << "\n% Velocity over time, one frame every 1 / frameRate seconds\n";
+    of << "frameRate = " << this->trackRate << ";\n";
+    of << "t0 = " << this->trackOffset << ";\n";
+
+    of << "vTrack = [ ";
+    for (auto v : this->trackVelocity)
+      of << v << ", ";
+    of << "];\n";
+
+    of << "vTrackSmooth = [ ";
+    for (auto &v : this->trackData)
+      of << SU_C_REAL(v) << ", ";
+    of << "];\n";
+
+    of << "sigmaVTrack = [ ";
+    for (auto v : this->trackSigma)
+      of << v << ", ";
+    of << "];\n";
+  }
+
+  return of.good();
 }
 
 
@@ -141,6 +169,11 @@ DopplerDialog::setColorConfig(ColorConfig const &cfg)
   this->ui->waveform->setBackgroundColor(cfg.spectrumBackground);
   this->ui->waveform->setTextColor(cfg.spectrumText);
   this->ui->waveform->setAxesColor(cfg.spectrumAxes);
+
+  this->ui->trackWaveform->setForegroundColor(cfg.spectrumForeground);
+  this->ui->trackWaveform->setBackgroundColor(cfg.spectrumBackground);
+  this->ui->trackWaveform->setTextColor(cfg.spectrumText);
+  this->ui->trackWaveform->setAxesColor(cfg.spectrumAxes);
 }
 
 void
@@ -152,6 +185,12 @@ DopplerDialog::zoomReset(void)
 
   this->ui->waveform->zoomHorizontalReset();
   this->ui->waveform->invalidate();
+
+  if (!this->trackData.empty()) {
+    this->ui->trackWaveform->fitToEnvelope();
+    this->ui->trackWaveform->zoomHorizontalReset();
+    this->ui->trackWaveform->invalidate();
+  }
 }
 
 void
@@ -168,6 +207,60 @@ DopplerDialog::giveSpectrum(std::vector<SUCOMPLEX> &&data)
   this->ui->waveform->setRealComponent(true);
   this->ui->waveform->setOriginX(-static_cast<qint64>(this->data.size()) / 2.);
   this->ui->waveform->setSampleRate(this->fs);
+
+  // The velocity over time of the previous selection no longer applies
+  this->trackVelocity.clear();
+  this->trackSigma.clear();
+  this->trackEnergy.clear();
+  this->trackData.clear();
+  this->ui->trackWaveform->setData(&this->trackData);
+}
+
+void
+DopplerDialog::refreshTrack(void)
+{
+  std::vector<SUFLOAT> smoothed;
+  unsigned int frames =
+      static_cast<unsigned int>(this->ui->smoothingSpin->value());
+
+  if (frames > 0)
+    smoothed = DopplerTracker::smooth(
+          this->trackVelocity,
+          this->trackEnergy,
+          frames);
+  else
+    smoothed = this->trackVelocity;
+
+  this->trackData.resize(smoothed.size());
+  for (size_t i = 0; i < smoothed.size(); ++i)
+    this->trackData[i] = smoothed[i];
+
+  this->ui->trackWaveform->setData(&this->trackData);
+  this->ui->trackWaveform->setRealComponent(true);
+  this->ui->trackWaveform->setSampleRate(this->trackRate);
+  this->ui->trackWaveform->setOriginX(this->trackOffset * this->trackRate);
+  this->ui->trackWaveform->refreshData();
+  this->ui->trackWaveform->fitToEnvelope();
+  this->ui->trackWaveform->invalidate();
+}
+
+void
+DopplerDialog::giveTrack(
+    std::vector<SUFLOAT> const &velocity,
+    std::vector<SUFLOAT> const &sigma,
+    std::vector<SUFLOAT> const &energy,
+    qreal frameRate,
+    qreal timeOffset)
+{
+  this->trackVelocity = velocity;
+  this->trackSigma    = sigma;
+  this->trackEnergy   = energy;
+  this->trackRate     = frameRate;
+  this->trackOffset   = timeOffset;
+
+  this->ui->trackWaveform->setVerticalUnits("m/s");
+  this->refreshTrack();
+  this->ui->trackWaveform->zoomHorizontalReset();
 }
 
 DopplerDialog::~DopplerDialog()
@@ -222,3 +315,10 @@ DopplerDialog::onZoomReset(void)
 {
   this->zoomReset();
 }
+
+void
+DopplerDialog::onSmoothingChanged(void)
+{
+  if (!this->trackVelocity.empty())
+    this->refreshTrack();
+}
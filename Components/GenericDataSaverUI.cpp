@@ -18,6 +18,8 @@
 //
 
 #include <GenericDataSaverUI.h>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <sys/statvfs.h>
 #include <cmath>
 
@@ -46,3 +48,41 @@ GenericDataSaverUI::refreshDiskUsage(void)
   else
     this->setDiskUsage(std::nan(""));
 }
+
+void
+GenericDataSaverUI::setStats(DataSaverStats const &stats)
+{
+  this->stats = stats;
+}
+
+void
+GenericDataSaverUI::saveStats(QWidget *parent, DataSaverStats const &stats)
+{
+  QFileDialog dialog(parent);
+
+  dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+  dialog.setAcceptMode(QFileDialog::AcceptSave);
+  dialog.setWindowTitle(QString("Save writer statistics"));
+  dialog.setNameFilters(
+        QStringList()
+        << "Comma-separated values (*.csv)"
+        << "JSON files (*.json)");
+
+  if (dialog.exec()) {
+    QString path = dialog.selectedFiles().first();
+
+    if (!stats.saveToFile(path.toStdString()))
+      QMessageBox::critical(
+            parent,
+            "Save writer statistics",
+            "Failed to save statistics to " + path,
+            QMessageBox::Ok);
+  }
+}
+
+////////////////////////////////// Slots ///////////////////////////////////////
+void
+GenericDataSaverUI::onSaveStats(void)
+{
+  saveStats(this, this->stats);
+}
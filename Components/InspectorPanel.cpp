@@ -21,6 +21,7 @@
 #include "ui_InspectorPanel.h"
 
 #include <SuWidgetsHelpers.h>
+#include <AppConfig.h>
 
 using namespace SigDigger;
 
@@ -261,7 +262,9 @@ InspectorPanel::resetRawInspector(qreal fs)
         SIGDIGGER_DEFAULT_UPDATEUI_PERIOD_MS * 1e-3 * this->timeWindowFs);
   this->maxSamples = this->ui->maxMemSpin->value() * (1 << 20) / sizeof(SUCOMPLEX);
   this->ui->hangTimeSpin->setMinimum(std::ceil(1e3 / fs));
-  this->data.resize(0);
+  this->pending.clear();
+  this->pendingSamples = 0;
+  this->data = std::make_shared<std::vector<SUCOMPLEX>>();
   this->timeWindow->setData(this->data, this->timeWindowFs);
   this->ui->sampleRateLabel->setText(
         SuWidgetsHelpers::formatQuantity(fs, "sp/s"));
@@ -276,33 +279,86 @@ InspectorPanel::refreshCaptureInfo(void)
 {
   this->ui->durationLabel->setText(
         SuWidgetsHelpers::formatQuantityFromDelta(
-          this->data.size() / this->timeWindowFs,
+          this->getCaptureSize() / this->timeWindowFs,
           1 / this->timeWindowFs,
           "s"));
   this->ui->memoryLabel->setText(
         SuWidgetsHelpers::formatBinaryQuantity(
-          static_cast<qint64>(this->data.size() * sizeof(SUCOMPLEX))));
+          static_cast<qint64>(this->getCaptureSize() * sizeof(SUCOMPLEX))));
 }
 
 void
 InspectorPanel::transferHistory(void)
 {
+  std::vector<SUCOMPLEX> samples;
+
+  samples.reserve(this->history.size());
+
   // Insert older samples
-  this->data.insert(
-        this->data.end(),
+  samples.insert(
+        samples.end(),
         this->history.begin() + this->historyPtr,
         this->history.end());
 
   // Insert newer samples
-  this->data.insert(
-        this->data.end(),
+  samples.insert(
+        samples.end(),
         this->history.begin(),
         this->history.begin() + this->historyPtr);
+
+  this->appendCapture(SampleBuffer(std::move(samples)));
+}
+
+void
+InspectorPanel::appendCapture(SampleBuffer const &buffer)
+{
+  this->pending.push_back(buffer);
+  this->pendingSamples += buffer.size();
 }
 
 void
-InspectorPanel::feedRawInspector(const SUCOMPLEX *data, size_t size)
+InspectorPanel::flushCapture(void)
 {
+  std::shared_ptr<std::vector<SUCOMPLEX>> samples;
+
+  if (this->pending.empty())
+    return;
+
+  // The previous capture may be in use by the sample viewer or an export,
+  // so the result goes to a new vector.
+  samples = std::make_shared<std::vector<SUCOMPLEX>>();
+  samples->reserve(this->data->size() + this->pendingSamples);
+  samples->insert(samples->end(), this->data->begin(), this->data->end());
+
+  for (auto &buffer : this->pending)
+    samples->insert(
+          samples->end(),
+          buffer.data(),
+          buffer.data() + buffer.size());
+
+  this->data = samples;
+  this->pending.clear();
+  this->pendingSamples = 0;
+}
+
+size_t
+InspectorPanel::getCaptureSize(void) const
+{
+  return this->data->size() + this->pendingSamples;
+}
+
+void
+InspectorPanel::consume(SampleBuffer const &buffer)
+{
+  this->feedRawInspector(buffer);
+}
+
+void
+InspectorPanel::feedRawInspector(SampleBuffer const &buffer)
+{
+  const SUCOMPLEX *data = buffer.data();
+  size_t size = buffer.size();
+
   this->totalSamples += size;
   bool refreshUi =
       this->totalSamples >= this->uiRefreshSamples;
@@ -312,7 +368,7 @@ InspectorPanel::feedRawInspector(const SUCOMPLEX *data, size_t size)
 
   if (this->ui->captureButton->isDown()) {
     // Manual capture
-    this->data.insert(this->data.end(), data, data + size);
+    this->appendCapture(buffer);
     if (refreshUi)
       this->refreshCaptureInfo();
   } else if (this->autoSquelch) {
@@ -397,15 +453,15 @@ InspectorPanel::feedRawInspector(const SUCOMPLEX *data, size_t size)
 
     // TRIGGERED: Recording the channel
     if (this->autoSquelchTriggered) {
-      this->data.insert(this->data.end(), data, data + size);
+      this->appendCapture(buffer);
       this->refreshCaptureInfo();
-      if (this->data.size() > this->hangLength) {
+      if (this->getCaptureSize() > this->hangLength) {
         if (immLevel >= this->hangLevel)
           this->hangCounter = 0;
         else
           this->hangCounter += size;
 
-        if (this->hangCounter >= this->hangLength || this->data.size() > this->maxSamples) { // Hang!
+        if (this->hangCounter >= this->hangLength || this->getCaptureSize() > this->maxSamples) { // Hang!
           this->cancelAutoSquelch();
           this->openTimeWindow();
         }
@@ -417,6 +473,7 @@ InspectorPanel::feedRawInspector(const SUCOMPLEX *data, size_t size)
 void
 InspectorPanel::openTimeWindow(void)
 {
+  this->flushCapture();
   this->timeWindow->setData(this->data, this->timeWindowFs);
   this->timeWindow->setCenterFreq(this->demodFreq);
   this->timeWindow->show();
@@ -479,10 +536,14 @@ InspectorPanel::InspectorPanel(QWidget *parent) :
   this->setState(DETACHED);
   this->refreshUi();
   this->connectAll();
+
+  SampleBus::getInstance()->subscribe(SIGDIGGER_RAW_INSPECTOR_MAGIC_ID, this);
 }
 
 InspectorPanel::~InspectorPanel()
 {
+  SampleBus::getInstance()->unsubscribe(this);
+
   delete ui;
 }
 
@@ -515,7 +576,7 @@ InspectorPanel::onPressAutoSquelch(void)
     this->ui->autoSquelchButton->setText("Measuring...");
   } else {
     this->cancelAutoSquelch();
-    if (this->data.size() > 0)
+    if (this->getCaptureSize() > 0)
       this->openTimeWindow();
   }
 }
@@ -555,7 +616,7 @@ InspectorPanel::onReleaseHold(void)
 {
   emit stopRawCapture();
 
-  if (this->data.size() > 0)
+  if (this->getCaptureSize() > 0)
     this->openTimeWindow();
 }
 
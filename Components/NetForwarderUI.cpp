@@ -19,6 +19,7 @@
 
 #include "NetForwarderUI.h"
 #include "ui_NetForwarderUI.h"
+#include <GenericDataSaverUI.h>
 
 using namespace SigDigger;
 
@@ -30,6 +31,18 @@ NetForwarderUI::connectAll(void)
         SIGNAL(clicked(bool)),
         this,
         SLOT(onForwardStartStop(void)));
+
+  connect(
+        this->ui->socketTypeCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onSocketTypeChanged(void)));
+
+  connect(
+        this->ui->statsButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onSaveStats(void)));
 }
 
 NetForwarderUI::NetForwarderUI(QWidget *parent) :
@@ -44,6 +57,7 @@ NetForwarderUI::NetForwarderUI(QWidget *parent) :
   this->ui->spinGrid->addWidget(this->spinner);
 
   this->connectAll();
+  this->onSocketTypeChanged();
 }
 
 NetForwarderUI::~NetForwarderUI()
@@ -93,6 +107,10 @@ NetForwarderUI::setForwardState(bool state)
   this->ui->hostEdit->setEnabled(!state);
   this->ui->portSpin->setEnabled(!state);
   this->ui->frameLen->setEnabled(!state);
+  this->ui->socketTypeCombo->setEnabled(!state);
+  this->ui->pacingSpin->setEnabled(!state && !this->getTcp());
+  this->ui->slowClientCombo->setEnabled(!state && this->getServer());
+  this->ui->formatCombo->setEnabled(!state);
 
   this->ui->udpStartStopButton->setText(state ? "Stop" : "Forward");
 
@@ -135,6 +153,16 @@ void
 NetForwarderUI::setTcp(bool tcp)
 {
   this->ui->socketTypeCombo->setCurrentIndex(tcp ? 1 : 0);
+  this->onSocketTypeChanged();
+}
+
+void
+NetForwarderUI::setStats(DataSaverStats const &stats)
+{
+  this->stats = stats;
+
+  this->ui->ioBwProgress->setToolTip(stats.summary());
+  this->ui->statsButton->setEnabled(true);
 }
 
 std::string
@@ -164,7 +192,42 @@ NetForwarderUI::getForwardState(void) const
 bool
 NetForwarderUI::getTcp(void) const
 {
-  return this->ui->socketTypeCombo->currentIndex() == 1;
+  return this->ui->socketTypeCombo->currentIndex() == 1 || this->getServer();
+}
+
+bool
+NetForwarderUI::getFramed(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() == 2;
+}
+
+bool
+NetForwarderUI::getServer(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() == 3;
+}
+
+ForwarderSlowClientPolicy
+NetForwarderUI::getSlowClientPolicy(void) const
+{
+  return this->ui->slowClientCombo->currentIndex() == 1
+      ? FORWARDER_SLOW_CLIENT_DISCONNECT
+      : FORWARDER_SLOW_CLIENT_DROP;
+}
+
+// Combo entries follow the order of ForwarderSampleFormat
+ForwarderSampleFormat
+NetForwarderUI::getFormat(void) const
+{
+  return static_cast<ForwarderSampleFormat>(
+        this->ui->formatCombo->currentIndex());
+}
+
+quint64
+NetForwarderUI::getPacing(void) const
+{
+  // Mbit/s to bytes per second
+  return static_cast<quint64>(this->ui->pacingSpin->value()) * 125000ull;
 }
 
 ///////////////////////////////// Slots ///////////////////////////////////////
@@ -178,3 +241,19 @@ NetForwarderUI::onForwardStartStop(void)
 
   emit forwardStateChanged(this->ui->udpStartStopButton->isChecked());
 }
+
+void
+NetForwarderUI::onSocketTypeChanged(void)
+{
+  // Pacing only applies to datagrams
+  this->ui->pacingSpin->setEnabled(!this->getTcp());
+
+  // Slow client handling only makes sense with many clients
+  this->ui->slowClientCombo->setEnabled(this->getServer());
+}
+
+void
+NetForwarderUI::onSaveStats(void)
+{
+  GenericDataSaverUI::saveStats(this, this->stats);
+}
@@ -23,9 +23,7 @@
 #include "MainSpectrum.h"
 #include <SuWidgetsHelpers.h>
 #include <SigDiggerHelpers.h>
-#include <fstream>
-#include <iomanip>
-#include <limits>
+#include <MatlabWriter.h>
 #include <QFileDialog>
 #include <QMessageBox>
 
@@ -42,27 +40,19 @@ SavedSpectrum::set(qint64 start, qint64 end, const float *data, size_t size)
 bool
 SavedSpectrum::exportToFile(QString const &path)
 {
-  std::ofstream of(path.toStdString().c_str(), std::ofstream::binary);
+  MatlabWriter writer;
 
-  if (!of.is_open())
+  if (!writer.open(path.toStdString()))
     return false;
 
-  of << "%\n";
-  of << "% Panoramic Spectrum file generated by SigDigger\n";
-  of << "%\n\n";
-
-  of << "freqMin = " << this->start << ";\n";
-  of << "freqMax = " << this->end << ";\n";
-  of << "PSD = [ ";
-
-  of << std::setprecision(std::numeric_limits<float>::digits10);
-
-  for (auto p : this->data)
-    of << p << " ";
-
-  of << "];\n";
-
-  return true;
+  return writer.writeText(
+        "%\n"
+        "% Panoramic Spectrum file generated by SigDigger\n"
+        "%\n\n")
+      && writer.writeScalar("freqMin", this->start)
+      && writer.writeScalar("freqMax", this->end)
+      && writer.writeReal("PSD", this->data.data(), this->data.size())
+      && writer.close();
 }
 
 ////////////////////////// PanoramicDialogConfig ///////////////////////////////
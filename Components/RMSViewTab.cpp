@@ -26,6 +26,7 @@
 #include <string>
 #include <QDateTime>
 #include <QFileDialog>
+#include <MatlabWriter.h>
 
 #define MAX_LINE_SIZE  4096
 #define TIMER_INTERVAL_MS 100
@@ -57,9 +58,16 @@ RMSViewTab::RMSViewTab(QWidget *parent, QTcpSocket *socket) :
 bool
 RMSViewTab::saveToMatlab(QString const &path)
 {
-  FILE *fp;
+  MatlabWriter writer;
+  bool ok;
 
-  if ((fp = fopen(path.toStdString().c_str(), "w")) == nullptr) {
+  ok = writer.open(path.toStdString())
+      && writer.writeScalar("RATE", this->rate / this->ui->intSpin->value())
+      && writer.writeScalar("TIMESTAMP", this->first)
+      && writer.writeColumns("X", this->data.data(), this->data.size())
+      && writer.close();
+
+  if (!ok) {
     QMessageBox::critical(
           this,
           "Save data to MATLAB file",
@@ -68,19 +76,6 @@ RMSViewTab::saveToMatlab(QString const &path)
     return false;
   }
 
-  fprintf(fp, "RATE=%.9f;\n", this->rate / this->ui->intSpin->value());
-  fprintf(fp, "TIMESTAMP=%.6f;\n", this->first);
-  fprintf(fp, "X=[\n");
-  for (size_t i = 0; i < this->data.size(); ++i)
-    fprintf(
-          fp,
-          "  %.9e, %.9f\n",
-          SU_C_REAL(this->data[i]),
-          SU_C_IMAG(this->data[i]));
-
-  fprintf(fp, "];\n");
-  fclose(fp);
-
   return true;
 }
 
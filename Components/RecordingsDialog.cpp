@@ -0,0 +1,190 @@
+//
+//    RecordingsDialog.cpp: Shared view of channel recordings
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <RecordingsDialog.h>
+#include "ui_RecordingsDialog.h"
+
+#include <RecordingService.h>
+#include <SuWidgetsHelpers.h>
+#include <QFileDialog>
+#include <QMessageBox>
+
+using namespace SigDigger;
+
+RecordingsDialog::RecordingsDialog(QWidget *parent) :
+  QDialog(parent),
+  ui(new Ui::RecordingsDialog)
+{
+  ui->setupUi(this);
+
+  this->timer.setInterval(SIGDIGGER_RECORDINGS_DIALOG_REFRESH_MS);
+
+  this->connectAll();
+}
+
+RecordingsDialog::~RecordingsDialog()
+{
+  delete ui;
+}
+
+void
+RecordingsDialog::connectAll(void)
+{
+  connect(
+        &this->timer,
+        SIGNAL(timeout(void)),
+        this,
+        SLOT(onRefresh(void)));
+
+  connect(
+        this->ui->saveStatsButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onSaveStats(void)));
+
+  connect(
+        this->ui->buttonBox,
+        SIGNAL(rejected()),
+        this,
+        SLOT(hide()));
+}
+
+void
+RecordingsDialog::showEvent(QShowEvent *event)
+{
+  this->onRefresh();
+  this->timer.start();
+
+  QDialog::showEvent(event);
+}
+
+void
+RecordingsDialog::hideEvent(QHideEvent *event)
+{
+  this->timer.stop();
+
+  QDialog::hideEvent(event);
+}
+
+static QTableWidgetItem *
+makeItem(QString const &text)
+{
+  QTableWidgetItem *item = new QTableWidgetItem(text);
+
+  item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+  return item;
+}
+
+/////////////////////////////////// Slots //////////////////////////////////////
+void
+RecordingsDialog::onRefresh(void)
+{
+  RecordingService *service = RecordingService::getInstance();
+  std::vector<RecordingService::ChannelStats> stats =
+      service->getChannelStats();
+  DataSaverStats total = service->getTotalStats();
+  int row = 0;
+
+  this->ui->tableWidget->setRowCount(static_cast<int>(stats.size()));
+
+  for (auto &ch : stats) {
+    this->ui->tableWidget->setItem(
+          row,
+          0,
+          new QTableWidgetItem(QString::fromStdString(ch.name)));
+    this->ui->tableWidget->setItem(
+          row,
+          1,
+          makeItem(QString::number(ch.thread)));
+    this->ui->tableWidget->setItem(
+          row,
+          2,
+          makeItem(SuWidgetsHelpers::formatBinaryQuantity(
+                     static_cast<qint64>(ch.stats.bytes))));
+    this->ui->tableWidget->setItem(
+          row,
+          3,
+          makeItem(SuWidgetsHelpers::formatBinaryQuantity(
+                     static_cast<qint64>(ch.stats.bytesPerSecond())) + "/s"));
+    this->ui->tableWidget->setItem(
+          row,
+          4,
+          makeItem(QString::number(ch.stats.meanLatency(), 'f', 0) + " us"));
+    this->ui->tableWidget->setItem(
+          row,
+          5,
+          makeItem(
+            "< " + QString::number(ch.stats.latencyPercentile(.99)) + " us"));
+    this->ui->tableWidget->setItem(
+          row,
+          6,
+          makeItem(
+            QString::number(ch.stats.peakOccupancy * 100, 'f', 0) + "%"));
+    this->ui->tableWidget->setItem(
+          row,
+          7,
+          makeItem(QString::number(ch.stats.swamps)));
+    this->ui->tableWidget->setItem(
+          row,
+          8,
+          makeItem(SuWidgetsHelpers::formatBinaryQuantity(
+                     static_cast<qint64>(ch.stats.dropped))));
+    ++row;
+  }
+
+  if (stats.empty())
+    this->ui->summaryLabel->setText("No channels are being recorded");
+  else
+    this->ui->summaryLabel->setText(
+          QString::number(stats.size())
+          + " channel(s) on "
+          + QString::number(service->getThreadCount())
+          + " writer thread(s), "
+          + SuWidgetsHelpers::formatBinaryQuantity(
+            static_cast<qint64>(total.bytesPerSecond()))
+          + "/s in total");
+
+  this->ui->saveStatsButton->setEnabled(!stats.empty());
+}
+
+void
+RecordingsDialog::onSaveStats(void)
+{
+  QFileDialog dialog(this);
+
+  dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+  dialog.setAcceptMode(QFileDialog::AcceptSave);
+  dialog.setWindowTitle(QString("Save recording statistics"));
+  dialog.setNameFilters(
+        QStringList()
+        << "Comma-separated values (*.csv)"
+        << "JSON files (*.json)");
+
+  if (dialog.exec()) {
+    QString path = dialog.selectedFiles().first();
+
+    if (!RecordingService::getInstance()->saveStats(path.toStdString()))
+      QMessageBox::critical(
+            this,
+            "Save recording statistics",
+            "Failed to save statistics to " + path,
+            QMessageBox::Ok);
+  }
+}
@@ -196,6 +196,12 @@ SamplerDialog::makeSampler(void)
   return new WaveSampler(this->properties, &this->decider);
 }
 
+SamplerStage *
+SamplerDialog::makeSamplerStage(void)
+{
+  return new SamplerStage(this->properties, &this->decider);
+}
+
 unsigned int
 SamplerDialog::getVScrollPageSize(void) const
 {
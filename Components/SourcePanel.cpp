@@ -109,6 +109,12 @@ SourcePanel::connectAll(void)
         this,
         SLOT(onRecordStartStop()));
 
+  connect(
+        this->saverUI,
+        SIGNAL(preRollChanged(void)),
+        this,
+        SLOT(onPreRollChanged(void)));
+
   connect(
         this->ui->autoGainCombo,
         SIGNAL(activated(int)),
@@ -579,6 +585,12 @@ SourcePanel::setIORate(qreal rate)
   this->saverUI->setIORate(rate);
 }
 
+void
+SourcePanel::setCaptureStats(DataSaverStats const &stats)
+{
+  this->saverUI->setStats(stats);
+}
+
 void
 SourcePanel::setRecordState(bool state)
 {
@@ -662,6 +674,12 @@ SourcePanel::onRecordStartStop(void)
   emit toggleRecord();
 }
 
+void
+SourcePanel::onPreRollChanged(void)
+{
+  emit preRollChanged();
+}
+
 void
 SourcePanel::onThrottleChanged(void)
 {
@@ -30,7 +30,10 @@
 #include <CarrierDetector.h>
 #include <CarrierXlator.h>
 #include <HistogramFeeder.h>
+#include <PipelineStages.h>
 #include <DopplerCalculator.h>
+#include <DopplerTracker.h>
+#include <BatchExportTask.h>
 
 #include "ui_TimeWindow.h"
 
@@ -139,6 +142,30 @@ TimeWindow::connectAll(void)
         this,
         SLOT(onSaveSelection(void)));
 
+  connect(
+        this->ui->actionAddToBatch,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onAddToBatch(void)));
+
+  connect(
+        this->ui->actionBatchExport,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onBatchExport(void)));
+
+  connect(
+        this->batchExportDialog,
+        SIGNAL(selectionsChanged(void)),
+        this,
+        SLOT(onBatchSelectionsChanged(void)));
+
+  connect(
+        this->batchExportDialog,
+        SIGNAL(exportRequested(void)),
+        this,
+        SLOT(onBatchExportRequested(void)));
+
   connect(
         this->ui->actionFit_to_gain,
         SIGNAL(triggered(bool)),
@@ -279,6 +306,12 @@ TimeWindow::connectAll(void)
         this,
         SLOT(onResetCarrier(void)));
 
+  connect(
+        this->ui->xlateOnTheFlyCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onToggleXlateOnTheFly(void)));
+
 
   connect(
         this->ui->dcNotchSlider,
@@ -361,6 +394,30 @@ TimeWindow::getDisplayDataLength(void) const
   return this->displayData->size();
 }
 
+SampleBuffer
+TimeWindow::getDisplayBuffer(void) const
+{
+  return SampleBuffer(this->displayData);
+}
+
+SUCOMPLEX *
+TimeWindow::allocProcessedData(void)
+{
+  // The translated data may be processed again in place, unless some
+  // task still refers to it. Then it is left alone and replaced.
+  long owners = this->displayData == this->processedData ? 2 : 1;
+
+  if (this->data == this->processedData)
+    ++owners;
+
+  if (SampleBuffer::isShared(this->processedData, owners))
+    this->processedData = std::make_shared<std::vector<SUCOMPLEX>>();
+
+  this->processedData->resize(this->getDisplayDataLength());
+
+  return this->processedData->data();
+}
+
 void
 TimeWindow::showEvent(QShowEvent *)
 {
@@ -551,6 +608,40 @@ TimeWindow::populateSamplingProperties(SamplingProperties &prop)
   }
 }
 
+SampleBuffer
+TimeWindow::getSamplingBuffer(SamplingProperties const &prop) const
+{
+  return this->getDisplayBuffer().slice(
+        static_cast<size_t>(prop.data - this->getDisplayData()),
+        prop.length);
+}
+
+SUFLOAT
+TimeWindow::getXlateOnTheFlyFreq(void) const
+{
+  if (!this->ui->xlateOnTheFlyCheck->isChecked())
+    return 0;
+
+  return SU_ABS2NORM_FREQ(this->fs, this->ui->syncFreqSpin->value());
+}
+
+SamplePipeline *
+TimeWindow::makeXlatePipeline(
+    SampleBuffer const &source,
+    SUFLOAT relFreq,
+    SUFLOAT relCutoff) const
+{
+  SamplePipeline *pipeline = new SamplePipeline(source);
+
+  pipeline->addStage(new XlatorStage(relFreq));
+
+  if (relCutoff > 0 && relCutoff < 1)
+    pipeline->addStage(
+          new LowpassStage(TIME_WINDOW_XLATE_FILTER_ORDER, relCutoff));
+
+  return pipeline;
+}
+
 void
 TimeWindow::samplingNotifySelection(bool selection, bool periodic)
 {
@@ -605,6 +696,9 @@ TimeWindow::refreshUi(void)
   this->ui->periodLabel->setEnabled(haveSelection);
   this->ui->baudLabel->setEnabled(haveSelection);
   this->ui->actionSave_selection->setEnabled(haveSelection);
+  this->ui->actionAddToBatch->setEnabled(haveSelection);
+  this->ui->actionBatchExport->setEnabled(
+        this->batchExportDialog->getSelectionCount() > 0);
   this->ui->dopplerButton->setEnabled(haveSelection);
 
   if (haveSelection != this->hadSelectionBefore) {
@@ -641,17 +735,38 @@ TimeWindow::refreshUi(void)
 void
 TimeWindow::startSampling(void)
 {
-  WaveSampler *ws = this->samplerDialog->makeSampler();
+  Suscan::CancellableTask *task;
 
-  connect(
-        ws,
-        SIGNAL(data(SigDigger::WaveSampleSet)),
-        this,
-        SLOT(onSampleSet(SigDigger::WaveSampleSet)));
+  if (!this->samplingStream.empty()) {
+    SamplePipeline *sp = this->makeXlatePipeline(
+          this->samplingStream,
+          this->samplingXlate,
+          this->samplingCutoff);
+    SamplerStage *ss = this->samplerDialog->makeSamplerStage();
+
+    connect(
+          ss,
+          SIGNAL(data(SigDigger::WaveSampleSet)),
+          this,
+          SLOT(onSampleSet(SigDigger::WaveSampleSet)));
+
+    sp->addStage(ss);
+    task = sp;
+  } else {
+    WaveSampler *ws = this->samplerDialog->makeSampler();
+
+    connect(
+          ws,
+          SIGNAL(data(SigDigger::WaveSampleSet)),
+          this,
+          SLOT(onSampleSet(SigDigger::WaveSampleSet)));
+
+    task = ws;
+  }
 
   this->samplerDialog->show();
   this->notifyTaskRunning(true);
-  this->taskController.process(QStringLiteral("triggerSampler"), ws);
+  this->taskController.process(QStringLiteral("triggerSampler"), task);
 }
 
 void
@@ -779,7 +894,7 @@ TimeWindow::setCenterFreq(SUFREQ center)
 
 void
 TimeWindow::setDisplayData(
-    std::vector<SUCOMPLEX> const *displayData,
+    std::shared_ptr<const std::vector<SUCOMPLEX>> const &displayData,
     bool keepView)
 {
   this->displayData = displayData;
@@ -788,8 +903,8 @@ TimeWindow::setDisplayData(
     this->ui->realWaveform->setData(nullptr, false);
     this->ui->imagWaveform->setData(nullptr, false);
   } else {
-    this->ui->realWaveform->setData(displayData, keepView);
-    this->ui->imagWaveform->setData(displayData, keepView);
+    this->ui->realWaveform->setData(displayData.get(), keepView);
+    this->ui->imagWaveform->setData(displayData.get(), keepView);
   }
 
 
@@ -800,7 +915,9 @@ TimeWindow::setDisplayData(
 }
 
 void
-TimeWindow::setData(std::vector<SUCOMPLEX> const &data, qreal fs)
+TimeWindow::setData(
+    std::shared_ptr<const std::vector<SUCOMPLEX>> const &data,
+    qreal fs)
 {
   this->fs = fs;
 
@@ -809,8 +926,9 @@ TimeWindow::setData(std::vector<SUCOMPLEX> const &data, qreal fs)
   this->ui->realWaveform->setSampleRate(fs);
   this->ui->imagWaveform->setSampleRate(fs);
 
-  this->data = &data;
-  this->setDisplayData(&data);
+  this->data = data;
+  this->batchExportDialog->clear();
+  this->setDisplayData(data);
 
   this->onCarrierSlidersChanged();
 }
@@ -835,6 +953,7 @@ TimeWindow::TimeWindow(QWidget *parent) :
   this->histogramDialog = new HistogramDialog(this);
   this->samplerDialog   = new SamplerDialog(this);
   this->dopplerDialog   = new DopplerDialog(this);
+  this->batchExportDialog = new BatchExportDialog(this);
 
   // We can do this because both labels have the same font
   this->ui->notchWidthLabel->setFixedWidth(
@@ -1109,8 +1228,7 @@ TimeWindow::onSaveAll(void)
 {
   SigDiggerHelpers::openSaveSamplesDialog(
         this,
-        this->getDisplayData(),
-        this->getDisplayDataLength(),
+        this->getDisplayBuffer(),
         this->fs,
         0,
         static_cast<int>(this->getDisplayDataLength()),
@@ -1122,14 +1240,66 @@ TimeWindow::onSaveSelection(void)
 {
   SigDiggerHelpers::openSaveSamplesDialog(
         this,
-        this->getDisplayData(),
-        this->getDisplayDataLength(),
+        this->getDisplayBuffer(),
         this->fs,
         static_cast<int>(this->ui->realWaveform->getHorizontalSelectionStart()),
         static_cast<int>(this->ui->realWaveform->getHorizontalSelectionEnd()),
         Suscan::Singleton::get_instance()->getBackgroundTaskController());
 }
 
+void
+TimeWindow::onAddToBatch(void)
+{
+  int start =
+      static_cast<int>(this->ui->realWaveform->getHorizontalSelectionStart());
+  int end =
+      static_cast<int>(this->ui->realWaveform->getHorizontalSelectionEnd());
+  int divs = 1;
+
+  // Periodic selections are exported one period per file
+  if (this->ui->periodicSelectionCheck->isChecked())
+    divs = this->getPeriodicDivision();
+
+  if (divs < 1)
+    divs = 1;
+
+  for (int i = 0; i < divs; ++i)
+    this->batchExportDialog->addSelection(
+          start + static_cast<int>(
+            static_cast<qint64>(end - start) * i / divs),
+          start + static_cast<int>(
+            static_cast<qint64>(end - start) * (i + 1) / divs));
+}
+
+void
+TimeWindow::onBatchExport(void)
+{
+  this->batchExportDialog->setSampleRate(this->fs);
+  this->batchExportDialog->show();
+  this->batchExportDialog->raise();
+}
+
+void
+TimeWindow::onBatchSelectionsChanged(void)
+{
+  this->refreshUi();
+}
+
+void
+TimeWindow::onBatchExportRequested(void)
+{
+  std::vector<BatchExportItem> items = this->batchExportDialog->makeItems();
+  BatchExportTask *task = new BatchExportTask(
+        this->getDisplayBuffer(),
+        this->fs,
+        this->batchExportDialog->getFormat(),
+        items);
+
+  Suscan::Singleton::get_instance()->getBackgroundTaskController()->pushTask(
+        task,
+        "Batch export of " + QString::number(items.size()) + " selections");
+}
+
 void
 TimeWindow::onFit(void)
 {
@@ -1313,21 +1483,28 @@ TimeWindow::onTaskDone(void)
     // Some UI feedback
     this->ui->syncFreqSpin->setValue(SU_NORM2ABS_FREQ(this->fs, relFreq));
 
-    // Resize and process
-    this->processedData.resize(this->getDisplayDataLength());
+    if (this->ui->xlateOnTheFlyCheck->isChecked()) {
+      // Measurements will translate the samples as they read them
+      this->notifyTaskRunning(false);
+    } else {
+      // Resize and process
+      SUCOMPLEX *output = this->allocProcessedData();
 
-    CarrierXlator *cx = new CarrierXlator(
-          this->getDisplayData(),
-          this->processedData.data(),
-          this->getDisplayDataLength(),
-          relFreq);
+      CarrierXlator *cx = new CarrierXlator(
+            this->getDisplayData(),
+            output,
+            this->getDisplayDataLength(),
+            relFreq);
 
-    // Launch carrier translator
-    this->taskController.process("xlateCarrier", cx);
+      // Launch carrier translator
+      this->taskController.process("xlateCarrier", cx);
+    }
   } else if (this->taskController.getName() == "xlateCarrier") {
-    this->setDisplayData(&this->processedData, true);
+    this->setDisplayData(this->processedData, true);
 
     this->notifyTaskRunning(false);
+  } else if (this->taskController.getName() == "xlateSampling") {
+    this->startSampling();
   } else if (this->taskController.getName() == "triggerHistogram") {
     this->histogramDialog->show();
     this->notifyTaskRunning(false);
@@ -1345,8 +1522,6 @@ TimeWindow::onTaskDone(void)
     // then the RBW is fs / data.size()
     // Therefore delta V is RBW * lambda
 
-    this->notifyTaskRunning(false);
-
     this->dopplerDialog->setVelocityStep(this->fs / spectrum.size() * lambda);
     this->dopplerDialog->setSigmaV(static_cast<qreal>(dc->getSigma()));
     this->dopplerDialog->setCenterFreq(this->ui->refFreqSpin->value());
@@ -1354,6 +1529,28 @@ TimeWindow::onTaskDone(void)
     this->dopplerDialog->giveSpectrum(std::move(spectrum));
     this->dopplerDialog->setMax(dc->getMax());
     this->dopplerDialog->show();
+
+    // The distribution is ready. Now see how it evolves over the selection.
+    DopplerTracker *dt = new DopplerTracker(
+          this->ui->refFreqSpin->value(),
+          this->dopplerData->data() + this->dopplerStart,
+          this->dopplerLen,
+          static_cast<SUFLOAT>(this->fs));
+
+    this->taskController.process("trackDoppler", dt);
+  } else if (this->taskController.getName() == "trackDoppler") {
+    const DopplerTracker *dt =
+        static_cast<const DopplerTracker *>(this->taskController.getTask());
+
+    this->dopplerDialog->giveTrack(
+          dt->getRawVelocity(),
+          dt->getSigma(),
+          dt->getEnergy(),
+          dt->getFrameRate(),
+          dt->getTimeOffset());
+    this->dopplerData.reset();
+
+    this->notifyTaskRunning(false);
   }
 }
 
@@ -1364,6 +1561,9 @@ TimeWindow::onTaskCancelled(void)
   this->ui->taskStateLabel->setText("Idle");
   this->ui->taskProgressBar->setValue(0);
 
+  // The Doppler chain may have stopped halfway, holding the capture
+  this->dopplerData.reset();
+
   this->notifyTaskRunning(false);
 }
 
@@ -1373,6 +1573,8 @@ TimeWindow::onTaskError(QString error)
   this->ui->taskStateLabel->setText("Idle");
   this->ui->taskProgressBar->setValue(0);
 
+  this->dopplerData.reset();
+
   this->notifyTaskRunning(false);
 
   QMessageBox::warning(this, "Background task failed", "Task failed: " + error);
@@ -1408,11 +1610,11 @@ TimeWindow::onSyncCarrier(void)
         this->fs,
         this->ui->syncFreqSpin->value());
 
-  this->processedData.resize(this->getDisplayDataLength());
+  SUCOMPLEX *output = this->allocProcessedData();
 
   CarrierXlator *cx = new CarrierXlator(
         this->getDisplayData(),
-        this->processedData.data(),
+        output,
         this->getDisplayDataLength(),
         relFreq);
 
@@ -1427,6 +1629,14 @@ TimeWindow::onResetCarrier(void)
   this->ui->syncFreqSpin->setValue(0);
 }
 
+void
+TimeWindow::onToggleXlateOnTheFly(void)
+{
+  // Translating the waveform now would translate the measurements twice
+  this->ui->syncButton->setEnabled(
+        !this->ui->xlateOnTheFlyCheck->isChecked());
+}
+
 void
 TimeWindow::onCarrierSlidersChanged(void)
 {
@@ -1456,26 +1666,55 @@ TimeWindow::onHistogramSamples(const float *samples, unsigned int size)
   this->histogramDialog->feed(samples, size);
 }
 
+void
+TimeWindow::onHistogramValues(QVector<float> values)
+{
+  this->histogramDialog->feed(
+        values.constData(),
+        static_cast<unsigned int>(values.size()));
+}
+
 void
 TimeWindow::onTriggerHistogram(void)
 {
   SamplingProperties props;
+  SUFLOAT relFreq = this->getXlateOnTheFlyFreq();
+  Suscan::CancellableTask *task;
 
   this->populateSamplingProperties(props);
 
-  HistogramFeeder *hf = new HistogramFeeder(props);
+  if (relFreq != 0) {
+    SamplePipeline *sp = this->makeXlatePipeline(
+          this->getSamplingBuffer(props),
+          relFreq,
+          0);
+    HistogramStage *hs = new HistogramStage(props.space);
+
+    connect(
+          hs,
+          SIGNAL(data(QVector<float>)),
+          this,
+          SLOT(onHistogramValues(QVector<float>)));
+
+    sp->addStage(hs);
+    task = sp;
+  } else {
+    HistogramFeeder *hf = new HistogramFeeder(props);
 
-  connect(
-        hf,
-        SIGNAL(data(const float *, unsigned int)),
-        this,
-        SLOT(onHistogramSamples(const float *, unsigned int)));
+    connect(
+          hf,
+          SIGNAL(data(const float *, unsigned int)),
+          this,
+          SLOT(onHistogramSamples(const float *, unsigned int)));
+
+    task = hf;
+  }
 
   this->histogramDialog->reset();
   this->histogramDialog->setProperties(props);
   this->histogramDialog->show();
   this->notifyTaskRunning(true);
-  this->taskController.process("triggerHistogram", hf);
+  this->taskController.process("triggerHistogram", task);
 }
 
 void
@@ -1495,10 +1734,41 @@ void
 TimeWindow::onTriggerSampler(void)
 {
   SamplingProperties props;
+  SUFLOAT relFreq = this->getXlateOnTheFlyFreq();
 
   this->populateSamplingProperties(props);
 
+  this->samplingStream = SampleBuffer();
+  this->samplingXlate  = relFreq;
+  this->samplingCutoff = 0;
+
   this->samplerDialog->reset();
+
+  if (relFreq != 0) {
+    if (props.sync == SamplingClockSync::MANUAL) {
+      SampleBuffer source = this->getSamplingBuffer(props);
+
+      // Only the sampled interval is translated, not the whole capture
+      this->samplingData.resize(props.length);
+      props.data = this->samplingData.data();
+      this->samplerDialog->setProperties(props);
+
+      CarrierXlator *cx = new CarrierXlator(
+            source.data(),
+            this->samplingData.data(),
+            props.length,
+            relFreq);
+
+      this->notifyTaskRunning(true);
+      this->taskController.process("xlateSampling", cx);
+      return;
+    }
+
+    // Keep the neighbouring channels away from the clock detector
+    this->samplingStream = this->getSamplingBuffer(props);
+    this->samplingCutoff = SU_ABS2NORM_FREQ(this->fs, props.rate);
+  }
+
   this->samplerDialog->setProperties(props);
 
   this->startSampling();
@@ -1602,6 +1872,10 @@ TimeWindow::onCalculateDoppler(void)
           static_cast<size_t>(selEnd - selStart),
           static_cast<SUFLOAT>(this->fs));
 
+    this->dopplerData  = this->displayData;
+    this->dopplerStart = static_cast<size_t>(selStart);
+    this->dopplerLen   = static_cast<size_t>(selEnd - selStart);
+
     this->notifyTaskRunning(true);
     this->taskController.process("computeDoppler", dc);
   }
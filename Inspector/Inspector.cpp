@@ -96,12 +96,28 @@ Inspector::setAnalyzer(Suscan::Analyzer *analyzer)
         : InspectorUI::ATTACHED);
 }
 
+void
+Inspector::setId(Suscan::InspectorId id)
+{
+  SampleBus::getInstance()->unsubscribe(this);
+
+  this->id = id;
+
+  SampleBus::getInstance()->subscribe(id, this);
+}
+
 void
 Inspector::feed(const SUCOMPLEX *data, unsigned int size)
 {
   this->ui->feed(data, size);
 }
 
+void
+Inspector::consume(SampleBuffer const &buffer)
+{
+  this->feed(buffer.data(), static_cast<unsigned int>(buffer.size()));
+}
+
 void
 Inspector::feedSpectrum(const SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate)
 {
@@ -126,7 +142,7 @@ Inspector::updateEstimator(Suscan::EstimatorId id, float val)
 
 Inspector::~Inspector()
 {
-
+  SampleBus::getInstance()->unsubscribe(this);
 }
 
 /////////////////////////////////// Slots /////////////////////////////////////
@@ -36,6 +36,7 @@
 #include <QMessageBox>
 #include <SuWidgetsHelpers.h>
 #include <SigDiggerHelpers.h>
+#include <RecordingService.h>
 
 #include <iomanip>
 #include <fcntl.h>
@@ -104,8 +105,10 @@ InspectorUI::~InspectorUI()
 {
   delete this->ui;
 
-  if (this->dataSaver != nullptr)
+  if (this->dataSaver != nullptr) {
+    RecordingService::getInstance()->unregisterSaver(this->dataSaver);
     delete this->dataSaver;
+  }
 
   if (this->socketForwarder != nullptr)
     delete this->socketForwarder;
@@ -439,11 +442,12 @@ InspectorUI::connectNetForwarder()
 }
 
 std::string
-InspectorUI::captureFileName(void) const
+InspectorUI::captureFilePrefix(void) const
 {
   unsigned int i = 0;
   std::string path;
 
+  // Segmented captures append a segment number to this prefix
   do {
     std::ostringstream os;
 
@@ -451,27 +455,122 @@ InspectorUI::captureFileName(void) const
        << this->getClassName()
        << "-"
        << std::to_string(this->getBaudRate())
-       << "-baud-"
-       << std::setw(4)
+       << "-baud-";
+
+    // Real samples are not what older readers of these files expect
+    if (this->recordFormat == REAL_SAMPLE_FORMAT_FLOAT32)
+      os << "float32-";
+    else if (this->recordFormat == REAL_SAMPLE_FORMAT_INT16)
+      os << "int16-";
+
+    os << std::setw(4)
        << std::setfill('0')
-       << ++i
-       << ".raw";
+       << ++i;
     path = this->saverUI->getRecordSavePath() + "/" + os.str();
-  } while (access(path.c_str(), F_OK) != -1);
+  } while (access((path + ".raw").c_str(), F_OK) != -1
+           || access((path + "_0001.raw").c_str(), F_OK) != -1);
 
   return path;
 }
 
+std::string
+InspectorUI::captureFileName(void) const
+{
+  return this->captureFilePrefix() + ".raw";
+}
+
+// Modulus decisions keep the whole complex sample
+RealSampleFormat
+InspectorUI::streamFormat(RealSampleFormat requested) const
+{
+  if (this->decider.getDecisionMode() == Decider::MODULUS)
+    return REAL_SAMPLE_FORMAT_COMPLEX;
+
+  return requested;
+}
+
+// Expects realBuffer and intBuffer to be filled by feed()
+void
+InspectorUI::writeSamples(
+    GenericDataSaver *saver,
+    RealSampleFormat format,
+    const SUCOMPLEX *data,
+    unsigned int size)
+{
+  switch (format) {
+    case REAL_SAMPLE_FORMAT_FLOAT32:
+      saver->write(this->realBuffer.data(), size);
+      break;
+
+    case REAL_SAMPLE_FORMAT_INT16:
+      saver->write(this->intBuffer.data(), size);
+      break;
+
+    default:
+      if (this->decider.getDecisionMode() == Decider::MODULUS) {
+        saver->write(data, size);
+      } else {
+        if (this->buffer.size() < size)
+          this->buffer.resize(size);
+
+        for (unsigned i = 0; i < size; ++i)
+          this->buffer[i] = this->realBuffer[i];
+
+        saver->write(this->buffer.data(), size);
+      }
+  }
+}
+
+static ForwarderSampleFormat
+forwarderFormat(RealSampleFormat format)
+{
+  switch (format) {
+    case REAL_SAMPLE_FORMAT_FLOAT32:
+      return FORWARDER_FORMAT_FLOAT32;
+
+    case REAL_SAMPLE_FORMAT_INT16:
+      return FORWARDER_FORMAT_INT16;
+
+    default:
+      return FORWARDER_FORMAT_COMPLEX_FLOAT32;
+  }
+}
+
+static RealSampleFormat
+realFormat(ForwarderSampleFormat format)
+{
+  switch (format) {
+    case FORWARDER_FORMAT_FLOAT32:
+      return REAL_SAMPLE_FORMAT_FLOAT32;
+
+    case FORWARDER_FORMAT_INT16:
+      return REAL_SAMPLE_FORMAT_INT16;
+
+    default:
+      return REAL_SAMPLE_FORMAT_COMPLEX;
+  }
+}
+
 bool
 InspectorUI::installNetForwarder(void)
 {
   if (this->socketForwarder == nullptr) {
-    this->socketForwarder = new SocketForwarder(
-          this->netForwarderUI->getHost(),
-          this->netForwarderUI->getPort(),
-          this->netForwarderUI->getFrameLen(),
-          this->netForwarderUI->getTcp(),
-          this);
+    SocketForwarder::ForwarderParams params;
+
+    params.host   = this->netForwarderUI->getHost();
+    params.port   = this->netForwarderUI->getPort();
+    params.size   = this->netForwarderUI->getFrameLen();
+    params.tcp    = this->netForwarderUI->getTcp();
+    params.framed = this->netForwarderUI->getFramed();
+    params.pacing = this->netForwarderUI->getPacing();
+    params.server = this->netForwarderUI->getServer();
+    params.slowClientPolicy = this->netForwarderUI->getSlowClientPolicy();
+
+    this->forwardFormat = this->streamFormat(
+          realFormat(this->netForwarderUI->getFormat()));
+    params.format = forwarderFormat(this->forwardFormat);
+
+    this->socketForwarder = new SocketForwarder(params, this);
     this->recordingRate = this->getBaudRate();
     this->socketForwarder->setSampleRate(recordingRate);
     connectNetForwarder();
@@ -490,9 +589,49 @@ InspectorUI::uninstallNetForwarder(void)
   this->socketForwarder = nullptr;
 }
 
+static std::string
+baseName(std::string const &path)
+{
+  size_t slash = path.rfind('/');
+
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
 bool
 InspectorUI::installDataSaver(void)
 {
+  FileDataSaver::SegmentParams params;
+  QThread *thread;
+
+  params.maxSize     = this->saverUI->getSegmentSize();
+  params.maxDuration = this->saverUI->getSegmentDuration();
+
+  if (this->dataSaver == nullptr)
+    this->recordFormat = this->streamFormat(this->saverUI->getRealFormat());
+
+  if (this->dataSaver == nullptr && params.enabled()) {
+    this->recordingRate = this->getBaudRate();
+
+    // Segments are measured in complex units, real samples come packed
+    params.prefix   = this->captureFilePrefix();
+    params.quota    = this->saverUI->getQuota();
+    params.sampRate = static_cast<unsigned int>(
+          this->recordingRate * realSampleSize(this->recordFormat)
+          / sizeof(SUCOMPLEX));
+
+    thread = RecordingService::getInstance()->acquireThread();
+    this->dataSaver = new FileDataSaver(params, this, thread);
+    this->dataSaver->setSampleRate(recordingRate);
+    this->dataSaver->setSyncInterval(this->saverUI->getSyncInterval());
+    RecordingService::getInstance()->registerSaver(
+          baseName(params.prefix),
+          this->dataSaver,
+          thread);
+    connectDataSaver();
+
+    return true;
+  }
+
   if (this->dataSaver == nullptr) {
     std::string path = this->captureFileName();
     this->fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
@@ -513,9 +652,15 @@ InspectorUI::installDataSaver(void)
       return false;
     }
 
-    this->dataSaver = new FileDataSaver(this->fd, this);
+    thread = RecordingService::getInstance()->acquireThread();
+    this->dataSaver = new FileDataSaver(this->fd, this, thread);
     this->recordingRate = this->getBaudRate();
     this->dataSaver->setSampleRate(recordingRate);
+    this->dataSaver->setSyncInterval(this->saverUI->getSyncInterval());
+    RecordingService::getInstance()->registerSaver(
+          baseName(path),
+          this->dataSaver,
+          thread);
     connectDataSaver();
 
     return true;
@@ -527,8 +672,10 @@ InspectorUI::installDataSaver(void)
 void
 InspectorUI::uninstallDataSaver(void)
 {
-  if (this->dataSaver != nullptr)
+  if (this->dataSaver != nullptr) {
+    RecordingService::getInstance()->unregisterSaver(this->dataSaver);
     this->dataSaver->deleteLater();
+  }
   this->dataSaver = nullptr;
 
   if (this->fd != -1) {
@@ -602,24 +749,41 @@ InspectorUI::feed(const SUCOMPLEX *data, unsigned int size)
     this->wfTab->feed(data, size);
 
   if (this->recording || this->forwarding) {
-    if (this->decider.getDecisionMode() == Decider::MODULUS) {
-      if (this->recording)
-        this->dataSaver->write(data, size);
+    bool needInt =
+        (this->recording && this->recordFormat == REAL_SAMPLE_FORMAT_INT16)
+        || (this->forwarding && this->forwardFormat == REAL_SAMPLE_FORMAT_INT16);
 
-      if (this->forwarding)
-        this->socketForwarder->write(data, size);
-    } else {
-      if (this->buffer.size() < size)
-        this->buffer.resize(size);
+    // Real samples are computed once and shared by both outputs
+    if (this->decider.getDecisionMode() != Decider::MODULUS) {
+      if (this->realBuffer.size() < size)
+        this->realBuffer.resize(size);
+
+      phaseToReal(this->realBuffer.data(), data, size);
+    } else if (this->recordFormat != REAL_SAMPLE_FORMAT_COMPLEX
+               || this->forwardFormat != REAL_SAMPLE_FORMAT_COMPLEX) {
+      if (this->realBuffer.size() < size)
+        this->realBuffer.resize(size);
 
       for (unsigned i = 0; i < size; ++i)
-        this->buffer[i] = SU_C_ARG(I * data[i]) / PI;
+        this->realBuffer[i] = SU_C_ABS(data[i]);
+    }
 
-      if (this->recording)
-        this->dataSaver->write(this->buffer.data(), size);
-      if (this->forwarding)
-        this->socketForwarder->write(this->buffer.data(), size);
+    if (needInt) {
+      if (this->intBuffer.size() < size)
+        this->intBuffer.resize(size);
+
+      realToInt16(this->intBuffer.data(), this->realBuffer.data(), size);
     }
+
+    if (this->recording)
+      this->writeSamples(this->dataSaver, this->recordFormat, data, size);
+
+    if (this->forwarding)
+      this->writeSamples(
+            this->socketForwarder,
+            this->forwardFormat,
+            data,
+            size);
   }
 }
 
@@ -729,6 +893,9 @@ InspectorUI::populate(void)
   // Add data forwarder objects
 
   this->saverUI = new DataSaverUI(this->owner);
+  this->saverUI->setPreRollVisible(false);
+  this->saverUI->setFormatVisible(true);
+  this->saverUI->setSubbandVisible(false);
 
   this->ui->forwarderGrid->addWidget(this->saverUI, 0, 0, Qt::AlignTop);
 
@@ -1103,6 +1270,7 @@ void
 InspectorUI::onCommit(void)
 {
   this->saverUI->setCaptureSize(this->dataSaver->getSize());
+  this->saverUI->setStats(this->dataSaver->getStats());
 }
 
 
@@ -1175,6 +1343,7 @@ void
 InspectorUI::onNetCommit(void)
 {
   this->netForwarderUI->setCaptureSize(this->socketForwarder->getSize());
+  this->netForwarderUI->setStats(this->socketForwarder->getStats());
 }
 
 void
@@ -70,6 +70,21 @@ WaveformTab::getDisplayDataLength(void) const
   return this->buffer.size();
 }
 
+SampleBuffer
+WaveformTab::getExportBuffer(qint64 start, qint64 end) const
+{
+  qint64 size = static_cast<qint64>(this->buffer.size());
+
+  // The buffer keeps growing while recording, exports get a snapshot
+  start = qBound(static_cast<qint64>(0), start, size);
+  end   = qBound(start, end, size);
+
+  return SampleBuffer(
+        std::vector<SUCOMPLEX>(
+          this->buffer.begin() + start,
+          this->buffer.begin() + end));
+}
+
 void
 WaveformTab::setSampleRate(qreal rate)
 {
@@ -720,8 +735,7 @@ WaveformTab::onSaveAll(void)
 {
   SigDiggerHelpers::openSaveSamplesDialog(
         this,
-        this->getDisplayData(),
-        this->getDisplayDataLength(),
+        this->getExportBuffer(0, this->getDisplayDataLength()),
         this->fs,
         0,
         static_cast<int>(this->getDisplayDataLength()),
@@ -731,13 +745,17 @@ WaveformTab::onSaveAll(void)
 void
 WaveformTab::onSaveSelection(void)
 {
+  qint64 start = static_cast<qint64>(
+        this->ui->realWaveform->getHorizontalSelectionStart());
+  qint64 end = static_cast<qint64>(
+        this->ui->realWaveform->getHorizontalSelectionEnd());
+
   SigDiggerHelpers::openSaveSamplesDialog(
         this,
-        this->getDisplayData(),
-        this->getDisplayDataLength(),
+        this->getExportBuffer(start, end),
         this->fs,
-        static_cast<int>(this->ui->realWaveform->getHorizontalSelectionStart()),
-        static_cast<int>(this->ui->realWaveform->getHorizontalSelectionEnd()),
+        0,
+        static_cast<int>(end - start),
         Suscan::Singleton::get_instance()->getBackgroundTaskController());
 }
 
@@ -0,0 +1,305 @@
+//
+//    DataSaverStats.cpp: Writer path instrumentation
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "DataSaverStats.h"
+#include <cstdio>
+
+using namespace SigDigger;
+
+void
+DataSaverStats::reset(void)
+{
+  *this = DataSaverStats();
+}
+
+static unsigned int
+latencyBin(quint64 usec)
+{
+  unsigned int bin = 0;
+
+  while (usec > 0 && bin < SIGDIGGER_DATASAVER_LATENCY_BINS - 1) {
+    usec >>= 1;
+    ++bin;
+  }
+
+  return bin;
+}
+
+void
+DataSaverStats::addLatency(quint64 usec)
+{
+  ++this->latency[latencyBin(usec)];
+
+  this->writeTime += usec;
+  if (usec > this->maxLatency)
+    this->maxLatency = usec;
+}
+
+void
+DataSaverStats::addSync(quint64 usec)
+{
+  ++this->syncs;
+
+  this->syncTime += usec;
+  if (usec > this->maxSyncTime)
+    this->maxSyncTime = usec;
+}
+
+void
+DataSaverStats::addSyncError(void)
+{
+  ++this->syncErrors;
+}
+
+void
+DataSaverStats::addOccupancy(qreal occupancy)
+{
+  this->occupancy = occupancy;
+  if (occupancy > this->peakOccupancy)
+    this->peakOccupancy = occupancy;
+}
+
+void
+DataSaverStats::merge(DataSaverStats const &other)
+{
+  unsigned int i;
+
+  this->commits   += other.commits;
+  this->bytes     += other.bytes;
+  this->writeTime += other.writeTime;
+  this->swamps    += other.swamps;
+  this->dropped   += other.dropped;
+  this->syncs     += other.syncs;
+  this->syncTime  += other.syncTime;
+  this->syncErrors += other.syncErrors;
+
+  for (i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS; ++i)
+    this->latency[i] += other.latency[i];
+
+  if (other.elapsed > this->elapsed)
+    this->elapsed = other.elapsed;
+
+  if (other.maxLatency > this->maxLatency)
+    this->maxLatency = other.maxLatency;
+
+  if (other.occupancy > this->occupancy)
+    this->occupancy = other.occupancy;
+
+  if (other.peakOccupancy > this->peakOccupancy)
+    this->peakOccupancy = other.peakOccupancy;
+
+  if (other.maxSyncTime > this->maxSyncTime)
+    this->maxSyncTime = other.maxSyncTime;
+}
+
+qreal
+DataSaverStats::bytesPerSecond(void) const
+{
+  if (this->elapsed == 0)
+    return 0;
+
+  return 1e6 * static_cast<qreal>(this->bytes)
+      / static_cast<qreal>(this->elapsed);
+}
+
+qreal
+DataSaverStats::meanLatency(void) const
+{
+  quint64 count = 0;
+
+  for (unsigned int i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS; ++i)
+    count += this->latency[i];
+
+  if (count == 0)
+    return 0;
+
+  return static_cast<qreal>(this->writeTime) / static_cast<qreal>(count);
+}
+
+// Upper bound of the bin holding the given fraction of the samples
+quint64
+DataSaverStats::latencyPercentile(qreal p) const
+{
+  quint64 count = 0, accum = 0, target;
+  unsigned int i;
+
+  for (i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS; ++i)
+    count += this->latency[i];
+
+  if (count == 0)
+    return 0;
+
+  target = static_cast<quint64>(p * static_cast<qreal>(count));
+  if (target >= count)
+    target = count - 1;
+
+  for (i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS - 1; ++i) {
+    accum += this->latency[i];
+    if (accum > target)
+      break;
+  }
+
+  if (i == SIGDIGGER_DATASAVER_LATENCY_BINS - 1)
+    return this->maxLatency;
+
+  return 1ull << i;
+}
+
+QString
+DataSaverStats::summary(void) const
+{
+  return
+      QString::asprintf(
+        "Throughput: %.2f MB/s\n"
+        "Commits: %llu\n"
+        "Write latency: mean %.0f us, p50 < %llu us, p99 < %llu us, "
+        "max %llu us\n"
+        "Buffer occupancy: %.0f%% (peak %.0f%%)\n"
+        "Swamps: %llu (%llu bytes dropped)\n"
+        "Syncs: %llu (mean %.0f us, max %llu us, %llu failed)",
+        this->bytesPerSecond() * 1e-6,
+        this->commits,
+        this->meanLatency(),
+        this->latencyPercentile(.5),
+        this->latencyPercentile(.99),
+        this->maxLatency,
+        this->occupancy * 100,
+        this->peakOccupancy * 100,
+        this->swamps,
+        this->dropped,
+        this->syncs,
+        this->syncs > 0
+          ? static_cast<qreal>(this->syncTime) / this->syncs
+          : 0.,
+        this->maxSyncTime,
+        this->syncErrors);
+}
+
+std::string
+DataSaverStats::toCsv(void) const
+{
+  std::string csv;
+  char line[128];
+  unsigned int i;
+
+#define STAT_LINE(fmt, name, value)                        \
+  snprintf(line, sizeof(line), "%s," fmt "\n", name, value); \
+  csv += line
+
+  csv += "key,value\n";
+  STAT_LINE("%llu", "commits", this->commits);
+  STAT_LINE("%llu", "bytes", this->bytes);
+  STAT_LINE("%llu", "elapsed_us", this->elapsed);
+  STAT_LINE("%.1f", "bytes_per_second", this->bytesPerSecond());
+  STAT_LINE("%llu", "write_time_us", this->writeTime);
+  STAT_LINE("%.1f", "mean_latency_us", this->meanLatency());
+  STAT_LINE("%llu", "max_latency_us", this->maxLatency);
+  STAT_LINE("%g", "occupancy", this->occupancy);
+  STAT_LINE("%g", "peak_occupancy", this->peakOccupancy);
+  STAT_LINE("%llu", "swamps", this->swamps);
+  STAT_LINE("%llu", "dropped_bytes", this->dropped);
+  STAT_LINE("%llu", "syncs", this->syncs);
+  STAT_LINE("%llu", "sync_time_us", this->syncTime);
+  STAT_LINE("%llu", "max_sync_time_us", this->maxSyncTime);
+  STAT_LINE("%llu", "sync_errors", this->syncErrors);
+
+  // Bins are named after their lower bound
+  for (i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS; ++i) {
+    snprintf(
+          line,
+          sizeof(line),
+          "latency_%llu_us,%llu\n",
+          i == 0 ? 0ull : 1ull << (i - 1),
+          this->latency[i]);
+    csv += line;
+  }
+
+#undef STAT_LINE
+
+  return csv;
+}
+
+std::string
+DataSaverStats::toJson(void) const
+{
+  std::string json;
+  char line[128];
+  unsigned int i;
+
+#define STAT_LINE(fmt, name, value)                              \
+  snprintf(line, sizeof(line), "  \"%s\": " fmt ",\n", name, value); \
+  json += line
+
+  json += "{\n";
+  STAT_LINE("%llu", "commits", this->commits);
+  STAT_LINE("%llu", "bytes", this->bytes);
+  STAT_LINE("%llu", "elapsed_us", this->elapsed);
+  STAT_LINE("%.1f", "bytes_per_second", this->bytesPerSecond());
+  STAT_LINE("%llu", "write_time_us", this->writeTime);
+  STAT_LINE("%.1f", "mean_latency_us", this->meanLatency());
+  STAT_LINE("%llu", "max_latency_us", this->maxLatency);
+  STAT_LINE("%g", "occupancy", this->occupancy);
+  STAT_LINE("%g", "peak_occupancy", this->peakOccupancy);
+  STAT_LINE("%llu", "swamps", this->swamps);
+  STAT_LINE("%llu", "dropped_bytes", this->dropped);
+  STAT_LINE("%llu", "syncs", this->syncs);
+  STAT_LINE("%llu", "sync_time_us", this->syncTime);
+  STAT_LINE("%llu", "max_sync_time_us", this->maxSyncTime);
+  STAT_LINE("%llu", "sync_errors", this->syncErrors);
+
+#undef STAT_LINE
+
+  json += "  \"latency_histogram_us\": [";
+  for (i = 0; i < SIGDIGGER_DATASAVER_LATENCY_BINS; ++i) {
+    snprintf(
+          line,
+          sizeof(line),
+          "%s\n    {\"from\": %llu, \"count\": %llu}",
+          i == 0 ? "" : ",",
+          i == 0 ? 0ull : 1ull << (i - 1),
+          this->latency[i]);
+    json += line;
+  }
+  json += "\n  ]\n}\n";
+
+  return json;
+}
+
+bool
+DataSaverStats::saveToFile(std::string const &path) const
+{
+  std::string data;
+  FILE *fp;
+  bool ok;
+
+  if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0)
+    data = this->toJson();
+  else
+    data = this->toCsv();
+
+  if ((fp = fopen(path.c_str(), "w")) == nullptr)
+    return false;
+
+  ok = fwrite(data.c_str(), data.size(), 1, fp) == 1;
+
+  if (fclose(fp) != 0)
+    ok = false;
+
+  return ok;
+}
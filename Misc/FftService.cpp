@@ -0,0 +1,336 @@
+//
+//    FftService.cpp: Shared FFT plans and FFTW wisdom
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include "FftService.h"
+#include <util/confdb.h>
+#include <cstdio>
+#include <cstring>
+
+using namespace SigDigger;
+
+///////////////////////////////// FftPlan //////////////////////////////////////
+FftPlan::FftPlan(SU_FFTW(_plan) plan, size_t size)
+{
+  this->plan = plan;
+  this->size = size;
+}
+
+FftPlan::~FftPlan()
+{
+  FftService::getInstance()->destroyPlan(this->plan);
+}
+
+void
+FftPlan::execute(SU_FFTW(_complex) *buffer) const
+{
+  SU_FFTW(_execute_dft)(this->plan, buffer, buffer);
+}
+
+//////////////////////////////// FftService ////////////////////////////////////
+FftService *FftService::instance = nullptr;
+static std::once_flag instanceFlag;
+
+FftService::FftService()
+{
+  const char *confPath = suscan_confdb_get_local_path();
+
+#ifdef SIGDIGGER_HAVE_FFTW_THREADS
+  SU_FFTW(_init_threads)();
+  SU_FFTW(_make_planner_thread_safe)();
+#endif // SIGDIGGER_HAVE_FFTW_THREADS
+
+  if (confPath != nullptr) {
+    std::lock_guard<std::mutex> guard(this->plannerMutex);
+
+    this->wisdomPath =
+        std::string(confPath) + "/" + SIGDIGGER_FFT_WISDOM_FILE;
+
+    // Missing on the first run, nothing to worry about
+    (void) SU_FFTW(_import_wisdom_from_filename)(this->wisdomPath.c_str());
+  }
+
+  // libsuscan plans on its own threads with the same FFTW planner, which
+  // our lock does not cover. Measuring takes long enough to run into it,
+  // so it is only done when FFTW serializes planners by itself.
+#ifdef SIGDIGGER_HAVE_FFTW_THREADS
+  this->measurer = std::thread(&FftService::runMeasurer, this);
+#endif // SIGDIGGER_HAVE_FFTW_THREADS
+}
+
+FftService::~FftService()
+{
+  this->shutdown();
+}
+
+FftService *
+FftService::getInstance(void)
+{
+  // Tasks ask for plans from pool threads
+  std::call_once(
+        instanceFlag,
+        [] () {
+          instance = new FftService();
+        });
+
+  return instance;
+}
+
+SU_FFTW(_plan)
+FftService::makePlan(
+    Key const &key,
+    unsigned int flags,
+    SU_FFTW(_complex) *buffer)
+{
+  SU_FFTW(_complex) *scratch = nullptr;
+  SU_FFTW(_plan) plan = nullptr;
+
+  // Measuring overwrites the arrays: without a buffer to plan on, use one
+  // of our own. Plans work on any buffer from allocBuffer, as they share
+  // the same alignment.
+  if (buffer == nullptr) {
+    if ((scratch = allocBuffer(key.first)) == nullptr)
+      return nullptr;
+    buffer = scratch;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(this->plannerMutex);
+
+#ifdef SIGDIGGER_HAVE_FFTW_THREADS
+    unsigned int threads = std::thread::hardware_concurrency();
+
+    SU_FFTW(_plan_with_nthreads)(
+          key.first >= SIGDIGGER_FFT_THREADED_MIN_SIZE && threads > 1
+          ? static_cast<int>(threads)
+          : 1);
+#endif // SIGDIGGER_HAVE_FFTW_THREADS
+
+    plan = SU_FFTW(_plan_dft_1d)(
+          static_cast<int>(key.first),
+          buffer,
+          buffer,
+          key.second,
+          flags);
+
+#ifdef SIGDIGGER_HAVE_FFTW_THREADS
+    // Back to the default, for planners that do not set it themselves
+    SU_FFTW(_plan_with_nthreads)(1);
+#endif // SIGDIGGER_HAVE_FFTW_THREADS
+  }
+
+  if (scratch != nullptr)
+    freeBuffer(scratch);
+
+  return plan;
+}
+
+void
+FftService::runMeasurer(void)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  SU_FFTW(_plan) plan;
+  FftPlanPtr old;
+  Key key;
+
+  for (;;) {
+    this->cond.wait(
+          lock,
+          [this] () {
+            return !this->running || !this->pending.empty();
+          });
+
+    if (!this->running)
+      break;
+
+    key = this->pending.front();
+    this->pending.pop_front();
+
+    lock.unlock();
+    plan = this->makePlan(key, FFTW_MEASURE);
+    lock.lock();
+
+    if (plan != nullptr) {
+      Entry &entry = this->plans[key];
+
+      // Users of the old plan keep it until they are done
+      old = std::move(entry.plan);
+      entry.plan = std::make_shared<FftPlan>(plan, key.first);
+      entry.measured = true;
+      this->wisdomChanged = true;
+      old.reset();
+    }
+  }
+}
+
+FftPlanPtr
+FftService::getPlan(size_t size, int direction, SU_FFTW(_complex) *buffer)
+{
+  Key key(size, direction);
+  FftPlanPtr ptr;
+  SU_FFTW(_plan) plan;
+  bool measured = true;
+
+  {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    auto it = this->plans.find(key);
+
+    if (it != this->plans.end())
+      return it->second.plan;
+  }
+
+  // Measured in a previous session, it takes no time. Neither this nor
+  // FFTW_ESTIMATE touch the arrays, so the caller's buffer will do.
+  plan = this->makePlan(key, FFTW_MEASURE | FFTW_WISDOM_ONLY, buffer);
+
+  if (plan == nullptr) {
+    measured = false;
+    if ((plan = this->makePlan(key, FFTW_ESTIMATE, buffer)) == nullptr)
+      return nullptr;
+  }
+
+  ptr = std::make_shared<FftPlan>(plan, size);
+
+  {
+    std::lock_guard<std::mutex> guard(this->mutex);
+    Entry &entry = this->plans[key];
+
+    // Someone else got here first
+    if (entry.plan)
+      return entry.plan;
+
+    entry.plan = ptr;
+    entry.measured = measured;
+
+#ifdef SIGDIGGER_HAVE_FFTW_THREADS
+    if (!measured && size <= SIGDIGGER_FFT_MEASURE_MAX_SIZE) {
+      this->pending.push_back(key);
+      this->cond.notify_all();
+    }
+#endif // SIGDIGGER_HAVE_FFTW_THREADS
+  }
+
+  return ptr;
+}
+
+SU_FFTW(_complex) *
+FftService::allocBuffer(size_t size)
+{
+  return static_cast<SU_FFTW(_complex) *>(
+        SU_FFTW(_malloc)(size * sizeof(SU_FFTW(_complex))));
+}
+
+void
+FftService::freeBuffer(SU_FFTW(_complex) *buffer)
+{
+  SU_FFTW(_free)(buffer);
+}
+
+void
+FftService::destroyPlan(SU_FFTW(_plan) plan)
+{
+  std::lock_guard<std::mutex> guard(this->plannerMutex);
+
+  SU_FFTW(_destroy_plan)(plan);
+}
+
+void
+FftService::shutdown(void)
+{
+  {
+    std::lock_guard<std::mutex> guard(this->mutex);
+
+    this->running = false;
+    this->cond.notify_all();
+  }
+
+  // Waits for the current measurement, if any. It is short, as sizes are
+  // capped.
+  if (this->measurer.joinable())
+    this->measurer.join();
+
+  if (this->wisdomChanged && !this->wisdomPath.empty()) {
+    std::lock_guard<std::mutex> guard(this->plannerMutex);
+
+    if (!SU_FFTW(_export_wisdom_to_filename)(this->wisdomPath.c_str()))
+      fprintf(
+            stderr,
+            "warning: cannot save FFTW wisdom to %s\n",
+            this->wisdomPath.c_str());
+
+    this->wisdomChanged = false;
+  }
+}
+
+///////////////////////////////// FftBuffer ////////////////////////////////////
+FftBuffer::~FftBuffer()
+{
+  if (this->buffer != nullptr)
+    FftService::freeBuffer(this->buffer);
+}
+
+bool
+FftBuffer::allocate(size_t minSize, int direction)
+{
+  size_t size = 1;
+
+  while (size < minSize)
+    size <<= 1;
+
+  if (this->buffer != nullptr) {
+    FftService::freeBuffer(this->buffer);
+    this->buffer = nullptr;
+  }
+
+  this->size = 0;
+
+  if ((this->buffer = FftService::allocBuffer(size)) == nullptr)
+    return false;
+
+  // Planned on our own buffer, no scratch one needed
+  if ((this->plan = FftService::getInstance()->getPlan(
+         size,
+         direction,
+         this->buffer)) == nullptr) {
+    FftService::freeBuffer(this->buffer);
+    this->buffer = nullptr;
+    return false;
+  }
+
+  this->size = size;
+
+  return true;
+}
+
+void
+FftBuffer::load(const SUCOMPLEX *data, size_t len)
+{
+  if (len > this->size)
+    len = this->size;
+
+  memcpy(this->buffer, data, len * sizeof(SUCOMPLEX));
+  memset(
+        this->buffer + len,
+        0,
+        (this->size - len) * sizeof(SUCOMPLEX));
+}
+
+void
+FftBuffer::execute(void)
+{
+  this->plan->execute(this->buffer);
+}
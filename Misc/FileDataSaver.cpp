@@ -19,6 +19,9 @@
 
 #include "FileDataSaver.h"
 #include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <deque>
 
 using namespace SigDigger;
 
@@ -34,9 +37,61 @@ namespace SigDigger {
     bool canWrite(void) const;
     std::string getError(void) const;
     ssize_t write(const SUCOMPLEX *data, size_t len);
+    bool canSync(void) const;
+    bool sync(void);
     bool close(void);
     ~FileDataWriter();
   };
+
+  class SegmentedFileDataWriter : public GenericDataWriter {
+    FileDataSaver::SegmentParams params;
+    std::string lastError;
+
+    int fd = -1;
+    int nextFd = -1;
+    std::string currPath;
+    std::string nextPath;
+    unsigned int index = 0;
+
+    quint64 segmentLen = 0; // In samples
+    quint64 written = 0;    // Samples in current segment
+
+    std::deque<std::pair<std::string, quint64>> closedSegments;
+    quint64 closedSize = 0;
+
+    std::string segmentPath(unsigned int index) const;
+    int openSegment(std::string &path);
+    void preallocate(int fd) const;
+    bool rotate(void);
+    void enforceQuota(void);
+
+  public:
+    SegmentedFileDataWriter(FileDataSaver::SegmentParams const &params);
+
+    bool prepare(void);
+    bool canWrite(void) const;
+    std::string getError(void) const;
+    ssize_t write(const SUCOMPLEX *data, size_t len);
+    bool canSync(void) const;
+    bool sync(void);
+    bool close(void);
+    ~SegmentedFileDataWriter();
+  };
+}
+
+static bool
+syncFd(int fd, std::string &lastError)
+{
+#ifdef __linux__
+  if (fdatasync(fd) == -1) {
+#else
+  if (fsync(fd) == -1) {
+#endif // __linux__
+    lastError = "sync failed: " + std::string(strerror(errno));
+    return false;
+  }
+
+  return true;
 }
 
 std::string
@@ -78,6 +133,21 @@ FileDataWriter::write(const SUCOMPLEX *data, size_t len)
   return result / static_cast<ssize_t>(sizeof(*data));
 }
 
+bool
+FileDataWriter::canSync(void) const
+{
+  return true;
+}
+
+bool
+FileDataWriter::sync(void)
+{
+  if (this->fd == -1)
+    return true;
+
+  return syncFd(this->fd, this->lastError);
+}
+
 bool
 FileDataWriter::close(void)
 {
@@ -96,9 +166,228 @@ FileDataWriter::~FileDataWriter(void)
   this->close();
 }
 
+////////////////////////// SegmentedFileDataWriter /////////////////////////////
+SegmentedFileDataWriter::SegmentedFileDataWriter(
+    FileDataSaver::SegmentParams const &params) : params(params)
+{
+  quint64 len;
+
+  if (params.maxSize > 0)
+    this->segmentLen = params.maxSize / sizeof(SUCOMPLEX);
+
+  if (params.maxDuration > 0) {
+    len = params.maxDuration * params.sampRate;
+    if (len > 0 && (this->segmentLen == 0 || len < this->segmentLen))
+      this->segmentLen = len;
+  }
+}
+
+std::string
+SegmentedFileDataWriter::segmentPath(unsigned int index) const
+{
+  char number[16];
+
+  snprintf(number, sizeof(number), "_%04u", index);
+
+  return this->params.prefix + number + this->params.suffix;
+}
+
+int
+SegmentedFileDataWriter::openSegment(std::string &path)
+{
+  int fd;
+
+  path = this->segmentPath(++this->index);
+
+  if ((fd = creat(path.c_str(), 0600)) == -1)
+    this->lastError =
+        "Cannot create " + path + ": " + std::string(strerror(errno));
+  else
+    this->preallocate(fd);
+
+  return fd;
+}
+
+void
+SegmentedFileDataWriter::preallocate(int fd) const
+{
+  // Reserve the blocks of the whole segment in advance, so the filesystem
+  // does not have to look for free space while we are streaming into it.
+  // The apparent file size is left untouched.
+#ifdef __linux__
+  if (this->segmentLen > 0)
+    (void) fallocate(
+          fd,
+          FALLOC_FL_KEEP_SIZE,
+          0,
+          static_cast<off_t>(this->segmentLen * sizeof(SUCOMPLEX)));
+#else
+  (void) fd;
+#endif // __linux__
+}
+
+void
+SegmentedFileDataWriter::enforceQuota(void)
+{
+  quint64 reserved = this->segmentLen * sizeof(SUCOMPLEX);
+
+  if (this->params.quota == 0)
+    return;
+
+  while (!this->closedSegments.empty()
+         && this->closedSize + reserved > this->params.quota) {
+    auto &oldest = this->closedSegments.front();
+    (void) unlink(oldest.first.c_str());
+    this->closedSize -= oldest.second;
+    this->closedSegments.pop_front();
+  }
+}
+
+bool
+SegmentedFileDataWriter::rotate(void)
+{
+  int oldFd = this->fd;
+  quint64 size = this->written * sizeof(SUCOMPLEX);
+
+  // The next segment was opened in advance. If that failed, try again now.
+  if (this->nextFd == -1)
+    if ((this->nextFd = this->openSegment(this->nextPath)) == -1)
+      return false;
+
+  this->closedSegments.push_back(
+        std::pair<std::string, quint64>(this->currPath, size));
+  this->closedSize += size;
+
+  this->fd       = this->nextFd;
+  this->currPath = this->nextPath;
+  this->written  = 0;
+  this->nextFd   = -1;
+
+  (void) ftruncate(oldFd, static_cast<off_t>(size));
+  (void) ::close(oldFd);
+
+  this->enforceQuota();
+
+  // Failing here is not fatal: we will retry in the next rotation.
+  this->nextFd = this->openSegment(this->nextPath);
+
+  return true;
+}
+
+std::string
+SegmentedFileDataWriter::getError(void) const
+{
+  return this->lastError;
+}
+
+bool
+SegmentedFileDataWriter::prepare(void)
+{
+  if (this->fd == -1) {
+    if ((this->fd = this->openSegment(this->currPath)) == -1)
+      return false;
+
+    if (this->segmentLen > 0)
+      this->nextFd = this->openSegment(this->nextPath);
+  }
+
+  return true;
+}
+
+bool
+SegmentedFileDataWriter::canWrite(void) const
+{
+  return this->fd != -1;
+}
+
+ssize_t
+SegmentedFileDataWriter::write(const SUCOMPLEX *data, size_t len)
+{
+  ssize_t result;
+
+  if (this->fd == -1)
+    return 0;
+
+  if (this->segmentLen > 0) {
+    if (this->written >= this->segmentLen)
+      if (!this->rotate())
+        return 0;
+
+    if (len > this->segmentLen - this->written)
+      len = this->segmentLen - this->written;
+  }
+
+  result = ::write(this->fd, data, len * sizeof(*data));
+
+  if (result < 1) {
+    lastError = "write() failed: " + std::string(strerror(errno));
+    return result;
+  }
+
+  result /= static_cast<ssize_t>(sizeof(*data));
+  this->written += static_cast<quint64>(result);
+
+  return result;
+}
+
+bool
+SegmentedFileDataWriter::canSync(void) const
+{
+  return true;
+}
+
+// Rotated segments are left to the kernel, only the current one is synced
+bool
+SegmentedFileDataWriter::sync(void)
+{
+  if (this->fd == -1)
+    return true;
+
+  return syncFd(this->fd, this->lastError);
+}
+
+bool
+SegmentedFileDataWriter::close(void)
+{
+  bool ok = true;
+
+  if (this->fd != -1) {
+    // Release the preallocated blocks past the end of the last segment
+    (void) ftruncate(
+          this->fd,
+          static_cast<off_t>(this->written * sizeof(SUCOMPLEX)));
+    ok = ::close(this->fd) == 0;
+    this->fd = -1;
+  }
+
+  if (this->nextFd != -1) {
+    (void) ::close(this->nextFd);
+    (void) unlink(this->nextPath.c_str());
+    this->nextFd = -1;
+  }
+
+  return ok;
+}
+
+SegmentedFileDataWriter::~SegmentedFileDataWriter(void)
+{
+  this->close();
+}
+
 //////////////////////////// FileDataSaver /////////////////////////////////////
-FileDataSaver::FileDataSaver(int fd, QObject *parent) :
-  GenericDataSaver(this->writer = new FileDataWriter(fd), parent)
+FileDataSaver::FileDataSaver(int fd, QObject *parent, QThread *thread) :
+  GenericDataSaver(this->writer = new FileDataWriter(fd), parent, thread)
+{
+}
+
+FileDataSaver::FileDataSaver(
+    SegmentParams const &params,
+    QObject *parent,
+    QThread *thread) :
+  GenericDataSaver(
+    this->writer = new SegmentedFileDataWriter(params),
+    parent,
+    thread)
 {
 }
 
@@ -18,10 +18,30 @@
 //
 
 #include "GenericDataSaver.h"
+#include "PreRollBuffer.h"
 #include <unistd.h>
+#include <cstring>
 
 using namespace SigDigger;
 
+bool
+GenericDataWriter::canSync(void) const
+{
+  return false;
+}
+
+bool
+GenericDataWriter::sync(void)
+{
+  return true;
+}
+
+quint64
+GenericDataWriter::getDropped(void) const
+{
+  return 0;
+}
+
 GenericDataWriter::~GenericDataWriter()
 {
   // ?
@@ -30,6 +50,9 @@ GenericDataWriter::~GenericDataWriter()
 GenericDataWorker::GenericDataWorker(GenericDataSaver *instance)
 {
   this->instance = instance;
+
+  timerclear(&this->firstCommit);
+  timerclear(&this->lastSync);
 }
 
 
@@ -45,6 +68,113 @@ GenericDataWorker::onPrepare(void)
   }
 }
 
+bool
+GenericDataWorker::writeAll(const SUCOMPLEX *data, size_t len)
+{
+  ssize_t dumped;
+
+  while (len > 0) {
+    dumped = this->instance->writer->write(data, len);
+
+    if (dumped < 1) {
+      this->failed = true;
+      emit error(QString::fromStdString(this->instance->writer->getError()));
+      return false;
+    }
+
+    len  -= static_cast<size_t>(dumped);
+    data += dumped;
+  }
+
+  return true;
+}
+
+void
+GenericDataWorker::onFlushPreRoll(void)
+{
+  PreRollBuffer *preRoll = this->instance->preRoll;
+  const SUCOMPLEX *first, *second;
+  size_t firstLen, secondLen;
+
+  if (preRoll == nullptr)
+    return;
+
+  // Nobody touches the ring while it is frozen: no need to lock here
+  if (this->writerPrepared && !this->failed) {
+    preRoll->getSpans(first, firstLen, second, secondLen);
+
+    if (this->writeAll(first, firstLen))
+      (void) this->writeAll(second, secondLen);
+
+    QMutexLocker statsLocker(&this->instance->statsMutex);
+    this->instance->stats.bytes += (firstLen + secondLen) * sizeof(SUCOMPLEX);
+  }
+
+  this->instance->preRoll = nullptr;
+  preRoll->thaw();
+
+  this->instance->bufferReady = true;
+}
+
+void
+GenericDataWorker::syncWriter(struct timeval const &now)
+{
+  struct timeval tv, sub;
+  unsigned int interval = this->instance->syncInterval;
+  quint64 usec;
+  bool ok;
+
+  if (interval == 0 || !this->instance->writer->canSync())
+    return;
+
+  if (!timerisset(&this->lastSync)) {
+    this->lastSync = now;
+    return;
+  }
+
+  timersub(&now, &this->lastSync, &sub);
+  if (sub.tv_sec * 1000 + sub.tv_usec / 1000 < interval)
+    return;
+
+  ok = this->instance->writer->sync();
+
+  gettimeofday(&tv, nullptr);
+  timersub(&tv, &now, &sub);
+  usec = static_cast<quint64>(sub.tv_usec + sub.tv_sec * 1000000l);
+
+  this->lastSync = tv;
+
+  {
+    QMutexLocker statsLocker(&this->instance->statsMutex);
+    if (ok)
+      this->instance->stats.addSync(usec);
+    else
+      this->instance->stats.addSyncError();
+  }
+
+  // The kernel may have dropped the dirty pages it could not write back,
+  // so what is in the file is unknown: treat it like a write error.
+  if (!ok) {
+    this->failed = true;
+    emit error(
+          "Recording may be corrupt, "
+          + QString::fromStdString(this->instance->writer->getError()));
+  }
+}
+
+// Runs in the worker thread, leaves it ready to be deleted from the owner's
+void
+GenericDataWorker::onDetach(void)
+{
+  this->moveToThread(this->instance->thread());
+}
+
+// Queued behind all pending commits: once it runs, they are written
+void
+GenericDataWorker::onFlush(void)
+{
+}
+
 void
 GenericDataWorker::onCommit(void)
 {
@@ -54,31 +184,18 @@ GenericDataWorker::onCommit(void)
   } else if (!this->failed) {
     QMutexLocker locker(&this->instance->dataMutex);
     struct timeval tv, otv, sub;
-    ssize_t dumped;
     size_t allocation = this->instance->allocation;
     std::vector<SUCOMPLEX> *thisBuf =
         &this->instance->buffers[1 - this->instance->buffer];
     SUCOMPLEX *buffer = thisBuf->data();
-    int remaining = static_cast<int>(this->instance->commitedSize);
+    size_t remaining = this->instance->commitedSize;
 
     locker.unlock();
 
     gettimeofday(&otv, nullptr);
 
-    while (remaining > 0) {
-      dumped = this->instance->writer->write(
-            buffer,
-            static_cast<unsigned>(remaining));
-
-      if (dumped < 1) {
-        this->failed = true;
-        emit error(QString::fromStdString(this->instance->writer->getError()));
-        return;
-      }
-
-      remaining -= dumped;
-      buffer += dumped;
-    }
+    if (!this->writeAll(buffer, remaining))
+      return;
 
     gettimeofday(&tv, nullptr);
 
@@ -96,6 +213,26 @@ GenericDataWorker::onCommit(void)
     this->instance->bufferReady = true;
     timersub(&tv, &otv, &sub);
 
+    {
+      QMutexLocker statsLocker(&this->instance->statsMutex);
+      DataSaverStats &stats = this->instance->stats;
+      struct timeval elapsed;
+
+      if (!timerisset(&this->firstCommit))
+        this->firstCommit = otv;
+
+      timersub(&tv, &this->firstCommit, &elapsed);
+
+      ++stats.commits;
+      stats.bytes += remaining * sizeof(SUCOMPLEX);
+      stats.elapsed = static_cast<quint64>(
+            elapsed.tv_usec + elapsed.tv_sec * 1000000l);
+      stats.addLatency(static_cast<quint64>(
+            sub.tv_usec + sub.tv_sec * 1000000l));
+    }
+
+    this->syncWriter(tv);
+
     emit writeFinished(static_cast<quint64>(
           sub.tv_usec + sub.tv_sec * 1000000l));
   }
@@ -103,7 +240,11 @@ GenericDataWorker::onCommit(void)
 
 GenericDataSaver::GenericDataSaver(
     GenericDataWriter *writer,
-    QObject *parent) : QObject(parent), workerObject(this)
+    QObject *parent,
+    QThread *thread) :
+  QObject(parent),
+  workerObject(this),
+  syncInterval(SIGDIGGER_DATASAVER_SYNC_INTERVAL_MS)
 {
   this->writer = writer;
   this->setSampleRate(1000000);
@@ -120,6 +261,12 @@ GenericDataSaver::GenericDataSaver(
         &this->workerObject,
         SLOT(onCommit()));
 
+  QObject::connect(
+        this,
+        SIGNAL(flushPreRoll()),
+        &this->workerObject,
+        SLOT(onFlushPreRoll()));
+
   QObject::connect(
         &this->workerObject,
         SIGNAL(writeFinished(quint64)),
@@ -139,16 +286,31 @@ GenericDataSaver::GenericDataSaver(
         SLOT(onError(QString)));
 
   // Worker object will run somewhere else
-  this->workerObject.moveToThread(&this->workerThread);
-  this->workerThread.start();
+  if (thread != nullptr) {
+    this->workerHost = thread;
+    this->workerObject.moveToThread(this->workerHost);
+  } else {
+    this->workerHost = &this->workerThread;
+    this->workerObject.moveToThread(this->workerHost);
+    this->workerThread.start();
+  }
 
   emit prepare();
 }
 
 GenericDataSaver::~GenericDataSaver()
 {
-  this->workerThread.quit();
-  this->workerThread.wait();
+  if (this->workerHost == &this->workerThread) {
+    this->workerThread.quit();
+    this->workerThread.wait();
+  } else if (this->workerHost->isRunning()) {
+    // Shared thread: wait for pending commits and take the worker back.
+    // If the pool was already shut down, nothing runs the worker anymore.
+    QMetaObject::invokeMethod(
+          &this->workerObject,
+          "onDetach",
+          Qt::BlockingQueuedConnection);
+  }
 
   if (this->writer->canWrite()) {
     QMutexLocker locker(&this->dataMutex);
@@ -156,6 +318,17 @@ GenericDataSaver::~GenericDataSaver()
   }
 }
 
+void
+GenericDataSaver::flush(void)
+{
+  if (this->workerHost->isRunning()
+      && this->workerHost != QThread::currentThread())
+    QMetaObject::invokeMethod(
+          &this->workerObject,
+          "onFlush",
+          Qt::BlockingQueuedConnection);
+}
+
 // Protected by mutex
 void
 GenericDataSaver::doCommit(void)
@@ -172,12 +345,26 @@ GenericDataSaver::doCommit(void)
     this->writeTime = static_cast<quint64>(
               sub.tv_usec + sub.tv_sec * 1000000l);
 
+    {
+      QMutexLocker statsLocker(&this->statsMutex);
+      this->stats.addOccupancy(
+            static_cast<qreal>(this->ptr)
+            / static_cast<qreal>(this->buffers[this->buffer].size()));
+    }
+
     this->buffer = 1 - this->buffer;
     this->commitedSize = this->ptr;
     this->size += this->commitedSize;
     this->ptr = 0;
     this->bufferReady = false;
 
+    // Incomplete samples stay behind, at the beginning of the next buffer
+    if (this->tail > 0)
+      memcpy(
+        this->buffers[this->buffer].data(),
+        this->buffers[1 - this->buffer].data() + this->commitedSize,
+        this->tail);
+
     emit commit();
   }
 }
@@ -199,6 +386,33 @@ GenericDataSaver::setSampleRate(unsigned int rate)
   }
 }
 
+void
+GenericDataSaver::setPreRoll(PreRollBuffer *preRoll)
+{
+  const SUCOMPLEX *first, *second;
+  size_t firstLen, secondLen;
+  QMutexLocker locker(&this->dataMutex);
+
+  if (this->dataWritten || this->preRoll != nullptr)
+    return;
+
+  preRoll->getSpans(first, firstLen, second, secondLen);
+
+  // Incoming samples are held in the current buffer until the worker
+  // is done with the pre-roll, so they land after it.
+  this->preRoll = preRoll;
+  this->bufferReady = false;
+  this->size += firstLen + secondLen;
+
+  emit flushPreRoll();
+}
+
+void
+GenericDataSaver::setSyncInterval(unsigned int ms)
+{
+  this->syncInterval = ms;
+}
+
 void
 GenericDataSaver::setBufferSize(unsigned int size)
 {
@@ -207,27 +421,36 @@ GenericDataSaver::setBufferSize(unsigned int size)
 }
 
 void
-GenericDataSaver::write(const SUCOMPLEX *data, size_t size)
+GenericDataSaver::writeBytes(const void *data, size_t bytes)
 {
   if (this->writer->canWrite()) {
     QMutexLocker locker(&this->dataMutex);
     size_t totalSize = this->buffers[this->buffer].size();
-    size_t avail = totalSize - this->ptr;
+    size_t used = this->ptr * sizeof(SUCOMPLEX) + this->tail;
+    size_t avail = totalSize * sizeof(SUCOMPLEX) - used;
 
     this->dataWritten = true;
 
-    if (size > avail) {
+    if (bytes > avail) {
+      {
+        QMutexLocker statsLocker(&this->statsMutex);
+        ++this->stats.swamps;
+        this->stats.dropped += bytes;
+      }
+
       emit swamped();
       return;
     }
 
     // Copy data
     memcpy(
-      this->buffers[this->buffer].data() + this->ptr,
+      reinterpret_cast<uint8_t *>(this->buffers[this->buffer].data()) + used,
       data,
-      size * sizeof(SUCOMPLEX));
+      bytes);
 
-    this->ptr += size;
+    used += bytes;
+    this->ptr  = static_cast<unsigned int>(used / sizeof(SUCOMPLEX));
+    this->tail = used % sizeof(SUCOMPLEX);
 
     if (this->ptr > totalSize / 2) {
       // Buffer starts to get filled up, issue commit request
@@ -236,12 +459,45 @@ GenericDataSaver::write(const SUCOMPLEX *data, size_t size)
   }
 }
 
+void
+GenericDataSaver::write(const SUCOMPLEX *data, size_t size)
+{
+  this->writeBytes(data, size * sizeof(SUCOMPLEX));
+}
+
+void
+GenericDataSaver::write(const SUFLOAT *data, size_t size)
+{
+  this->writeBytes(data, size * sizeof(SUFLOAT));
+}
+
+void
+GenericDataSaver::write(const int16_t *data, size_t size)
+{
+  this->writeBytes(data, size * sizeof(int16_t));
+}
+
 quint64
 GenericDataSaver::getSize(void) const
 {
   return this->size;
 }
 
+DataSaverStats
+GenericDataSaver::getStats(void) const
+{
+  DataSaverStats stats;
+
+  {
+    QMutexLocker statsLocker(&this->statsMutex);
+    stats = this->stats;
+  }
+
+  stats.dropped += this->writer->getDropped();
+
+  return stats;
+}
+
 QString
 GenericDataSaver::getLastError(void) const
 {
@@ -0,0 +1,456 @@
+//
+//    MatlabWriter.cpp: Fast MATLAB / Octave text file writer
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "MatlabWriter.h"
+#include <Suscan/CancellableTask.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+using namespace SigDigger;
+
+// Powers of ten covering all the scales a float may need
+#define POW10_MIN -64
+#define POW10_MAX  64
+
+// Relative error of x * 10^k in double precision, with some margin
+#define SCALE_TOLERANCE 1e-15
+
+namespace {
+  struct Pow10Table {
+    double values[POW10_MAX - POW10_MIN + 1];
+
+    Pow10Table()
+    {
+      for (int i = POW10_MIN; i <= POW10_MAX; ++i)
+        this->values[i - POW10_MIN] = std::pow(10., i);
+    }
+
+    inline double
+    operator()(int exp) const
+    {
+      return this->values[exp - POW10_MIN];
+    }
+  };
+
+  const Pow10Table powersOfTen;
+
+  // Prints the n digit integer m, whose first digit weighs 10^e, like %g
+  char *
+  printDecimal(char *p, uint32_t m, unsigned int n, int e)
+  {
+    char digits[10];
+    unsigned int i;
+
+    // Rounding up may carry into a new digit (e.g. 9.99 -> 10)
+    if (m == static_cast<uint32_t>(powersOfTen(static_cast<int>(n)))) {
+      m /= 10;
+      ++e;
+    }
+
+    for (i = n; i-- > 0; m /= 10)
+      digits[i] = static_cast<char>('0' + m % 10);
+
+    while (n > 1 && digits[n - 1] == '0')
+      --n;
+
+    if (e >= -4 && e < 9) {
+      if (e >= 0) {
+        for (i = 0; i <= static_cast<unsigned int>(e); ++i)
+          *p++ = i < n ? digits[i] : '0';
+
+        if (n > i) {
+          *p++ = '.';
+          for (; i < n; ++i)
+            *p++ = digits[i];
+        }
+      } else {
+        *p++ = '0';
+        *p++ = '.';
+        for (i = 1; i < static_cast<unsigned int>(-e); ++i)
+          *p++ = '0';
+        for (i = 0; i < n; ++i)
+          *p++ = digits[i];
+      }
+    } else {
+      *p++ = digits[0];
+      if (n > 1) {
+        *p++ = '.';
+        for (i = 1; i < n; ++i)
+          *p++ = digits[i];
+      }
+
+      *p++ = 'e';
+      if (e < 0) {
+        *p++ = '-';
+        e = -e;
+      }
+
+      if (e >= 10)
+        *p++ = static_cast<char>('0' + e / 10);
+      *p++ = static_cast<char>('0' + e % 10);
+    }
+
+    return p;
+  }
+
+  bool
+  parsesBack(uint32_t m, unsigned int n, int e, float value)
+  {
+    char text[SIGDIGGER_MATLAB_FLOAT_MAX_LEN + 1];
+
+    *printDecimal(text, m, n, e) = '\0';
+
+    return strtof(text, nullptr) == value;
+  }
+}
+
+size_t
+MatlabWriter::formatFloat(char *buf, float value)
+{
+  char *p = buf;
+  float mag = std::fabs(value);
+  float down, up;
+  double x = mag;
+  double lo, hi, scale;
+  unsigned int n;
+  uint32_t bits, low, high, best;
+  int e;
+
+  if (std::isnan(value)) {
+    memcpy(p, "NaN", 3);
+    return 3;
+  }
+
+  if (std::signbit(value))
+    *p++ = '-';
+
+  if (std::isinf(value)) {
+    memcpy(p, "Inf", 3);
+    return static_cast<size_t>(p - buf) + 3;
+  }
+
+  if (mag == 0) {
+    *p++ = '0';
+    return static_cast<size_t>(p - buf);
+  }
+
+  // Any decimal strictly between the midpoints to the neighbouring floats
+  // is parsed back as value. These midpoints are exact in double precision.
+  memcpy(&bits, &mag, sizeof(float));
+  --bits;
+  memcpy(&down, &bits, sizeof(float));
+  bits += 2;
+  memcpy(&up, &bits, sizeof(float));
+
+  lo = .5 * (x + static_cast<double>(down));
+  hi = std::isinf(up) ? x + .5 * (x - down) : .5 * (x + up);
+
+  // Decimal exponent of the first significant digit. 1233 / 4096 ~ log10(2)
+  e = (std::ilogb(mag) * 1233) >> 12;
+  while (powersOfTen(e) > x)
+    --e;
+  while (powersOfTen(e + 1) <= x)
+    ++e;
+
+  // Work with nine significant digits, which always make it, and take
+  // the integers that fit between the midpoints. Then drop digits from
+  // the right while some number in that range still ends with zero.
+  scale = powersOfTen(8 - e);
+  x    *= scale;
+  lo   *= scale;
+  hi   *= scale;
+
+  low  = static_cast<uint32_t>(lo * (1 + SCALE_TOLERANCE)) + 1;
+  high = static_cast<uint32_t>(hi * (1 - SCALE_TOLERANCE));
+
+  // Right on a midpoint (ties go to even) or too close to tell
+  if (lo - (low - 1) <= lo * SCALE_TOLERANCE
+      && parsesBack(low - 1, 9, e, mag))
+    --low;
+  if ((high + 1) - hi <= hi * SCALE_TOLERANCE
+      && parsesBack(high + 1, 9, e, mag))
+    ++high;
+
+  for (n = 9; n > 1 && (low + 9) / 10 <= high / 10; --n) {
+    low   = (low + 9) / 10;
+    high /= 10;
+    x    *= .1;
+  }
+
+  // Of all candidates, the closest one
+  best = static_cast<uint32_t>(x + .5);
+  if (best < low)
+    best = low;
+  else if (best > high)
+    best = high;
+
+  p = printDecimal(p, best, n, e);
+
+  return static_cast<size_t>(p - buf);
+}
+
+MatlabWriter::MatlabWriter()
+{
+  unsigned int n = std::thread::hardware_concurrency();
+
+  if (n < 1)
+    n = 1;
+  else if (n > SIGDIGGER_MATLAB_MAX_THREADS)
+    n = SIGDIGGER_MATLAB_MAX_THREADS;
+
+  this->threads = n;
+}
+
+MatlabWriter::~MatlabWriter()
+{
+  this->close();
+}
+
+bool
+MatlabWriter::open(std::string const &path)
+{
+  this->close();
+
+  this->fp = fopen(path.c_str(), "wb");
+
+  return this->fp != nullptr;
+}
+
+bool
+MatlabWriter::close(void)
+{
+  bool ok = true;
+
+  if (this->fp != nullptr) {
+    ok = fclose(this->fp) == 0;
+    this->fp = nullptr;
+  }
+
+  // Format buffers can be quite big, do not keep them around
+  this->buffers.clear();
+
+  return ok;
+}
+
+bool
+MatlabWriter::isOpen(void) const
+{
+  return this->fp != nullptr;
+}
+
+void
+MatlabWriter::setProgressCallback(ProgressCallback const &cb)
+{
+  this->onProgress = cb;
+}
+
+uint64_t
+MatlabWriter::takeWorkerCpuTime(void)
+{
+  uint64_t time = this->workerCpuTime;
+
+  this->workerCpuTime = 0;
+
+  return time;
+}
+
+bool
+MatlabWriter::writeText(std::string const &text)
+{
+  if (this->fp == nullptr)
+    return false;
+
+  return fwrite(text.c_str(), 1, text.size(), this->fp) == text.size();
+}
+
+bool
+MatlabWriter::writeScalar(std::string const &name, double value)
+{
+  char num[32];
+
+  // Scalars are few: shortest %g that reads back as the same double
+  snprintf(num, sizeof(num), "%.15g", value);
+  if (strtod(num, nullptr) != value)
+    snprintf(num, sizeof(num), "%.17g", value);
+
+  return this->writeText(name + " = " + num + ";\n");
+}
+
+bool
+MatlabWriter::writeChunks(
+    size_t count,
+    size_t maxElementLen,
+    ChunkFormatter const &formatter)
+{
+  std::vector<std::thread> workers;
+  std::vector<size_t> lengths(this->threads);
+  std::vector<uint64_t> cpuTimes(this->threads, 0);
+  size_t written = 0;
+  size_t first, len, headLen;
+
+  if (this->fp == nullptr)
+    return false;
+
+  this->buffers.resize(this->threads);
+  for (auto &buffer : this->buffers)
+    buffer.resize(SIGDIGGER_MATLAB_CHUNK_ELEMENTS * maxElementLen);
+
+  while (written < count) {
+    unsigned int chunks = 0;
+
+    first = written;
+    headLen = std::min<size_t>(SIGDIGGER_MATLAB_CHUNK_ELEMENTS, count - first);
+
+    // One chunk per thread. The calling thread takes the first one.
+    workers.clear();
+    for (
+         chunks = 1, first += headLen;
+         chunks < this->threads && first < count;
+         ++chunks, first += len) {
+      char *buf = this->buffers[chunks].data();
+      size_t *result = &lengths[chunks];
+      uint64_t *cpuTime = &cpuTimes[chunks];
+      size_t start = first;
+
+      len = std::min<size_t>(SIGDIGGER_MATLAB_CHUNK_ELEMENTS, count - first);
+      workers.push_back(
+            std::thread(
+              [&formatter, buf, result, cpuTime, start, len] () {
+                *result = formatter(buf, start, len);
+                *cpuTime = Suscan::CancellableTask::threadCpuTime();
+              }));
+    }
+
+    lengths[0] = formatter(this->buffers[0].data(), written, headLen);
+
+    for (auto &worker : workers)
+      worker.join();
+
+    for (unsigned int i = 1; i < chunks; ++i)
+      this->workerCpuTime += cpuTimes[i];
+
+    // Chunks go to the file in order
+    for (unsigned int i = 0; i < chunks; ++i)
+      if (fwrite(this->buffers[i].data(), 1, lengths[i], this->fp)
+          != lengths[i])
+        return false;
+
+    written = first;
+
+    if (this->onProgress && !this->onProgress(written))
+      break;
+  }
+
+  return true;
+}
+
+bool
+MatlabWriter::writeComplex(
+    std::string const &name,
+    const SUCOMPLEX *data,
+    size_t len)
+{
+  if (!this->writeText(name + " = [ "))
+    return false;
+
+  if (!this->writeChunks(
+        len,
+        2 * SIGDIGGER_MATLAB_FLOAT_MAX_LEN + 6,
+        [data] (char *buf, size_t first, size_t count) {
+          char *p = buf;
+
+          for (size_t i = first; i < first + count; ++i) {
+            p += formatFloat(p, SU_C_REAL(data[i]));
+            memcpy(p, " + ", 3);
+            p += 3;
+            p += formatFloat(p, SU_C_IMAG(data[i]));
+            memcpy(p, "i, ", 3);
+            p += 3;
+          }
+
+          return static_cast<size_t>(p - buf);
+        }))
+    return false;
+
+  return this->writeText("];\n");
+}
+
+bool
+MatlabWriter::writeReal(
+    std::string const &name,
+    const SUFLOAT *data,
+    size_t len)
+{
+  if (!this->writeText(name + " = [ "))
+    return false;
+
+  if (!this->writeChunks(
+        len,
+        SIGDIGGER_MATLAB_FLOAT_MAX_LEN + 1,
+        [data] (char *buf, size_t first, size_t count) {
+          char *p = buf;
+
+          for (size_t i = first; i < first + count; ++i) {
+            p += formatFloat(p, data[i]);
+            *p++ = ' ';
+          }
+
+          return static_cast<size_t>(p - buf);
+        }))
+    return false;
+
+  return this->writeText("];\n");
+}
+
+bool
+MatlabWriter::writeColumns(
+    std::string const &name,
+    const SUCOMPLEX *data,
+    size_t len)
+{
+  if (!this->writeText(name + " = [\n"))
+    return false;
+
+  if (!this->writeChunks(
+        len,
+        2 * SIGDIGGER_MATLAB_FLOAT_MAX_LEN + 5,
+        [data] (char *buf, size_t first, size_t count) {
+          char *p = buf;
+
+          for (size_t i = first; i < first + count; ++i) {
+            *p++ = ' ';
+            *p++ = ' ';
+            p += formatFloat(p, SU_C_REAL(data[i]));
+            *p++ = ',';
+            *p++ = ' ';
+            p += formatFloat(p, SU_C_IMAG(data[i]));
+            *p++ = '\n';
+          }
+
+          return static_cast<size_t>(p - buf);
+        }))
+    return false;
+
+  return this->writeText("];\n");
+}
@@ -18,7 +18,10 @@
 //
 #include <MultitaskControllerModel.h>
 #include <SuWidgetsHelpers.h>
+#include <QApplication>
+#include <QPalette>
 #include <cmath>
+#include <cstdio>
 
 using namespace SigDigger;
 
@@ -41,6 +44,12 @@ MultitaskControllerModel::connectAll(void)
         this,
         SLOT(onListChanged(void)));
 
+  connect(
+        this->controller,
+        SIGNAL(taskStarted(int)),
+        this,
+        SLOT(onListChanged(void)));
+
   connect(
         this->controller,
         SIGNAL(taskDone(int)),
@@ -64,6 +73,12 @@ MultitaskControllerModel::connectAll(void)
         SIGNAL(taskProgress(int, qreal, QString)),
         this,
         SLOT(onProgress(int, qreal, QString)));
+
+  connect(
+        this->controller,
+        SIGNAL(taskFinished(Suscan::TaskTelemetry)),
+        this,
+        SLOT(onTaskFinished(Suscan::TaskTelemetry)));
 }
 
 int
@@ -75,7 +90,7 @@ MultitaskControllerModel::rowCount(const QModelIndex &) const
 int
 MultitaskControllerModel::columnCount(const QModelIndex &) const
 {
-  return 6;
+  return 7;
 }
 
 QVariant
@@ -107,11 +122,22 @@ MultitaskControllerModel::data(const QModelIndex &index, int role) const
             : "N/A";
 
       case 4:
-        return ctx->progressValue();
+        return ctx->eta() >= 0
+            ? SuWidgetsHelpers::formatQuantity(ctx->eta(), "s")
+            : "N/A";
 
       case 5:
+        return ctx->progressValue();
+
+      case 6:
         return QString("Cancel");
     }
+  } else if (role == Qt::ForegroundRole) {
+    // Queued tasks are greyed out until a pool thread picks them up
+    if (index.row() >= 0
+        && index.row() < this->taskVec.size()
+        && !this->taskVec[index.row()]->running())
+      return QApplication::palette().brush(QPalette::Disabled, QPalette::Text);
   }
 
   return QVariant();
@@ -126,16 +152,188 @@ MultitaskControllerModel::headerData(int s, Qt::Orientation hor, int role) const
       "Creation time",
       "Status",
       "Rate",
+      "ETA",
       "Progress",
       "Actions"};
 
-    if (s >= 0 && s < 6)
+    if (s >= 0 && s < 7)
       return headers[s];
   }
 
   return QVariant();
 }
 
+QList<Suscan::TaskTelemetry> const &
+MultitaskControllerModel::getHistory(void) const
+{
+  return this->history;
+}
+
+void
+MultitaskControllerModel::clearHistory(void)
+{
+  this->history.clear();
+  emit historyChanged();
+}
+
+static std::string
+csvQuote(QString const &text)
+{
+  QString quoted = text;
+
+  return "\"" + quoted.replace("\"", "\"\"").toStdString() + "\"";
+}
+
+static std::string
+jsonQuote(QString const &text)
+{
+  std::string utf8 = text.toStdString();
+  std::string quoted = "\"";
+  char hex[8];
+
+  for (auto c : utf8) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      snprintf(hex, sizeof(hex), "\\u%04x", c);
+      quoted += hex;
+    } else {
+      quoted += c;
+    }
+  }
+
+  return quoted + "\"";
+}
+
+static const char *
+priorityString(Suscan::TaskPriority priority)
+{
+  return priority == Suscan::TaskPriority::INTERACTIVE
+      ? "interactive"
+      : "background";
+}
+
+static const char *
+resourceString(Suscan::TaskResource resource)
+{
+  return resource == Suscan::TaskResource::DISK ? "disk" : "cpu";
+}
+
+static std::string
+dateString(QDateTime const &date)
+{
+  return date.isValid()
+      ? date.toString(Qt::ISODateWithMs).toStdString()
+      : std::string();
+}
+
+std::string
+MultitaskControllerModel::historyToCsv(void) const
+{
+  std::string csv;
+  char line[256];
+
+  csv += "title,outcome,priority,resource,created,started,queue_ms,wall_ms,"
+         "cpu_us,samples,bytes,mean_rate,peak_rate\n";
+
+  for (auto const &t : this->history) {
+    snprintf(
+          line,
+          sizeof(line),
+          ",%s,%s,%s,%s,%s,%lld,%lld,%llu,%llu,%llu,%.1f,%.1f\n",
+          Suscan::TaskTelemetry::outcomeString(t.outcome).toStdString().c_str(),
+          priorityString(t.priority),
+          resourceString(t.resource),
+          dateString(t.creationTime).c_str(),
+          dateString(t.startTime).c_str(),
+          static_cast<long long>(t.queueTime),
+          static_cast<long long>(t.wallTime),
+          static_cast<unsigned long long>(t.cpuTime),
+          static_cast<unsigned long long>(t.samples),
+          static_cast<unsigned long long>(t.bytes),
+          t.meanRate,
+          t.peakRate);
+
+    csv += csvQuote(t.title) + line;
+  }
+
+  return csv;
+}
+
+std::string
+MultitaskControllerModel::historyToJson(void) const
+{
+  std::string json;
+  char line[512];
+  bool first = true;
+
+  json += "[";
+
+  for (auto const &t : this->history) {
+    snprintf(
+          line,
+          sizeof(line),
+          ",\n"
+          "    \"outcome\": \"%s\",\n"
+          "    \"priority\": \"%s\",\n"
+          "    \"resource\": \"%s\",\n"
+          "    \"created\": \"%s\",\n"
+          "    \"started\": \"%s\",\n"
+          "    \"queue_ms\": %lld,\n"
+          "    \"wall_ms\": %lld,\n"
+          "    \"cpu_us\": %llu,\n"
+          "    \"samples\": %llu,\n"
+          "    \"bytes\": %llu,\n"
+          "    \"mean_rate\": %.1f,\n"
+          "    \"peak_rate\": %.1f\n"
+          "  }",
+          Suscan::TaskTelemetry::outcomeString(t.outcome).toStdString().c_str(),
+          priorityString(t.priority),
+          resourceString(t.resource),
+          dateString(t.creationTime).c_str(),
+          dateString(t.startTime).c_str(),
+          static_cast<long long>(t.queueTime),
+          static_cast<long long>(t.wallTime),
+          static_cast<unsigned long long>(t.cpuTime),
+          static_cast<unsigned long long>(t.samples),
+          static_cast<unsigned long long>(t.bytes),
+          t.meanRate,
+          t.peakRate);
+
+    json += first ? "\n" : ",\n";
+    json += "  {\n    \"title\": " + jsonQuote(t.title) + line;
+    first = false;
+  }
+
+  json += "\n]\n";
+
+  return json;
+}
+
+bool
+MultitaskControllerModel::saveHistory(std::string const &path) const
+{
+  std::string data;
+  FILE *fp;
+  bool ok;
+
+  if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0)
+    data = this->historyToJson();
+  else
+    data = this->historyToCsv();
+
+  if ((fp = fopen(path.c_str(), "w")) == nullptr)
+    return false;
+
+  ok = fwrite(data.c_str(), data.size(), 1, fp) == 1;
+
+  if (fclose(fp) != 0)
+    ok = false;
+
+  return ok;
+}
+
 ///////////////////////////////// Slots ///////////////////////////////////////
 void
 MultitaskControllerModel::onListChanged(void)
@@ -158,5 +356,16 @@ MultitaskControllerModel::onProgress(int index, qreal, QString)
 {
   emit dataChanged(
         createIndex(index, 0, nullptr),
-        createIndex(index, 3, nullptr));
+        createIndex(index, 4, nullptr));
+}
+
+void
+MultitaskControllerModel::onTaskFinished(Suscan::TaskTelemetry telemetry)
+{
+  this->history.push_back(telemetry);
+
+  while (this->history.size() > SIGDIGGER_TASK_HISTORY_LENGTH)
+    this->history.pop_front();
+
+  emit historyChanged();
 }
@@ -0,0 +1,161 @@
+//
+//    PreRollBuffer.cpp: Keep the last seconds of data before a recording
+//    Copyright (C) 2019 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "PreRollBuffer.h"
+#include "GenericDataSaver.h"
+#include <cstring>
+
+using namespace SigDigger;
+
+// Protected by mutex
+void
+PreRollBuffer::store(const SUCOMPLEX *data, size_t len)
+{
+  size_t size = this->ring.size();
+  size_t chunk;
+
+  // Only the last size samples survive
+  if (len > size) {
+    data += len - size;
+    len = size;
+  }
+
+  while (len > 0) {
+    chunk = size - this->ptr;
+    if (chunk > len)
+      chunk = len;
+
+    memcpy(this->ring.data() + this->ptr, data, chunk * sizeof(SUCOMPLEX));
+
+    data      += chunk;
+    len       -= chunk;
+    this->ptr += chunk;
+
+    if (this->ptr == size)
+      this->ptr = 0;
+
+    this->filled += chunk;
+  }
+
+  if (this->filled > size)
+    this->filled = size;
+}
+
+bool
+PreRollBuffer::setLength(size_t len)
+{
+  QMutexLocker locker(&this->mutex);
+
+  // The saver may still be reading from the ring.
+  if (this->frozen)
+    return false;
+
+  if (len != this->ring.size()) {
+    try {
+      std::vector<SUCOMPLEX>().swap(this->ring);
+      this->ring.resize(len);
+    } catch (std::bad_alloc &) {
+      this->ring.clear();
+    }
+
+    this->ptr = this->filled = 0;
+  }
+
+  return len == this->ring.size();
+}
+
+size_t
+PreRollBuffer::getLength(void) const
+{
+  return this->ring.size();
+}
+
+void
+PreRollBuffer::feed(const SUCOMPLEX *data, size_t len)
+{
+  QMutexLocker locker(&this->mutex);
+
+  if (this->saver != nullptr)
+    this->saver->write(data, len);
+
+  if (!this->frozen && !this->ring.empty())
+    this->store(data, len);
+}
+
+void
+PreRollBuffer::attach(GenericDataSaver *saver)
+{
+  QMutexLocker locker(&this->mutex);
+
+  this->saver = saver;
+
+  if (this->filled > 0 && !this->frozen) {
+    this->frozen = true;
+    saver->setPreRoll(this);
+  }
+}
+
+void
+PreRollBuffer::detach(void)
+{
+  QMutexLocker locker(&this->mutex);
+
+  this->saver = nullptr;
+}
+
+void
+PreRollBuffer::thaw(void)
+{
+  QMutexLocker locker(&this->mutex);
+
+  if (this->frozen) {
+    this->frozen = false;
+    this->ptr = this->filled = 0;
+  }
+}
+
+void
+PreRollBuffer::clear(void)
+{
+  QMutexLocker locker(&this->mutex);
+
+  if (!this->frozen)
+    this->ptr = this->filled = 0;
+}
+
+void
+PreRollBuffer::getSpans(
+    const SUCOMPLEX *&first,
+    size_t &firstLen,
+    const SUCOMPLEX *&second,
+    size_t &secondLen) const
+{
+  if (this->filled < this->ring.size()) {
+    // Ring did not wrap yet: everything is in [0, ptr)
+    first     = this->ring.data();
+    firstLen  = this->filled;
+    second    = nullptr;
+    secondLen = 0;
+  } else {
+    first     = this->ring.data() + this->ptr;
+    firstLen  = this->ring.size() - this->ptr;
+    second    = this->ring.data();
+    secondLen = this->ptr;
+  }
+}
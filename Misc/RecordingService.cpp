@@ -0,0 +1,220 @@
+//
+//    RecordingService.cpp: Shared writer threads for channel recordings
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "RecordingService.h"
+#include "GenericDataSaver.h"
+#include <cstdio>
+
+using namespace SigDigger;
+
+RecordingService *RecordingService::instance = nullptr;
+
+RecordingService::RecordingService()
+{
+}
+
+RecordingService *
+RecordingService::getInstance(void)
+{
+  if (instance == nullptr)
+    instance = new RecordingService();
+
+  return instance;
+}
+
+QThread *
+RecordingService::acquireThread(void)
+{
+  unsigned int i, best = 0;
+  unsigned int maxThreads = SIGDIGGER_RECORDING_SERVICE_MAX_THREADS;
+  int ideal = QThread::idealThreadCount();
+
+  if (this->down)
+    return nullptr;
+
+  if (ideal > 0 && static_cast<unsigned int>(ideal) < maxThreads)
+    maxThreads = static_cast<unsigned int>(ideal);
+
+  for (i = 1; i < this->threads.size(); ++i)
+    if (this->load[i] < this->load[best])
+      best = i;
+
+  if (this->threads.empty()
+      || (this->load[best] > 0 && this->threads.size() < maxThreads)) {
+    QThread *thread = new QThread();
+
+    thread->start();
+
+    this->threads.push_back(thread);
+    this->load.push_back(0);
+    best = static_cast<unsigned int>(this->threads.size() - 1);
+  }
+
+  return this->threads[best];
+}
+
+void
+RecordingService::registerSaver(
+    std::string const &name,
+    GenericDataSaver *saver,
+    QThread *thread)
+{
+  unsigned int i;
+
+  for (i = 0; i < this->threads.size(); ++i) {
+    if (this->threads[i] == thread) {
+      ++this->load[i];
+      this->channels.push_back(Channel{name, saver, i});
+      return;
+    }
+  }
+}
+
+void
+RecordingService::unregisterSaver(GenericDataSaver *saver)
+{
+  for (auto p = this->channels.begin(); p != this->channels.end(); ++p) {
+    if (p->saver == saver) {
+      --this->load[p->thread];
+      this->channels.erase(p);
+      return;
+    }
+  }
+}
+
+unsigned int
+RecordingService::getChannelCount(void) const
+{
+  return static_cast<unsigned int>(this->channels.size());
+}
+
+unsigned int
+RecordingService::getThreadCount(void) const
+{
+  return static_cast<unsigned int>(this->threads.size());
+}
+
+std::vector<RecordingService::ChannelStats>
+RecordingService::getChannelStats(void) const
+{
+  std::vector<ChannelStats> stats;
+
+  for (auto &ch : this->channels)
+    stats.push_back(ChannelStats{ch.name, ch.thread, ch.saver->getStats()});
+
+  return stats;
+}
+
+DataSaverStats
+RecordingService::getTotalStats(void) const
+{
+  DataSaverStats total;
+
+  for (auto &ch : this->channels)
+    total.merge(ch.saver->getStats());
+
+  return total;
+}
+
+bool
+RecordingService::saveStats(std::string const &path) const
+{
+  std::vector<ChannelStats> stats = this->getChannelStats();
+  DataSaverStats total = this->getTotalStats();
+  bool json;
+  FILE *fp;
+  bool ok;
+
+  json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+  if ((fp = fopen(path.c_str(), "w")) == nullptr)
+    return false;
+
+  if (json) {
+    fprintf(fp, "{\n\"channels\": [\n");
+    for (size_t i = 0; i < stats.size(); ++i)
+      fprintf(
+            fp,
+            "{\"name\": \"%s\", \"thread\": %u, \"stats\":\n%s}%s\n",
+            stats[i].name.c_str(),
+            stats[i].thread,
+            stats[i].stats.toJson().c_str(),
+            i + 1 < stats.size() ? "," : "");
+    fprintf(fp, "],\n\"total\":\n%s}\n", total.toJson().c_str());
+  } else {
+    fprintf(
+          fp,
+          "channel,thread,commits,bytes,bytes_per_second,mean_latency_us,"
+          "p99_latency_us,max_latency_us,peak_occupancy,swamps,"
+          "dropped_bytes,syncs,max_sync_time_us\n");
+
+    stats.push_back(ChannelStats{"total", 0, total});
+
+    for (auto &ch : stats)
+      fprintf(
+            fp,
+            "%s,%u,%llu,%llu,%.1f,%.1f,%llu,%llu,%g,%llu,%llu,%llu,%llu\n",
+            ch.name.c_str(),
+            ch.thread,
+            ch.stats.commits,
+            ch.stats.bytes,
+            ch.stats.bytesPerSecond(),
+            ch.stats.meanLatency(),
+            ch.stats.latencyPercentile(.99),
+            ch.stats.maxLatency,
+            ch.stats.peakOccupancy,
+            ch.stats.swamps,
+            ch.stats.dropped,
+            ch.stats.syncs,
+            ch.stats.maxSyncTime);
+  }
+
+  ok = !ferror(fp);
+
+  if (fclose(fp) != 0)
+    ok = false;
+
+  return ok;
+}
+
+void
+RecordingService::shutdown(void)
+{
+  if (this->down)
+    return;
+
+  this->down = true;
+
+  for (auto &ch : this->channels)
+    ch.saver->flush();
+
+  // Thread objects stay around: savers not yet deleted refer to them
+  for (auto thread : this->threads) {
+    thread->quit();
+    thread->wait();
+  }
+}
+
+RecordingService::~RecordingService()
+{
+  this->shutdown();
+
+  for (auto thread : this->threads)
+    delete thread;
+}
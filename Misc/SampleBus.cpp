@@ -0,0 +1,174 @@
+//
+//    SampleBus.cpp: Zero-copy distribution of inspector samples
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SampleBus.h"
+#include <Suscan/Messages/SamplesMessage.h>
+
+using namespace SigDigger;
+
+/////////////////////////////// SampleBuffer ///////////////////////////////////
+SampleBuffer::SampleBuffer()
+{
+}
+
+SampleBuffer::SampleBuffer(Suscan::SamplesMessage const &msg)
+{
+  // Copying the message only takes a reference to the suscan message
+  this->owner = std::make_shared<Suscan::SamplesMessage>(msg);
+  this->ptr   = msg.getSamples();
+  this->len   = msg.getCount();
+}
+
+SampleBuffer::SampleBuffer(std::vector<SUCOMPLEX> &&data)
+{
+  auto vec = std::make_shared<std::vector<SUCOMPLEX>>(std::move(data));
+
+  this->ptr   = vec->data();
+  this->len   = vec->size();
+  this->owner = vec;
+}
+
+SampleBuffer::SampleBuffer(
+    std::shared_ptr<const std::vector<SUCOMPLEX>> const &data)
+{
+  if (data) {
+    this->owner = data;
+    this->ptr   = data->data();
+    this->len   = data->size();
+  }
+}
+
+SampleBuffer
+SampleBuffer::slice(size_t offset, size_t len) const
+{
+  SampleBuffer result;
+
+  if (offset > this->len)
+    offset = this->len;
+
+  if (len > this->len - offset)
+    len = this->len - offset;
+
+  result.owner = this->owner;
+  result.ptr   = this->ptr + offset;
+  result.len   = len;
+
+  return result;
+}
+
+////////////////////////////// SampleConsumer //////////////////////////////////
+SampleConsumer::~SampleConsumer()
+{
+}
+
+//////////////////////////////// SampleBus /////////////////////////////////////
+SampleBus *SampleBus::instance = nullptr;
+
+SampleBus::SampleBus()
+{
+}
+
+SampleBus *
+SampleBus::getInstance(void)
+{
+  if (instance == nullptr)
+    instance = new SampleBus();
+
+  return instance;
+}
+
+void
+SampleBus::subscribe(Suscan::InspectorId id, SampleConsumer *consumer)
+{
+  auto range = this->consumers.equal_range(id);
+
+  for (auto p = range.first; p != range.second; ++p)
+    if (p->second == consumer)
+      return;
+
+  this->consumers.insert(std::make_pair(id, consumer));
+}
+
+void
+SampleBus::unsubscribe(Suscan::InspectorId id, SampleConsumer *consumer)
+{
+  auto range = this->consumers.equal_range(id);
+
+  for (auto p = range.first; p != range.second; ++p)
+    if (p->second == consumer) {
+      this->consumers.erase(p);
+      break;
+    }
+
+  this->forget(consumer, &id);
+}
+
+// Consumers removed while a buffer is being delivered must not get it:
+// they may be gone by the time their turn comes
+void
+SampleBus::forget(SampleConsumer *consumer, const Suscan::InspectorId *id)
+{
+  for (auto dispatch : this->dispatches)
+    if (id == nullptr || dispatch->id == *id)
+      for (auto &target : dispatch->targets)
+        if (target == consumer)
+          target = nullptr;
+}
+
+void
+SampleBus::unsubscribe(SampleConsumer *consumer)
+{
+  auto p = this->consumers.begin();
+
+  while (p != this->consumers.end()) {
+    if (p->second == consumer)
+      p = this->consumers.erase(p);
+    else
+      ++p;
+  }
+
+  this->forget(consumer, nullptr);
+}
+
+unsigned int
+SampleBus::publish(Suscan::InspectorId id, SampleBuffer const &buffer)
+{
+  Dispatch dispatch;
+  auto range = this->consumers.equal_range(id);
+  unsigned int count = 0;
+
+  // Consumers may (un)subscribe while consuming, work on a snapshot that
+  // unsubscribe() keeps up to date
+  dispatch.id = id;
+  for (auto p = range.first; p != range.second; ++p)
+    dispatch.targets.push_back(p->second);
+
+  this->dispatches.push_back(&dispatch);
+
+  for (size_t i = 0; i < dispatch.targets.size(); ++i) {
+    if (dispatch.targets[i] != nullptr) {
+      dispatch.targets[i]->consume(buffer);
+      ++count;
+    }
+  }
+
+  this->dispatches.pop_back();
+
+  return count;
+}
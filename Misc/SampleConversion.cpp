@@ -0,0 +1,97 @@
+//
+//    SampleConversion.cpp: Vectorizable sample format conversions
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SampleConversion.h"
+#include <cmath>
+
+using namespace SigDigger;
+
+#define SIGDIGGER_INT16_SCALE 32767.f
+
+size_t
+SigDigger::realSampleSize(RealSampleFormat format)
+{
+  switch (format) {
+    case REAL_SAMPLE_FORMAT_FLOAT32:
+      return sizeof(float);
+
+    case REAL_SAMPLE_FORMAT_INT16:
+      return sizeof(int16_t);
+
+    default:
+      return sizeof(SUCOMPLEX);
+  }
+}
+
+SIGDIGGER_VECTORIZE void
+SigDigger::phaseToReal(
+    SUFLOAT *__restrict out,
+    const SUCOMPLEX *__restrict in,
+    size_t len)
+{
+  const SUFLOAT *iq = reinterpret_cast<const SUFLOAT *>(in);
+
+  for (size_t i = 0; i < len; ++i) {
+    // arg(I * (a + Ib)) = atan2(a, -b)
+    SUFLOAT y  = iq[2 * i];
+    SUFLOAT x  = -iq[2 * i + 1];
+    SUFLOAT ax = x < 0 ? -x : x;
+    SUFLOAT ay = y < 0 ? -y : y;
+    SUFLOAT mx = ax > ay ? ax : ay;
+    SUFLOAT mn = ax > ay ? ay : ax;
+    SUFLOAT a  = mn / (mx > 0 ? mx : 1);
+    SUFLOAT s  = a * a;
+    SUFLOAT r;
+
+    // Abramowitz & Stegun 4.4.49: atan(a) for 0 <= a <= 1, |e| <= 2e-8
+    r = static_cast<SUFLOAT>(-0.0040540580);
+    r = r * s + static_cast<SUFLOAT>(0.0218612288);
+    r = r * s - static_cast<SUFLOAT>(0.0559098861);
+    r = r * s + static_cast<SUFLOAT>(0.0964200441);
+    r = r * s - static_cast<SUFLOAT>(0.1390853351);
+    r = r * s + static_cast<SUFLOAT>(0.1994653599);
+    r = r * s - static_cast<SUFLOAT>(0.3332985605);
+    r = r * s + static_cast<SUFLOAT>(0.9999993329);
+    r *= a;
+
+    // Back to the full circle
+    r = ay > ax ? static_cast<SUFLOAT>(PI / 2) - r : r;
+    r = x < 0   ? static_cast<SUFLOAT>(PI) - r : r;
+    r = y < 0   ? -r : r;
+
+    out[i] = r * static_cast<SUFLOAT>(1. / PI);
+  }
+}
+
+SIGDIGGER_VECTORIZE void
+SigDigger::realToInt16(
+    int16_t *__restrict out,
+    const SUFLOAT *__restrict in,
+    size_t len)
+{
+  for (size_t i = 0; i < len; ++i) {
+    SUFLOAT v = in[i] * SIGDIGGER_INT16_SCALE;
+
+    v = v >  SIGDIGGER_INT16_SCALE ?  SIGDIGGER_INT16_SCALE : v;
+    v = v < -SIGDIGGER_INT16_SCALE ? -SIGDIGGER_INT16_SCALE : v;
+    v += v < 0 ? static_cast<SUFLOAT>(-.5) : static_cast<SUFLOAT>(.5);
+
+    out[i] = static_cast<int16_t>(v);
+  }
+}
@@ -60,11 +60,47 @@ SigDiggerHelpers::pkgversion(void)
 
 
 
+QStringList
+SigDiggerHelpers::sampleFileFilters(void)
+{
+  QStringList filters;
+
+  filters << "MATLAB/Octave script (*.m)"
+          << "MATLAB 5.0 MAT-file (*.mat)"
+          << "Audio file (*.wav)"
+          << "NumPy array (*.npy)"
+          << "Raw complex float32 (*.cf32)"
+          << "Raw complex int16 (*.cs16)"
+          << "SigMF recording (*.sigmf-data)";
+
+  return filters;
+}
+
+QString
+SigDiggerHelpers::sampleFileExtension(QString const &filter)
+{
+  QString extension = filter.mid(filter.lastIndexOf("*.") + 2);
+
+  extension.chop(1);
+
+  return extension;
+}
+
+QString
+SigDiggerHelpers::sampleFileFormat(QString const &filter)
+{
+  QString extension = sampleFileExtension(filter);
+
+  if (extension == "sigmf-data")
+    return "sigmf";
+
+  return extension;
+}
+
 void
 SigDiggerHelpers::openSaveSamplesDialog(
     QWidget *root,
-    const SUCOMPLEX *data,
-    size_t length,
+    SampleBuffer const &data,
     qreal fs,
     int start,
     int end,
@@ -74,40 +110,31 @@ SigDiggerHelpers::openSaveSamplesDialog(
 
   do {
     QFileDialog dialog(root);
-    QStringList filters;
     QString format;
 
     dialog.setFileMode(QFileDialog::FileMode::AnyFile);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
     dialog.setWindowTitle(QString("Save capture"));
 
-    filters << "MATLAB/Octave script (*.m)"
-            << "MATLAB 5.0 MAT-file (*.mat)"
-            << "Audio file (*.wav)";
-
-    dialog.setNameFilters(filters);
+    dialog.setNameFilters(sampleFileFilters());
 
     if (dialog.exec()) {
       QString path = dialog.selectedFiles().first();
       QString filter = dialog.selectedNameFilter();
       ExportSamplesTask *task;
 
-      if (strstr(filter.toStdString().c_str(), ".mat") != nullptr)
-        format = "mat";
-      else if (strstr(filter.toStdString().c_str(), ".m") != nullptr)
-        format = "m";
-      else
-        format = "wav";
-
-      path = SuWidgetsHelpers::ensureExtension(path, format);
+      format = sampleFileFormat(filter);
+      path = SuWidgetsHelpers::ensureExtension(
+            path,
+            sampleFileExtension(filter));
 
-      task = new ExportSamplesTask(path, format, data, length, fs, start, end);
+      task = new ExportSamplesTask(path, format, data, fs, start, end);
 
       if (!task->attemptOpen()) {
         QMessageBox::critical(
               root,
-              task->getLastError(),
-              "Save samples to file");
+              "Save samples to file",
+              task->getLastError());
         delete task;
       } else {
         QFileInfo info(path);
@@ -115,7 +142,10 @@ SigDiggerHelpers::openSaveSamplesDialog(
         // TODO: Decide whether to send to multitask controller or to
         // run in the current thread according to data size.
 
-        mt->pushTask(task, "Save samples to " + info.fileName());
+        mt->pushTask(
+              task,
+              "Save samples to " + info.fileName(),
+              Suscan::TaskPriority::INTERACTIVE);
         done = true;
       }
     } else {
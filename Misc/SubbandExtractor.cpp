@@ -0,0 +1,346 @@
+//
+//    SubbandExtractor.cpp: Record a single channel of the source
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SubbandExtractor.h"
+#include "GenericDataSaver.h"
+#include "SampleConversion.h"
+#include <cstring>
+#include <cmath>
+
+// Input buffered per half of the double buffer, and handed to the worker
+#define SIGDIGGER_SUBBAND_BUFFER_MS 500
+#define SIGDIGGER_SUBBAND_CHUNK_MS  50
+
+using namespace SigDigger;
+
+///////////////////////////////// SubbandDDC ///////////////////////////////////
+unsigned int
+SubbandDDC::decimationFor(SUFLOAT sampRate, SUFLOAT bandwidth)
+{
+  SUFLOAT ratio;
+
+  if (bandwidth <= 0)
+    return 1;
+
+  ratio = sampRate / static_cast<SUFLOAT>(
+        bandwidth * SIGDIGGER_SUBBAND_OVERSAMPLING);
+
+  return ratio < 2 ? 1 : static_cast<unsigned int>(ratio);
+}
+
+void
+SubbandDDC::configure(Params const &params)
+{
+  unsigned int i, len, padded;
+  SUDOUBLE fc, t, w, h, sum = 0;
+  std::vector<SUDOUBLE> proto;
+
+  this->decimation = decimationFor(params.sampRate, params.bandwidth);
+
+  // Cut at half the output rate: the band of interest is narrower than
+  // that, and the transition band folds outside the channel.
+  len = this->decimation == 1
+      ? 1
+      : this->decimation * SIGDIGGER_SUBBAND_TAPS_PER_PHASE + 1;
+  fc  = .5 / this->decimation;
+
+  proto.resize(len);
+  for (i = 0; i < len; ++i) {
+    t = i - .5 * (len - 1);
+    h = t == 0 ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+
+    // Blackman window
+    w = len == 1
+        ? 1
+        : .42
+          - .5  * cos(2 * M_PI * i / (len - 1))
+          + .08 * cos(4 * M_PI * i / (len - 1));
+
+    proto[i] = h * w;
+    sum += proto[i];
+  }
+
+  // Zero taps in front, so the dot product works in whole NCO lanes
+  padded = (len + SIGDIGGER_SUBBAND_NCO_LANES - 1)
+      / SIGDIGGER_SUBBAND_NCO_LANES
+      * SIGDIGGER_SUBBAND_NCO_LANES;
+
+  // The filter is symmetric, no need to reverse it for the convolution
+  this->taps.assign(2 * padded, 0);
+  for (i = 0; i < len; ++i) {
+    SUFLOAT tap = static_cast<SUFLOAT>(proto[i] / sum);
+    this->taps[2 * (padded - len + i)]     = tap;
+    this->taps[2 * (padded - len + i) + 1] = tap;
+  }
+
+  this->omega = -2 * M_PI * params.offset / params.sampRate;
+
+  this->reset();
+}
+
+void
+SubbandDDC::reset(void)
+{
+  size_t len = this->taps.size() / 2;
+
+  this->line.assign(len - 1, 0);
+  this->next  = len - 1;
+  this->phase = 0;
+}
+
+SIGDIGGER_VECTORIZE void
+SubbandDDC::mix(
+    SUCOMPLEX *__restrict out,
+    const SUCOMPLEX *__restrict in,
+    size_t len)
+{
+  SUFLOAT lr[SIGDIGGER_SUBBAND_NCO_LANES];
+  SUFLOAT li[SIGDIGGER_SUBBAND_NCO_LANES];
+  SUFLOAT wr, wi, re;
+  size_t block, i, j, p = 0;
+
+  while (p < len) {
+    const SUFLOAT *x = reinterpret_cast<const SUFLOAT *>(in + p);
+    SUFLOAT *y = reinterpret_cast<SUFLOAT *>(out + p);
+
+    block = len - p;
+    if (block > SIGDIGGER_SUBBAND_NCO_BLOCK)
+      block = SIGDIGGER_SUBBAND_NCO_BLOCK;
+
+    // Resync the lanes with the double precision phase accumulator, so
+    // rounding errors never build up and the phase stays continuous
+    // across blocks and calls.
+    for (j = 0; j < SIGDIGGER_SUBBAND_NCO_LANES; ++j) {
+      lr[j] = static_cast<SUFLOAT>(cos(this->phase + this->omega * j));
+      li[j] = static_cast<SUFLOAT>(sin(this->phase + this->omega * j));
+    }
+
+    wr = static_cast<SUFLOAT>(
+          cos(this->omega * SIGDIGGER_SUBBAND_NCO_LANES));
+    wi = static_cast<SUFLOAT>(
+          sin(this->omega * SIGDIGGER_SUBBAND_NCO_LANES));
+
+    for (i = 0; i + SIGDIGGER_SUBBAND_NCO_LANES <= block;
+         i += SIGDIGGER_SUBBAND_NCO_LANES) {
+      for (j = 0; j < SIGDIGGER_SUBBAND_NCO_LANES; ++j) {
+        SUFLOAT a = x[2 * (i + j)];
+        SUFLOAT b = x[2 * (i + j) + 1];
+
+        y[2 * (i + j)]     = a * lr[j] - b * li[j];
+        y[2 * (i + j) + 1] = a * li[j] + b * lr[j];
+      }
+
+      for (j = 0; j < SIGDIGGER_SUBBAND_NCO_LANES; ++j) {
+        re    = lr[j] * wr - li[j] * wi;
+        li[j] = lr[j] * wi + li[j] * wr;
+        lr[j] = re;
+      }
+    }
+
+    for (j = 0; i < block; ++i, ++j) {
+      SUFLOAT a = x[2 * i];
+      SUFLOAT b = x[2 * i + 1];
+
+      y[2 * i]     = a * lr[j] - b * li[j];
+      y[2 * i + 1] = a * li[j] + b * lr[j];
+    }
+
+    this->phase = fmod(this->phase + this->omega * block, 2 * M_PI);
+    p += block;
+  }
+}
+
+SIGDIGGER_VECTORIZE static SUCOMPLEX
+firDot(
+    const SUFLOAT *__restrict taps,
+    const SUFLOAT *__restrict x,
+    size_t len)
+{
+  SUFLOAT acc[2 * SIGDIGGER_SUBBAND_NCO_LANES] = {0};
+  SUFLOAT re = 0, im = 0;
+  size_t i, j;
+
+  // Taps are interleaved like the samples: even lanes accumulate the
+  // real part and odd lanes the imaginary part.
+  for (i = 0; i < len; i += 2 * SIGDIGGER_SUBBAND_NCO_LANES)
+    for (j = 0; j < 2 * SIGDIGGER_SUBBAND_NCO_LANES; ++j)
+      acc[j] += taps[i + j] * x[i + j];
+
+  for (j = 0; j < 2 * SIGDIGGER_SUBBAND_NCO_LANES; j += 2) {
+    re += acc[j];
+    im += acc[j + 1];
+  }
+
+  return SUCOMPLEX(re, im);
+}
+
+void
+SubbandDDC::feed(
+    const SUCOMPLEX *data,
+    size_t len,
+    std::vector<SUCOMPLEX> &out)
+{
+  size_t taps = this->taps.size() / 2;
+  size_t keep = this->line.size();
+  size_t drop;
+
+  this->line.resize(keep + len);
+  this->mix(this->line.data() + keep, data, len);
+
+  while (this->next < this->line.size()) {
+    out.push_back(
+          firDot(
+            this->taps.data(),
+            reinterpret_cast<const SUFLOAT *>(
+              this->line.data() + this->next + 1 - taps),
+            2 * taps));
+    this->next += this->decimation;
+  }
+
+  // Keep the samples the next outputs still need
+  drop = this->line.size() - (taps - 1);
+  this->line.erase(this->line.begin(), this->line.begin() + drop);
+  this->next -= drop;
+}
+
+/////////////////////////////// SubbandWorker //////////////////////////////////
+SubbandWorker::SubbandWorker(SubbandExtractor *instance)
+{
+  this->instance = instance;
+}
+
+void
+SubbandWorker::onProcess(void)
+{
+  QMutexLocker saverLocker(&this->instance->saverMutex);
+  const SUCOMPLEX *data;
+  size_t len;
+
+  {
+    QMutexLocker locker(&this->instance->dataMutex);
+    data = this->instance->buffers[1 - this->instance->buffer].data();
+    len  = this->instance->committed;
+  }
+
+  if (this->instance->saver != nullptr) {
+    this->output.clear();
+    this->instance->ddc.feed(data, len, this->output);
+    this->instance->saver->write(this->output.data(), this->output.size());
+  }
+
+  QMutexLocker locker(&this->instance->dataMutex);
+  this->instance->workerReady = true;
+}
+
+////////////////////////////// SubbandExtractor ////////////////////////////////
+SubbandExtractor::SubbandExtractor(QObject *parent) :
+  QObject(parent),
+  workerObject(this)
+{
+  QObject::connect(
+        this,
+        SIGNAL(process()),
+        &this->workerObject,
+        SLOT(onProcess()));
+
+  this->workerObject.moveToThread(&this->workerThread);
+  this->workerThread.start();
+}
+
+SubbandExtractor::~SubbandExtractor(void)
+{
+  this->detach();
+
+  this->workerThread.quit();
+  this->workerThread.wait();
+}
+
+void
+SubbandExtractor::attach(
+    GenericDataSaver *saver,
+    SubbandDDC::Params const &params)
+{
+  QMutexLocker saverLocker(&this->saverMutex);
+  QMutexLocker locker(&this->dataMutex);
+  size_t size = static_cast<size_t>(
+        params.sampRate * SIGDIGGER_SUBBAND_BUFFER_MS / 1000);
+
+  this->ddc.configure(params);
+
+  this->buffers[0].resize(size);
+  this->buffers[1].resize(size);
+
+  this->chunk       = size * SIGDIGGER_SUBBAND_CHUNK_MS
+      / SIGDIGGER_SUBBAND_BUFFER_MS;
+  this->buffer      = 0;
+  this->ptr         = 0;
+  this->committed   = 0;
+  this->workerReady = true;
+  this->overflow    = false;
+  this->saver       = saver;
+}
+
+void
+SubbandExtractor::detach(void)
+{
+  QMutexLocker saverLocker(&this->saverMutex);
+  QMutexLocker locker(&this->dataMutex);
+
+  this->saver = nullptr;
+
+  std::vector<SUCOMPLEX>().swap(this->buffers[0]);
+  std::vector<SUCOMPLEX>().swap(this->buffers[1]);
+}
+
+bool
+SubbandExtractor::isAttached(void) const
+{
+  return this->saver != nullptr;
+}
+
+void
+SubbandExtractor::feed(const SUCOMPLEX *data, size_t len)
+{
+  QMutexLocker locker(&this->dataMutex);
+
+  if (this->saver == nullptr || this->overflow)
+    return;
+
+  if (len > this->buffers[this->buffer].size() - this->ptr) {
+    // The worker cannot keep up. Stop here, until the saver goes away.
+    this->overflow = true;
+    emit swamped();
+    return;
+  }
+
+  memcpy(
+        this->buffers[this->buffer].data() + this->ptr,
+        data,
+        len * sizeof(SUCOMPLEX));
+  this->ptr += len;
+
+  if (this->ptr >= this->chunk && this->workerReady) {
+    this->committed   = this->ptr;
+    this->buffer      = 1 - this->buffer;
+    this->ptr         = 0;
+    this->workerReady = false;
+
+    emit process();
+  }
+}
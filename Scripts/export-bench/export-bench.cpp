@@ -0,0 +1,219 @@
+//
+//    export-bench.cpp: Throughput benchmark of the sample export formats
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <ExportSamplesTask.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace SigDigger;
+
+// 32 MiB of complex samples, several export blocks
+#define EXPORT_BENCH_DEFAULT_SAMPLES (1 << 22)
+#define EXPORT_BENCH_SAMPLE_RATE     250000.
+
+struct ExportBenchFormat {
+  const char *format;
+  const char *file;
+
+  // Expected payload size, in bytes per sample, and whether the payload
+  // is the samples as they are, at the end of the file.
+  size_t sampleSize;
+  bool raw;
+};
+
+static const ExportBenchFormat formats[] = {
+  {"mat",   "bench.mat",         sizeof(SUCOMPLEX),     false},
+  {"wav",   "bench.wav",         sizeof(SUCOMPLEX),     false},
+  {"m",     "bench.m",           sizeof(SUCOMPLEX),     false},
+  {"npy",   "bench.npy",         sizeof(SUCOMPLEX),     true},
+  {"cf32",  "bench.cf32",        sizeof(SUCOMPLEX),     true},
+  {"cs16",  "bench.cs16",        2 * sizeof(int16_t),   false},
+  {"sigmf", "bench.sigmf-data",  sizeof(SUCOMPLEX),     true},
+};
+
+static inline SUFLOAT
+noise(void)
+{
+  return static_cast<SUFLOAT>(rand()) / static_cast<SUFLOAT>(RAND_MAX) - .5f;
+}
+
+static SampleBuffer
+makeSamples(size_t len)
+{
+  std::vector<SUCOMPLEX> samples(len);
+  SUFLOAT phase;
+
+  // A tone plus some noise, so that text formats print every digit
+  for (size_t i = 0; i < len; ++i) {
+    phase = .01f * static_cast<SUFLOAT>(i);
+    samples[i] = SUCOMPLEX(
+          .5f * cosf(phase) + 1e-3f * noise(),
+          .5f * sinf(phase) + 1e-3f * noise());
+  }
+
+  return SampleBuffer(std::move(samples));
+}
+
+static bool
+checkFile(
+    ExportBenchFormat const &fmt,
+    QString const &path,
+    SampleBuffer const &data,
+    qint64 &size)
+{
+  qint64 payload = static_cast<qint64>(data.size() * fmt.sampleSize);
+  QFile file(path);
+
+  size = file.size();
+
+  if (size < payload) {
+    fprintf(
+          stderr,
+          "%s: file too short (%lld < %lld bytes)\n",
+          fmt.format,
+          static_cast<long long>(size),
+          static_cast<long long>(payload));
+    return false;
+  }
+
+  if (fmt.raw) {
+    QByteArray contents;
+
+    if (!file.open(QIODevice::ReadOnly)
+        || !file.seek(size - payload)
+        || (contents = file.read(payload)).size() != payload
+        || memcmp(
+              contents.constData(),
+              data.data(),
+              static_cast<size_t>(payload)) != 0) {
+      fprintf(stderr, "%s: samples do not match\n", fmt.format);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool
+runFormat(
+    ExportBenchFormat const &fmt,
+    QDir const &dir,
+    SampleBuffer const &data)
+{
+  QString path = dir.filePath(fmt.file);
+  ExportSamplesTask task(
+        path,
+        fmt.format,
+        data,
+        EXPORT_BENCH_SAMPLE_RATE,
+        0,
+        static_cast<int>(data.size()));
+  QElapsedTimer timer;
+  qint64 size;
+  qreal seconds;
+
+  timer.start();
+
+  if (!task.attemptOpen()) {
+    fprintf(
+          stderr,
+          "%s: %s\n",
+          fmt.format,
+          task.getLastError().toStdString().c_str());
+    return false;
+  }
+
+  task.work();
+
+  if (!task.getLastError().isEmpty()) {
+    fprintf(
+          stderr,
+          "%s: %s\n",
+          fmt.format,
+          task.getLastError().toStdString().c_str());
+    return false;
+  }
+
+  seconds = timer.nsecsElapsed() * 1e-9;
+
+  if (!checkFile(fmt, path, data, size))
+    return false;
+
+  printf(
+        "%-6s %10.3f s %10.1f MiB/s %12lld bytes\n",
+        fmt.format,
+        seconds,
+        data.size() * sizeof(SUCOMPLEX) / (1024. * 1024.) / seconds,
+        static_cast<long long>(size));
+
+  QFile::remove(path);
+
+  return true;
+}
+
+int
+main(int argc, char **argv)
+{
+  QCoreApplication app(argc, argv);
+  size_t len = EXPORT_BENCH_DEFAULT_SAMPLES;
+  QTemporaryDir tmp;
+  QDir dir;
+  SampleBuffer data;
+  bool ok = true;
+
+  if (argc > 1)
+    len = strtoul(argv[1], nullptr, 0);
+
+  if (argc > 2) {
+    dir = QDir(argv[2]);
+  } else if (tmp.isValid()) {
+    dir = QDir(tmp.path());
+  } else {
+    fprintf(stderr, "%s: cannot create temporary directory\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (len == 0 || len > INT32_MAX) {
+    fprintf(stderr, "%s: invalid sample count\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  data = makeSamples(len);
+
+  printf(
+        "Exporting %zu samples (%.1f MiB) to %s\n",
+        len,
+        len * sizeof(SUCOMPLEX) / (1024. * 1024.),
+        dir.path().toStdString().c_str());
+
+  for (auto const &fmt : formats)
+    ok = runFormat(fmt, dir, data) && ok;
+
+  // SigMF leaves the metadata next to the data file
+  QFile::remove(dir.filePath("bench.sigmf-meta"));
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
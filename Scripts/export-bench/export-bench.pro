@@ -0,0 +1,37 @@
+#
+#  export-bench.pro: Throughput benchmark of the sample export formats
+#
+#  Build it out of tree, next to a SigDigger build environment:
+#
+#    mkdir build && cd build
+#    qmake ../export-bench.pro && make
+#    ./export-bench [samples] [directory]
+#
+
+QT       += core gui widgets
+CONFIG   += console c++14
+CONFIG   -= app_bundle
+
+TARGET   = export-bench
+TEMPLATE = app
+
+ROOT = $$PWD/../..
+
+INCLUDEPATH += $$ROOT/include
+
+SOURCES += \
+    export-bench.cpp \
+    $$ROOT/Misc/MatlabWriter.cpp \
+    $$ROOT/Misc/SampleBus.cpp \
+    $$ROOT/Misc/SampleConversion.cpp \
+    $$ROOT/Suscan/CancellableTask.cpp \
+    $$ROOT/Suscan/Message.cpp \
+    $$ROOT/Suscan/Messages/SamplesMessage.cpp \
+    $$ROOT/Tasks/ExportSamplesTask.cpp
+
+HEADERS += \
+    $$ROOT/include/ExportSamplesTask.h \
+    $$ROOT/include/Suscan/CancellableTask.h
+
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += suscan
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+#
+#  udp-monitor.py: Receive framed UDP samples from SigDigger and report loss
+#
+#  Copyright (C) 2020 Gonzalo José Carracedo Carballal
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU Lesser General Public License as
+#  published by the Free Software Foundation, either version 3 of the
+#  License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful, but
+#  WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU Lesser General Public License for more details.
+#
+#  You should have received a copy of the GNU Lesser General Public
+#  License along with this program.  If not, see
+#  <http://www.gnu.org/licenses/>
+#
+#  Usage: udp-monitor.py [port] [bind address]
+#
+
+import socket
+import struct
+import sys
+import time
+
+FRAME_MAGIC  = 0x53444658
+FRAME_HEADER = struct.Struct("!IBBHIIQQ")
+
+# Sample size of each payload format: complex float32, float32, int16
+SAMPLE_SIZES = {0: 8, 1: 4, 2: 2}
+
+port = int(sys.argv[1]) if len(sys.argv) > 1 else 9999
+addr = sys.argv[2] if len(sys.argv) > 2 else "0.0.0.0"
+
+sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 24)
+sock.bind((addr, port))
+
+expected = None
+received = lost = reordered = invalid = samples = 0
+last = time.monotonic()
+
+print("Listening on {0}:{1}".format(addr, port))
+
+while True:
+    data = sock.recv(65536)
+
+    if len(data) < FRAME_HEADER.size:
+        invalid += 1
+        continue
+
+    magic, version, fmt, count, seq, flags, index, ts = \
+        FRAME_HEADER.unpack_from(data)
+
+    if magic != FRAME_MAGIC:
+        invalid += 1
+        continue
+
+    if fmt not in SAMPLE_SIZES \
+            or count * SAMPLE_SIZES[fmt] != len(data) - FRAME_HEADER.size:
+        invalid += 1
+        continue
+
+    received += 1
+    samples  += count
+
+    if expected is not None:
+        delta = (seq - expected) & 0xffffffff
+        if delta == 0:
+            pass
+        elif delta < 0x80000000:
+            lost += delta
+        else:
+            # Late datagram, previously counted as lost
+            reordered += 1
+            lost -= 1
+
+    if expected is None or ((seq + 1 - expected) & 0xffffffff) < 0x80000000:
+        expected = (seq + 1) & 0xffffffff
+
+    now = time.monotonic()
+    if now - last >= 1:
+        total = received + lost
+        print(
+            "{0} datagrams, {1:.0f} sp/s, {2} lost ({3:.3f}%), "
+            "{4} reordered, {5} invalid, latency {6:.3f} ms".format(
+                received,
+                samples / (now - last),
+                lost,
+                100. * lost / total if total > 0 else 0,
+                reordered,
+                invalid,
+                (time.time_ns() - ts) * 1e-6))
+        samples = 0
+        last = now
@@ -98,6 +98,7 @@ SOURCES += \
     Misc/SNREstimator.cpp \
     Misc/SigDiggerHelpers.cpp \
     Suscan/CancellableTask.cpp \
+    Suscan/SplittableTask.cpp \
     Suscan/Messages/ChannelMessage.cpp \
     Suscan/Messages/GenericMessage.cpp \
     Suscan/Messages/InspectorMessage.cpp \
@@ -133,6 +134,23 @@ SOURCES += \
     Components/EstimatorControl.cpp \
     Misc/GenericDataSaver.cpp \
     Misc/FileDataSaver.cpp \
+    Misc/PreRollBuffer.cpp \
+    Misc/DataSaverStats.cpp \
+    Misc/RecordingService.cpp \
+    Misc/SampleConversion.cpp \
+    Misc/SubbandExtractor.cpp \
+    Tasks/CaptureIndexer.cpp \
+    Components/CaptureOverviewView.cpp \
+    Components/CaptureOverviewDialog.cpp \
+    Misc/SampleBus.cpp \
+    Misc/MatlabWriter.cpp \
+    Tasks/BatchExportTask.cpp \
+    Components/BatchExportDialog.cpp \
+    Tasks/SamplePipeline.cpp \
+    Tasks/PipelineStages.cpp \
+    Misc/FftService.cpp \
+    Tasks/DopplerTracker.cpp \
+    Components/RecordingsDialog.cpp \
     UDP/SocketForwarder.cpp \
     Components/NetForwarderUI.cpp \
     Components/WaitingSpinnerWidget.cpp \
@@ -172,6 +190,7 @@ HEADERS += \
     include/SamplingProperties.h \
     include/SigDiggerHelpers.h \
     include/Suscan/CancellableTask.h \
+    include/Suscan/SplittableTask.h \
     include/Suscan/Messages/ChannelMessage.h \
     include/Suscan/Messages/GenericMessage.h \
     include/Suscan/Messages/InspectorMessage.h \
@@ -234,6 +253,23 @@ HEADERS += \
     include/EstimatorControl.h \
     include/GenericDataSaver.h \
     include/FileDataSaver.h \
+    include/PreRollBuffer.h \
+    include/DataSaverStats.h \
+    include/RecordingService.h \
+    include/SampleConversion.h \
+    include/SubbandExtractor.h \
+    include/CaptureIndexer.h \
+    include/CaptureOverviewView.h \
+    include/CaptureOverviewDialog.h \
+    include/SampleBus.h \
+    include/MatlabWriter.h \
+    include/BatchExportTask.h \
+    include/BatchExportDialog.h \
+    include/SamplePipeline.h \
+    include/PipelineStages.h \
+    include/FftService.h \
+    include/DopplerTracker.h \
+    include/RecordingsDialog.h \
     include/SocketForwarder.h \
     include/NetForwarderUI.h \
     include/Version.h \
@@ -295,6 +331,9 @@ FORMS += \
     ui/SymViewTab.ui \
     ui/WaveformTab.ui \
     ui/BackgroundTasksDialog.ui \
+    ui/RecordingsDialog.ui \
+    ui/BatchExportDialog.ui \
+    ui/CaptureOverviewDialog.ui \
     ui/AddBookmarkDialog.ui \
     ui/BookmarkManagerDialog.ui
 
@@ -309,6 +348,13 @@ unix: PKGCONFIG += suscan fftw3f
 packagesExist(volk) {
   PKGCONFIG += volk
 }
+
+# Multithreaded FFTW is a separate library without a pkg-config file of
+# its own. Run qmake with CONFIG+=fftw_threads to use it.
+fftw_threads {
+  LIBS += -lfftw3f_threads
+  DEFINES += SIGDIGGER_HAVE_FFTW_THREADS
+}
   
 # Sound API detection. We first check for system-specific audio libraries,
 # which tend to be the faster ones. If they are not available, fallback
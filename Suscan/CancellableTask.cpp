@@ -17,6 +17,8 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include <Suscan/CancellableTask.h>
+#include <QElapsedTimer>
+#include <ctime>
 
 using namespace Suscan;
 
@@ -24,7 +26,10 @@ Q_DECLARE_METATYPE(Suscan::CancellableTask *);
 static bool typesRegistered = false;
 
 ////////////////////////////// CancellableTask /////////////////////////////////
-CancellableTask::CancellableTask(QObject *parent) : QObject(parent)
+CancellableTask::CancellableTask(QObject *parent) :
+  QObject(parent),
+  cancelPending(false),
+  cpuTime(0)
 {
   assertTypeRegistration();
 }
@@ -54,16 +59,73 @@ CancellableTask::setDataSize(quint64 size)
   this->dataSize = size;
 }
 
+void
+CancellableTask::setResource(TaskResource resource)
+{
+  this->resource = resource;
+}
+
 void
 CancellableTask::setStatus(QString status)
 {
   this->status = status;
 }
 
+void
+CancellableTask::endSlice(void)
+{
+  this->sliceEnded = true;
+}
+
+void
+CancellableTask::addCpuTime(quint64 us)
+{
+  this->cpuTime += us;
+}
+
+quint64
+CancellableTask::threadCpuTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return static_cast<quint64>(ts.tv_sec) * 1000000ull
+        + static_cast<quint64>(ts.tv_nsec) / 1000;
+#endif // CLOCK_THREAD_CPUTIME_ID
+
+  return 0;
+}
+
+void
+CancellableTask::interrupt(void)
+{
+  this->cancelPending = true;
+}
+
 void
 CancellableTask::onWorkRequested(void)
 {
-  if (this->work())
+  QElapsedTimer timer;
+  quint64 cpuStart = threadCpuTime();
+  bool more;
+
+  // Keep calling work() for a whole time slice instead of going through
+  // the event loop (and the controller) after every chunk.
+  this->sliceEnded = false;
+  timer.start();
+
+  do
+    more = this->work();
+  while (more
+         && !this->sliceEnded
+         && !this->cancelPending
+         && timer.elapsed() < SUSCAN_CANCELLABLE_TASK_SLICE_MS);
+
+  // Pool threads are shared: only count what this slice took
+  this->addCpuTime(threadCpuTime() - cpuStart);
+
+  if (more)
     emit progress(prog, status);
 }
 
@@ -173,6 +235,7 @@ CancellableController::cancel(void)
     return false;
 
   this->cancelledState = true;
+  this->task->interrupt();
   emit cancelling();
   emit queuedCancel();
 
@@ -17,57 +17,84 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include <Suscan/MultitaskController.h>
+#include <sigutils/types.h>
+#include <algorithm>
 
 using namespace Suscan;
 
+////////////////////////////// TaskTelemetry ///////////////////////////////////
+QString
+TaskTelemetry::outcomeString(TaskOutcome outcome)
+{
+  switch (outcome) {
+    case TaskOutcome::DONE:
+      return "done";
+
+    case TaskOutcome::CANCELLED:
+      return "cancelled";
+
+    case TaskOutcome::FAILED:
+      return "failed";
+  }
+
+  return "unknown";
+}
+
+/////////////////////////// CancellableTaskContext /////////////////////////////
+
 CancellableTaskContext::CancellableTaskContext(
     CancellableTask *task,
-    QString const &title)
+    QString const &title,
+    TaskPriority priority)
 {
-  this->mThread = new QThread;
   this->mTask  = task;
   this->mTitle = title;
+  this->mPriority = priority;
   this->mCreationTime = QDateTime::currentDateTime();
   this->mLastUpdate = this->mCreationTime;
-  this->connectAll();
+  this->mLastProgressMessage = "Queued";
+}
 
-  task->moveToThread(this->mThread);
+CancellableTaskContext::~CancellableTaskContext()
+{
+  // Pool threads outlive their tasks. Let the thread delete it once it is
+  // back to its event loop.
+  this->mTask->deleteLater();
 }
 
 void
-CancellableTaskContext::connectAll(void)
+CancellableTaskContext::start(QThread *thread)
 {
-  // Thread start triggers processing
-  QObject::connect(
-        this->mThread,
-        SIGNAL(started()),
-        this->mTask,
-        SLOT(onWorkRequested()));
-
-  // And thread quit trigger deleteLater()
-  QObject::connect(
-        this->mThread,
-        SIGNAL(finished()),
-        this->mThread,
-        SLOT(deleteLater()));
-
-  // Task is deleted after finalization
-  QObject::connect(
-        this->mThread,
-        SIGNAL(finished()),
+  this->mThread = thread;
+  this->mStartTime = QDateTime::currentDateTime();
+  this->mLastUpdate = this->mStartTime;
+  this->mLastProgressMessage = "Starting";
+  this->mWallTimer.start();
+
+  this->mTask->moveToThread(thread);
+
+  QMetaObject::invokeMethod(
         this->mTask,
-        SLOT(deleteLater()));
+        "onWorkRequested",
+        Qt::QueuedConnection);
 }
 
-CancellableTaskContext::~CancellableTaskContext()
+bool
+CancellableTaskContext::running(void) const
 {
-  this->mThread->quit();
+  return this->mThread != nullptr;
 }
 
-void
-CancellableTaskContext::start(void)
+QThread *
+CancellableTaskContext::thread(void) const
 {
-  this->mThread->start();
+  return this->mThread;
+}
+
+TaskPriority
+CancellableTaskContext::priority(void) const
+{
+  return this->mPriority;
 }
 
 void
@@ -105,12 +132,67 @@ CancellableTaskContext::setProgress(qreal value, QString message)
 {
   QDateTime now = QDateTime::currentDateTime();
   qint64 elapsed = this->mLastUpdate.msecsTo(now);
+  qint64 total = this->mWallTimer.isValid() ? this->mWallTimer.elapsed() : 0;
   qreal delta = value - this->mLastProgressValue;
+  qreal rate;
 
-  this->mLastUpdate          = now;
   this->mLastProgressValue   = value;
   this->mLastProgressMessage = message;
-  this->mRate = 1e3 * this->mTask->getDataSize() * (delta / elapsed);
+
+  // Reports closer than the clock resolution carry no rate information
+  if (elapsed > 0) {
+    rate = 1e3 * this->mTask->getDataSize() * (delta / elapsed);
+
+    // Smoothed, otherwise the peak is just the luckiest time slice
+    if (this->mRate > 0)
+      rate = SUSCAN_MULTITASK_RATE_ALPHA * rate
+          + (1 - SUSCAN_MULTITASK_RATE_ALPHA) * this->mRate;
+
+    this->mLastUpdate = now;
+    this->mRate = rate;
+    if (rate > this->mPeakRate)
+      this->mPeakRate = rate;
+  }
+
+  if (value > 0 && value <= 1 && total > 0)
+    this->mEta = 1e-3 * total * (1 - value) / value;
+}
+
+qreal
+CancellableTaskContext::eta(void) const
+{
+  return this->mEta;
+}
+
+TaskTelemetry
+CancellableTaskContext::telemetry(TaskOutcome outcome) const
+{
+  TaskTelemetry t;
+  qreal progress = outcome == TaskOutcome::DONE ? 1 : this->mLastProgressValue;
+
+  t.title        = this->mTitle;
+  t.outcome      = outcome;
+  t.priority     = this->mPriority;
+  t.resource     = this->mTask->getResource();
+  t.creationTime = this->mCreationTime;
+  t.cpuTime      = this->mTask->getCpuTime();
+  t.samples      = static_cast<quint64>(
+        progress * this->mTask->getDataSize());
+  t.bytes        = t.samples * sizeof(SUCOMPLEX);
+  t.peakRate     = this->mPeakRate;
+
+  if (this->running()) {
+    t.startTime = this->mStartTime;
+    t.queueTime = this->mCreationTime.msecsTo(this->mStartTime);
+    t.wallTime  = this->mWallTimer.elapsed();
+  } else {
+    t.queueTime = this->mCreationTime.msecsTo(QDateTime::currentDateTime());
+  }
+
+  if (t.wallTime > 0)
+    t.meanRate = 1e3 * t.samples / t.wallTime;
+
+  return t;
 }
 
 QString
@@ -135,6 +217,10 @@ CancellableTaskContext::title(void) const
 MultitaskController::MultitaskController(QObject *parent) : QObject(parent)
 {
   CancellableTask::assertTypeRegistration();
+  qRegisterMetaType<Suscan::TaskTelemetry>();
+
+  this->cpuSlots  = std::max(1, QThread::idealThreadCount());
+  this->diskSlots = SUSCAN_MULTITASK_MAX_DISK_TASKS;
 }
 
 MultitaskController::~MultitaskController()
@@ -144,6 +230,12 @@ MultitaskController::~MultitaskController()
 
   for (auto p : this->taskList)
     delete p;
+
+  // Busy threads finish their current task before going away
+  for (auto t : this->threads) {
+    QObject::connect(t, SIGNAL(finished()), t, SLOT(deleteLater()));
+    t->quit();
+  }
 }
 
 void
@@ -210,10 +302,65 @@ MultitaskController::repopulateTaskVector(void)
   }
 }
 
+int &
+MultitaskController::runningCounter(TaskResource resource)
+{
+  return resource == TaskResource::DISK ? this->runningDisk : this->runningCpu;
+}
+
+bool
+MultitaskController::canStart(CancellableTaskContext const *ctx)
+{
+  TaskResource resource = ctx->task()->getResource();
+  int limit = resource == TaskResource::DISK ? this->diskSlots : this->cpuSlots;
+
+  if (ctx->priority() == TaskPriority::INTERACTIVE)
+    limit += SUSCAN_MULTITASK_INTERACTIVE_SLOTS;
+
+  return this->runningCounter(resource) < limit;
+}
+
 void
-MultitaskController::pushTask(CancellableTask *task, QString const &title)
+MultitaskController::startTask(CancellableTaskContext *ctx)
 {
-  CancellableTaskContext *ctx = new CancellableTaskContext(task, title);
+  QThread *thread;
+
+  if (this->idleThreads.empty()) {
+    thread = new QThread;
+    thread->start();
+    this->threads.push_back(thread);
+  } else {
+    thread = this->idleThreads.front();
+    this->idleThreads.pop_front();
+  }
+
+  ++this->runningCounter(ctx->task()->getResource());
+
+  this->connectNewTask(ctx->task());
+  ctx->start(thread);
+
+  emit taskStarted(ctx->index());
+}
+
+void
+MultitaskController::schedule(void)
+{
+  // Interactive tasks first, then in order of arrival. A task that does
+  // not fit does not hold back the ones behind it using other resources.
+  for (auto priority : {TaskPriority::INTERACTIVE, TaskPriority::BACKGROUND})
+    for (auto p : this->taskList)
+      if (!p->running() && p->priority() == priority && this->canStart(p))
+        this->startTask(p);
+}
+
+void
+MultitaskController::pushTask(
+    CancellableTask *task,
+    QString const &title,
+    TaskPriority priority)
+{
+  CancellableTaskContext *ctx =
+      new CancellableTaskContext(task, title, priority);
 
   this->taskList.push_back(ctx);
   this->reverseTaskMap[task] = ctx;
@@ -225,8 +372,7 @@ MultitaskController::pushTask(CancellableTask *task, QString const &title)
   emit taskAdded(task);
 
   // Start after GUI has been notified
-  this->connectNewTask(task);
-  ctx->start();
+  this->schedule();
 }
 
 void
@@ -235,25 +381,79 @@ MultitaskController::getTaskVector(QVector<CancellableTaskContext *> &vec) const
   vec = this->taskVec;
 }
 
+int
+MultitaskController::runningCount(void) const
+{
+  return this->runningCpu + this->runningDisk;
+}
+
+int
+MultitaskController::queuedCount(void) const
+{
+  return static_cast<int>(this->taskList.size()) - this->runningCount();
+}
+
 void
 MultitaskController::cancelAll(void)
 {
+  std::list<CancellableTaskContext *> queued;
+
+  for (auto p : this->taskList)
+    if (p->running())
+      p->task()->interrupt();
+    else
+      queued.push_back(p);
+
+  // Queued tasks never got their signals connected: just drop them
+  for (auto p : queued) {
+    (void) this->removeTaskContext(p, TaskOutcome::CANCELLED);
+    emit taskCancelled(p->index());
+  }
+
   emit cancel();
 }
 
 void
 MultitaskController::cancelByIndex(int index)
 {
-  if (index >= 0 && index < this->taskVec.size())
-    this->taskVec[index]->task()->cancel();
+  CancellableTaskContext *ctx;
+
+  if (index < 0 || index >= this->taskVec.size())
+    return;
+
+  ctx = this->taskVec[index];
+
+  if (ctx->running()) {
+    ctx->task()->interrupt();
+    ctx->task()->cancel();
+  } else {
+    (void) this->removeTaskContext(ctx, TaskOutcome::CANCELLED);
+    emit taskCancelled(index);
+  }
 }
 
-void
-MultitaskController::removeTaskContext(CancellableTaskContext *ctx)
+bool
+MultitaskController::removeTaskContext(
+    CancellableTaskContext *ctx,
+    TaskOutcome outcome)
 {
+  // Some tasks may report their end more than once
+  if (std::find(this->taskList.begin(), this->taskList.end(), ctx)
+      == this->taskList.end())
+    return false;
+
+  if (ctx->running()) {
+    --this->runningCounter(ctx->task()->getResource());
+    this->idleThreads.push_back(ctx->thread());
+  }
+
   this->taskList.remove(ctx);
   this->deadList.push_back(ctx);
   this->repopulateTaskVector();
+
+  emit taskFinished(ctx->telemetry(outcome));
+
+  return true;
 }
 
 
@@ -288,9 +488,9 @@ MultitaskController::onDone(void)
   CancellableTaskContext *ctx = this->findTask(
         static_cast<CancellableTask *>(this->sender()));
 
-  if (ctx != nullptr) {
-    (void) this->removeTaskContext(ctx);
+  if (ctx != nullptr && this->removeTaskContext(ctx, TaskOutcome::DONE)) {
     emit taskDone(ctx->index());
+    this->schedule();
   }
 }
 
@@ -300,9 +500,10 @@ MultitaskController::onCancelled(void)
   CancellableTaskContext *ctx = this->findTask(
         static_cast<CancellableTask *>(this->sender()));
 
-  if (ctx != nullptr) {
-    (void) this->removeTaskContext(ctx);
+  if (ctx != nullptr
+      && this->removeTaskContext(ctx, TaskOutcome::CANCELLED)) {
     emit taskCancelled(ctx->index());
+    this->schedule();
   }
 }
 
@@ -312,8 +513,8 @@ MultitaskController::onError(QString message)
   CancellableTaskContext *ctx = this->findTask(
         static_cast<CancellableTask *>(this->sender()));
 
-  if (ctx != nullptr) {
-    (void) this->removeTaskContext(ctx);
+  if (ctx != nullptr && this->removeTaskContext(ctx, TaskOutcome::FAILED)) {
     emit taskError(ctx->index(), message);
+    this->schedule();
   }
 }
@@ -0,0 +1,311 @@
+//
+//    SplittableTask.cpp: Tasks that run over ranges in parallel
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <Suscan/SplittableTask.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Suscan;
+
+namespace {
+  //
+  // Threads that run pieces of ranges. Callers run one piece themselves
+  // and help with the rest of their own pieces while they wait.
+  //
+  class RangePool {
+      struct Job {
+        std::function<void (size_t, size_t)> const *func;
+        unsigned int pending;
+        quint64 cpuTime; // Of the pieces run by pool threads
+      };
+
+      struct Piece {
+        Job *job;
+        size_t first;
+        size_t len;
+      };
+
+      std::mutex mutex;
+      std::condition_variable wake;
+      std::condition_variable finished;
+      std::deque<Piece> queue;
+      std::vector<std::thread> threads;
+      bool stopping = false;
+
+      void
+      runPiece(std::unique_lock<std::mutex> &lock)
+      {
+        Piece piece = this->queue.front();
+        quint64 cpuTime;
+
+        this->queue.pop_front();
+
+        lock.unlock();
+        cpuTime = CancellableTask::threadCpuTime();
+        (*piece.job->func)(piece.first, piece.len);
+        cpuTime = CancellableTask::threadCpuTime() - cpuTime;
+        lock.lock();
+
+        piece.job->cpuTime += cpuTime;
+
+        if (--piece.job->pending == 0)
+          this->finished.notify_all();
+      }
+
+      // Next queued piece of a job, if any
+      bool
+      takePiece(Job const *job, Piece &piece)
+      {
+        for (auto p = this->queue.begin(); p != this->queue.end(); ++p)
+          if (p->job == job) {
+            piece = *p;
+            this->queue.erase(p);
+            return true;
+          }
+
+        return false;
+      }
+
+      void
+      loop(void)
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        for (;;) {
+          this->wake.wait(
+                lock,
+                [this] () { return this->stopping || !this->queue.empty(); });
+
+          if (this->stopping)
+            break;
+
+          this->runPiece(lock);
+        }
+      }
+
+    public:
+      RangePool()
+      {
+        unsigned int n = std::thread::hardware_concurrency();
+
+        // The calling thread is one of the workers
+        for (unsigned int i = 1; i < n; ++i)
+          this->threads.push_back(std::thread(&RangePool::loop, this));
+      }
+
+      ~RangePool()
+      {
+        {
+          std::lock_guard<std::mutex> guard(this->mutex);
+          this->stopping = true;
+        }
+
+        this->wake.notify_all();
+
+        for (auto &thread : this->threads)
+          thread.join();
+      }
+
+      unsigned int
+      size(void) const
+      {
+        return static_cast<unsigned int>(this->threads.size()) + 1;
+      }
+
+      // Returns the CPU time that pool threads spent on the job
+      quint64
+      run(
+          size_t first,
+          size_t len,
+          unsigned int pieces,
+          std::function<void (size_t, size_t)> const &func)
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        Job job;
+        size_t head = len / pieces;
+
+        job.func    = &func;
+        job.pending = pieces - 1;
+        job.cpuTime = 0;
+
+        for (unsigned int i = 1; i < pieces; ++i) {
+          Piece piece;
+          size_t start = i * len / pieces;
+
+          piece.job   = &job;
+          piece.first = first + start;
+          piece.len   = (i + 1) * len / pieces - start;
+
+          this->queue.push_back(piece);
+        }
+
+        this->wake.notify_all();
+
+        lock.unlock();
+        func(first, head);
+        lock.lock();
+
+        // Help with our own pieces only: the time of the calling thread is
+        // already accounted to its task
+        while (job.pending > 0) {
+          Piece piece;
+
+          if (this->takePiece(&job, piece)) {
+            lock.unlock();
+            func(piece.first, piece.len);
+            lock.lock();
+            --job.pending;
+          } else {
+            this->finished.wait(lock);
+          }
+        }
+
+        return job.cpuTime;
+      }
+  };
+
+  RangePool &
+  rangePool(void)
+  {
+    static RangePool pool;
+
+    return pool;
+  }
+}
+
+unsigned int
+Suscan::parallelPieces(void)
+{
+  return rangePool().size();
+}
+
+quint64
+Suscan::parallelFor(
+    size_t first,
+    size_t len,
+    size_t minPiece,
+    std::function<void (size_t, size_t)> const &func)
+{
+  size_t pieces = len / std::max<size_t>(minPiece, 1);
+
+  if (pieces > parallelPieces())
+    pieces = parallelPieces();
+
+  if (pieces <= 1) {
+    func(first, len);
+    return 0;
+  }
+
+  return rangePool().run(
+        first,
+        len,
+        static_cast<unsigned int>(pieces),
+        func);
+}
+
+////////////////////////////// SplittableTask //////////////////////////////////
+SplittableTask::SplittableTask(QObject *parent) : CancellableTask(parent)
+{
+}
+
+SplittableTask::~SplittableTask()
+{
+}
+
+void
+SplittableTask::setRange(size_t first, size_t end)
+{
+  this->rangeFirst = first;
+  this->rangeEnd   = std::max(first, end);
+  this->p          = first;
+}
+
+void
+SplittableTask::setBlockLength(size_t len)
+{
+  this->blockLength = std::max<size_t>(len, 1);
+}
+
+void
+SplittableTask::setMinPieceLength(size_t len)
+{
+  this->pieceLength = std::max<size_t>(len, 1);
+}
+
+size_t
+SplittableTask::getRangeFirst(void) const
+{
+  return this->rangeFirst;
+}
+
+size_t
+SplittableTask::getRangeEnd(void) const
+{
+  return this->rangeEnd;
+}
+
+void
+SplittableTask::blockDone(size_t, size_t)
+{
+}
+
+void
+SplittableTask::fail(QString const &message)
+{
+  this->failure = message;
+}
+
+bool
+SplittableTask::work(void)
+{
+  size_t len = std::min(this->blockLength, this->rangeEnd - this->p);
+  size_t first = this->p;
+
+  this->addCpuTime(
+        parallelFor(
+          first,
+          len,
+          this->pieceLength,
+          [this] (size_t first, size_t len) {
+            this->processRange(first, len);
+          }));
+
+  this->p += len;
+
+  if (this->rangeEnd > this->rangeFirst)
+    this->setProgress(
+          static_cast<qreal>(this->p - this->rangeFirst)
+          / static_cast<qreal>(this->rangeEnd - this->rangeFirst));
+
+  this->blockDone(first, len);
+
+  if (!this->failure.isEmpty()) {
+    emit error(this->failure);
+    return false;
+  }
+
+  if (this->p < this->rangeEnd)
+    return true;
+
+  emit done();
+  return false;
+}
@@ -0,0 +1,141 @@
+//
+//    BatchExportTask.cpp: Export many selections at once
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <BatchExportTask.h>
+#include <ExportSamplesTask.h>
+
+using namespace SigDigger;
+
+BatchExportTask::BatchExportTask(
+    SampleBuffer const &data,
+    qreal fs,
+    QString const &format,
+    std::vector<BatchExportItem> const &items) :
+  cancelFlag(false)
+{
+  this->data   = data;
+  this->fs     = fs;
+  this->format = format;
+  this->items  = items;
+
+  for (auto &item : this->items)
+    if (item.end > item.start)
+      this->samplesTotal += static_cast<quint64>(item.end - item.start);
+
+  this->setDataSize(this->samplesTotal);
+  this->setResource(Suscan::TaskResource::DISK);
+}
+
+BatchExportTask::~BatchExportTask()
+{
+}
+
+void
+BatchExportTask::exportItem(BatchExportItem const &item)
+{
+  ExportSamplesTask task(
+        item.path,
+        this->format,
+        this->data,
+        this->fs,
+        item.start,
+        item.end);
+  bool ok;
+
+  this->currentSize = task.getDataSize();
+
+  ok = task.attemptOpen();
+  if (ok) {
+    // Same thread: progress is delivered while the file is written
+    connect(
+          &task,
+          SIGNAL(progress(qreal, QString)),
+          this,
+          SLOT(onItemProgress(qreal, QString)));
+
+    this->mutex.lock();
+    this->running = &task;
+    this->mutex.unlock();
+
+    if (this->cancelFlag)
+      task.cancel();
+
+    (void) task.work();
+
+    this->mutex.lock();
+    this->running = nullptr;
+    this->mutex.unlock();
+
+    ok = task.getLastError().isEmpty();
+  }
+
+  if (!ok && this->failed++ == 0)
+    this->firstError = task.getLastError();
+
+  this->samplesDone += this->currentSize;
+}
+
+bool
+BatchExportTask::work(void)
+{
+  for (
+       this->current = 0;
+       !this->cancelFlag && this->current < this->items.size();
+       ++this->current)
+    this->exportItem(this->items[this->current]);
+
+  if (this->failed > 0)
+    emit error(
+        QString::number(this->failed)
+        + " of "
+        + QString::number(this->items.size())
+        + " files could not be saved. "
+        + this->firstError);
+  else if (this->cancelFlag)
+    emit cancelled();
+  else
+    emit done();
+
+  return false;
+}
+
+void
+BatchExportTask::cancel(void)
+{
+  this->cancelFlag = true;
+
+  this->mutex.lock();
+  if (this->running != nullptr)
+    this->running->cancel();
+  this->mutex.unlock();
+}
+
+void
+BatchExportTask::onItemProgress(qreal value, QString)
+{
+  emit progress(
+        this->samplesTotal > 0
+        ? (this->samplesDone + value * this->currentSize) / this->samplesTotal
+        : 0,
+        "Saving "
+        + QString::number(this->current + 1)
+        + " of "
+        + QString::number(this->items.size())
+        + " files");
+}
@@ -0,0 +1,478 @@
+//
+//    CaptureIndexer.cpp: Build a low resolution overview of a capture file
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <CaptureIndexer.h>
+#include <SampleConversion.h>
+#include <QCoreApplication>
+#include <sigutils/taps.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <thread>
+
+#define SIGDIGGER_CAPTURE_INDEXER_MAX_THREADS       8
+#define SIGDIGGER_CAPTURE_INDEXER_ROWS_PER_THREAD   4
+#define SIGDIGGER_CAPTURE_INDEXER_BREATHE_INTERVAL_MS 100
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  struct CaptureOverviewHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fileSize;
+    int64_t  mtime;
+    uint64_t samples;
+    uint32_t rows;
+    uint32_t bins;
+    uint32_t envPerRow;
+    uint32_t reserved;
+  };
+}
+
+static bool
+statCapture(std::string const &path, quint64 &size, qint64 &mtime)
+{
+  struct stat sbuf;
+
+  if (stat(path.c_str(), &sbuf) == -1)
+    return false;
+
+  size  = static_cast<quint64>(sbuf.st_size);
+  mtime = static_cast<qint64>(sbuf.st_mtime);
+
+  return true;
+}
+
+SIGDIGGER_VECTORIZE static SUFLOAT
+meanPower(const SUCOMPLEX *__restrict data, size_t len)
+{
+  const SUFLOAT *x = reinterpret_cast<const SUFLOAT *>(data);
+  SUFLOAT acc[16] = {0};
+  SUFLOAT sum = 0;
+  size_t i, j, n = 2 * len;
+
+  for (i = 0; i + 16 <= n; i += 16)
+    for (j = 0; j < 16; ++j)
+      acc[j] += x[i + j] * x[i + j];
+
+  for (; i < n; ++i)
+    sum += x[i] * x[i];
+
+  for (j = 0; j < 16; ++j)
+    sum += acc[j];
+
+  return len > 0 ? sum / len : 0;
+}
+
+static inline SUFLOAT
+toDb(SUFLOAT power)
+{
+  return SU_POWER_DB(power + 1e-20f);
+}
+
+////////////////////////////// CaptureOverview /////////////////////////////////
+std::string
+CaptureOverview::sidecarPath(std::string const &capture)
+{
+  return capture + SIGDIGGER_OVERVIEW_SUFFIX;
+}
+
+bool
+CaptureOverview::load(std::string const &capture)
+{
+  CaptureOverviewHeader header;
+  FILE *fp = nullptr;
+  quint64 size;
+  qint64 mtime;
+  bool ok = false;
+
+  if (!statCapture(capture, size, mtime))
+    goto done;
+
+  if ((fp = fopen(sidecarPath(capture).c_str(), "rb")) == nullptr)
+    goto done;
+
+  if (fread(&header, sizeof(CaptureOverviewHeader), 1, fp) != 1)
+    goto done;
+
+  if (header.magic != SIGDIGGER_OVERVIEW_MAGIC
+      || header.version != SIGDIGGER_OVERVIEW_VERSION
+      || header.fileSize != size
+      || header.mtime != mtime
+      || header.rows == 0
+      || header.rows > SIGDIGGER_OVERVIEW_ROWS
+      || header.bins != SIGDIGGER_OVERVIEW_BINS
+      || header.envPerRow != SIGDIGGER_OVERVIEW_ENV_PER_ROW)
+    goto done;
+
+  this->fileSize  = header.fileSize;
+  this->mtime     = header.mtime;
+  this->samples   = header.samples;
+  this->rows      = header.rows;
+  this->bins      = header.bins;
+  this->envPerRow = header.envPerRow;
+
+  this->spectrogram.resize(this->rows * this->bins);
+  this->envelope.resize(this->rows * this->envPerRow);
+
+  if (fread(
+        this->spectrogram.data(),
+        sizeof(SUFLOAT),
+        this->spectrogram.size(),
+        fp) != this->spectrogram.size())
+    goto done;
+
+  if (fread(
+        this->envelope.data(),
+        sizeof(SUFLOAT),
+        this->envelope.size(),
+        fp) != this->envelope.size())
+    goto done;
+
+  ok = true;
+
+done:
+  if (fp != nullptr)
+    fclose(fp);
+
+  if (!ok) {
+    this->rows = 0;
+    this->spectrogram.clear();
+    this->envelope.clear();
+  }
+
+  return ok;
+}
+
+bool
+CaptureOverview::save(std::string const &capture) const
+{
+  CaptureOverviewHeader header;
+  std::string path = sidecarPath(capture);
+  std::string temp = path + ".part";
+  FILE *fp = nullptr;
+  bool ok = false;
+
+  memset(&header, 0, sizeof(CaptureOverviewHeader));
+
+  header.magic     = SIGDIGGER_OVERVIEW_MAGIC;
+  header.version   = SIGDIGGER_OVERVIEW_VERSION;
+  header.fileSize  = this->fileSize;
+  header.mtime     = this->mtime;
+  header.samples   = this->samples;
+  header.rows      = this->rows;
+  header.bins      = this->bins;
+  header.envPerRow = this->envPerRow;
+
+  if ((fp = fopen(temp.c_str(), "wb")) == nullptr)
+    goto done;
+
+  if (fwrite(&header, sizeof(CaptureOverviewHeader), 1, fp) != 1)
+    goto done;
+
+  if (fwrite(
+        this->spectrogram.data(),
+        sizeof(SUFLOAT),
+        this->spectrogram.size(),
+        fp) != this->spectrogram.size())
+    goto done;
+
+  if (fwrite(
+        this->envelope.data(),
+        sizeof(SUFLOAT),
+        this->envelope.size(),
+        fp) != this->envelope.size())
+    goto done;
+
+  ok = true;
+
+done:
+  if (fp != nullptr && fclose(fp) != 0)
+    ok = false;
+
+  // Readers never see a half written sidecar
+  if (ok)
+    ok = rename(temp.c_str(), path.c_str()) == 0;
+  else if (fp != nullptr)
+    unlink(temp.c_str());
+
+  return ok;
+}
+
+////////////////////////////// CaptureIndexer //////////////////////////////////
+CaptureIndexer::CaptureIndexer(std::string const &path, QObject *parent) :
+  CancellableTask(parent),
+  cancelFlag(false)
+{
+  unsigned int cores = std::thread::hardware_concurrency();
+
+  this->path = path;
+  this->threads = qBound(
+        1u,
+        cores,
+        static_cast<unsigned int>(SIGDIGGER_CAPTURE_INDEXER_MAX_THREADS));
+
+  this->setProgress(0);
+  this->setStatus("Mapping capture file");
+  this->setResource(Suscan::TaskResource::DISK);
+}
+
+CaptureIndexer::~CaptureIndexer()
+{
+  if (this->map != nullptr)
+    munmap(const_cast<SUCOMPLEX *>(this->map), this->mapSize);
+
+  if (this->fd != -1)
+    ::close(this->fd);
+
+  if (this->plan != nullptr)
+    SU_FFTW(_destroy_plan)(this->plan);
+
+  for (auto p : this->buffers)
+    SU_FFTW(_free)(p);
+}
+
+bool
+CaptureIndexer::open(void)
+{
+  void *mem;
+  unsigned int i;
+
+  if (!statCapture(this->path, this->overview.fileSize, this->overview.mtime)) {
+    emit error(
+          "Cannot open "
+          + QString::fromStdString(this->path)
+          + ": "
+          + QString(strerror(errno)));
+    return false;
+  }
+
+  this->overview.samples   = this->overview.fileSize / sizeof(SUCOMPLEX);
+  this->overview.bins      = SIGDIGGER_OVERVIEW_BINS;
+  this->overview.envPerRow = SIGDIGGER_OVERVIEW_ENV_PER_ROW;
+  this->overview.rows      = static_cast<unsigned int>(
+        qMin(
+          static_cast<quint64>(SIGDIGGER_OVERVIEW_ROWS),
+          this->overview.samples / SIGDIGGER_OVERVIEW_BINS));
+
+  if (this->overview.rows == 0) {
+    emit error("Capture file is too short to build an overview");
+    return false;
+  }
+
+  this->setDataSize(this->overview.samples);
+
+  this->overview.spectrogram.resize(
+        this->overview.rows * this->overview.bins);
+  this->overview.envelope.resize(
+        this->overview.rows * this->overview.envPerRow);
+
+  if ((this->fd = ::open(this->path.c_str(), O_RDONLY)) == -1) {
+    emit error(
+          "Cannot open "
+          + QString::fromStdString(this->path)
+          + ": "
+          + QString(strerror(errno)));
+    return false;
+  }
+
+  this->mapSize = this->overview.samples * sizeof(SUCOMPLEX);
+  mem = mmap(nullptr, this->mapSize, PROT_READ, MAP_SHARED, this->fd, 0);
+  if (mem == MAP_FAILED) {
+    this->mapSize = 0;
+    emit error(
+          "Cannot map capture file to memory: "
+          + QString(strerror(errno)));
+    return false;
+  }
+
+  // Every byte is read exactly once, front to back in each thread
+  (void) madvise(mem, this->mapSize, MADV_SEQUENTIAL);
+  this->map = static_cast<const SUCOMPLEX *>(mem);
+
+  // One buffer per thread. The plan is only ever used through the
+  // new-array execute interface, which is thread safe.
+  for (i = 0; i < this->threads; ++i) {
+    SU_FFTW(_complex) *buf = static_cast<SU_FFTW(_complex) *>(
+          SU_FFTW(_malloc)(SIGDIGGER_OVERVIEW_BINS * sizeof(SUCOMPLEX)));
+    if (buf == nullptr) {
+      emit error("Failed to allocate FFT buffers");
+      return false;
+    }
+
+    this->buffers.push_back(buf);
+  }
+
+  if ((this->plan = SU_FFTW(_plan_dft_1d)(
+         SIGDIGGER_OVERVIEW_BINS,
+         this->buffers[0],
+         this->buffers[0],
+         FFTW_FORWARD,
+         FFTW_ESTIMATE)) == nullptr) {
+    emit error("Failed to initialize FFT plan.");
+    return false;
+  }
+
+  return true;
+}
+
+void
+CaptureIndexer::indexRows(unsigned int first, unsigned int count, unsigned int n)
+{
+  CaptureOverview &ov = this->overview;
+  SU_FFTW(_complex) *buf = this->buffers[n];
+  SUCOMPLEX *fft = reinterpret_cast<SUCOMPLEX *>(buf);
+  SUFLOAT acc[SIGDIGGER_OVERVIEW_BINS];
+  SUFLOAT norm = 1.f / (
+        SIGDIGGER_OVERVIEW_FFTS_PER_ROW
+        * SIGDIGGER_OVERVIEW_BINS
+        * SIGDIGGER_OVERVIEW_BINS);
+  unsigned int row, i, j;
+
+  for (row = first; row < first + count; ++row) {
+    quint64 start = ov.rowToSample(row);
+    quint64 len   = ov.rowToSample(row + 1) - start;
+    quint64 hop   = (len - ov.bins) / SIGDIGGER_OVERVIEW_FFTS_PER_ROW;
+    SUFLOAT *spectrum = ov.spectrogram.data() + row * ov.bins;
+    SUFLOAT *env = ov.envelope.data() + row * ov.envPerRow;
+
+    // Spectrum: average of a few windowed FFTs spread over the row
+    memset(acc, 0, sizeof(acc));
+    for (i = 0; i < SIGDIGGER_OVERVIEW_FFTS_PER_ROW; ++i) {
+      memcpy(
+            buf,
+            this->map + start + i * hop,
+            ov.bins * sizeof(SUCOMPLEX));
+      su_taps_apply_blackmann_harris_complex(fft, ov.bins);
+      SU_FFTW(_execute_dft)(this->plan, buf, buf);
+
+      for (j = 0; j < ov.bins; ++j)
+        acc[j] += SU_C_REAL(fft[j] * SU_C_CONJ(fft[j]));
+    }
+
+    // Negative frequencies first, so DC sits in the middle
+    for (j = 0; j < ov.bins; ++j)
+      spectrum[(j + ov.bins / 2) % ov.bins] = toDb(norm * acc[j]);
+
+    // Envelope: mean power of every sample in the row
+    for (i = 0; i < ov.envPerRow; ++i) {
+      quint64 p = start + len * i / ov.envPerRow;
+      quint64 q = start + len * (i + 1) / ov.envPerRow;
+      env[i] = toDb(meanPower(this->map + p, q - p));
+    }
+  }
+
+  // Runs in a thread of its own: all of its CPU time belongs to the task
+  this->addCpuTime(threadCpuTime());
+}
+
+void
+CaptureIndexer::breathe(unsigned int row)
+{
+  if (this->timer.elapsed() > SIGDIGGER_CAPTURE_INDEXER_BREATHE_INTERVAL_MS) {
+    this->timer.restart();
+    emit progress(
+        static_cast<qreal>(row) / this->overview.rows,
+        "Indexing capture file ("
+        + QString::number(row)
+        + "/"
+        + QString::number(this->overview.rows)
+        + " rows)");
+    QCoreApplication::processEvents();
+  }
+}
+
+bool
+CaptureIndexer::work(void)
+{
+  unsigned int batch = this->threads * SIGDIGGER_CAPTURE_INDEXER_ROWS_PER_THREAD;
+  unsigned int rows, row = 0;
+  long page = sysconf(_SC_PAGESIZE);
+
+  this->timer.start();
+
+  if (!this->open())
+    return false;
+
+  rows = this->overview.rows;
+
+  while (!this->cancelFlag && row < rows) {
+    std::vector<std::thread> pool;
+    unsigned int count = qMin(batch, rows - row);
+    unsigned int per = (count + this->threads - 1) / this->threads;
+    unsigned int i, first;
+    quint64 from, to;
+
+    // Each thread takes a contiguous run of rows
+    for (i = 0, first = row; first < row + count; ++i, first += per)
+      pool.emplace_back(
+            &CaptureIndexer::indexRows,
+            this,
+            first,
+            qMin(per, row + count - first),
+            i);
+
+    for (auto &t : pool)
+      t.join();
+
+    // Drop the pages we are done with, so huge captures do not pin RAM
+    from = this->overview.rowToSample(row) * sizeof(SUCOMPLEX);
+    to   = this->overview.rowToSample(row + count) * sizeof(SUCOMPLEX);
+    from = from / page * page;
+    to   = to / page * page;
+    if (to > from)
+      (void) madvise(
+          reinterpret_cast<char *>(const_cast<SUCOMPLEX *>(this->map)) + from,
+          to - from,
+          MADV_DONTNEED);
+
+    row += count;
+    this->breathe(row);
+  }
+
+  if (this->cancelFlag) {
+    emit cancelled();
+    return false;
+  }
+
+  if (!this->overview.save(this->path)) {
+    emit error(
+          "Cannot save capture overview to "
+          + QString::fromStdString(CaptureOverview::sidecarPath(this->path))
+          + ": "
+          + QString(strerror(errno)));
+    return false;
+  }
+
+  emit done();
+
+  return false;
+}
+
+void
+CaptureIndexer::cancel(void)
+{
+  this->cancelFlag = true;
+}
@@ -17,127 +17,394 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include "CarrierDetector.h"
+#include <Suscan/SplittableTask.h>
 #include <sigutils/taps.h>
+#include <sigutils/sampling.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 using namespace SigDigger;
 
+namespace {
+  inline SUFLOAT
+  wrapAngle(SUFLOAT angle)
+  {
+    if (angle > M_PI)
+      angle -= 2 * M_PI;
+    else if (angle <= -M_PI)
+      angle += 2 * M_PI;
+
+    return angle;
+  }
+
+  // Power centroid of the bins around the strongest one, as an angular
+  // frequency. psd(i) is the power of bin i, and the maximum is not looked
+  // for in bins for which skip(i) is true.
+  template <typename Psd, typename Skip>
+  SUFLOAT
+  findCentroid(Psd const &psd, int size, int bins, Skip const &skip)
+  {
+    int i, j;
+    int maxNdx = 0;
+    int delta = (bins - 1) / 2;
+    SUFLOAT maxVal = 0;
+    SUFLOAT nFreq;
+    SUCOMPLEX acc = 0;
+
+    for (i = 0; i < size; ++i)
+      if (!skip(i) && psd(i) > maxVal) {
+        maxVal = psd(i);
+        maxNdx = i;
+      }
+
+    for (i = 0; i < bins; ++i) {
+      j = (maxNdx - delta + i) % size;
+      if (j < 0)
+        j += size;
+
+      nFreq = 2.f * j / static_cast<SUFLOAT>(size);
+      acc += psd(j) * SU_C_EXP(I * SU_ASFLOAT(M_PI) * nFreq);
+    }
+
+    return wrapAngle(SU_C_ARG(acc));
+  }
+}
+
 CarrierDetector::CarrierDetector(
     const SUCOMPLEX *data,
     size_t len,
     qreal avgRelBw,
     qreal dcNotchRelBw,
-    QObject *parent) : CancellableTask(parent)
+    QObject *parent) : CancellableTask(parent), allocFailed(false)
 {
   this->data = data;
   this->len = len;
   this->avgRelBw = avgRelBw;
-  this->setProgress(0);
   this->dcNotchRelBw = qBound(0., dcNotchRelBw, 1.);
+  this->welch = len > SIGDIGGER_CARRIER_DETECTOR_MAX_FFT_SIZE;
 
-  this->setStatus("Estimating best FFT plan");
+  this->setDataSize(len);
+  this->transitionTo(ESTIMATING);
 }
 
 CarrierDetector::~CarrierDetector()
 {
-  if (this->plan != nullptr)
-    SU_FFTW(_destroy_plan)(this->plan);
+}
 
-  if (this->buffer != nullptr)
-    SU_FFTW(_free)(this->buffer);
+void
+CarrierDetector::transitionTo(State s)
+{
+  this->state = s;
+
+  switch (s) {
+    case ESTIMATING:
+      this->setProgress(0);
+      this->setStatus("Estimating best FFT plan");
+      break;
+
+    case COPYING:
+      this->setProgress(1. / 3);
+      this->setStatus("Copying I/Q data to FFT buffer");
+      break;
+
+    case AVERAGING:
+      this->setStatus("Averaging spectrum");
+      break;
+
+    case DECIMATING:
+      this->setStatus("Zooming into the strongest peak");
+      break;
+
+    case EXECUTING:
+      this->setProgress(this->welch ? .9 : 2. / 3);
+      this->setStatus("Executing FFT");
+      break;
+
+    case COMPUTING:
+      this->setProgress(this->welch ? .95 : 1);
+      this->setStatus("Computing dominant frequency");
+  }
+}
+
+void
+CarrierDetector::averageSegments(size_t first, size_t count)
+{
+  const size_t size = SIGDIGGER_CARRIER_DETECTOR_WELCH_SIZE;
+  std::vector<SUFLOAT> acc(size, 0);
+  FftBuffer segment;
+  SUCOMPLEX *x;
+  size_t i;
+
+  // Pieces run at the same time: each one gets a buffer of its own
+  if (!segment.allocate(size)) {
+    this->allocFailed = true;
+    return;
+  }
+
+  x = segment.data();
+
+  for (; count-- > 0; ++first) {
+    const SUCOMPLEX *orig = this->data + first * (size / 2);
+
+    for (i = 0; i < size; ++i)
+      x[i] = orig[i] * this->window[i];
+
+    segment.execute();
+
+    for (i = 0; i < size; ++i)
+      acc[i] += SU_C_REAL(x[i] * SU_C_CONJ(x[i]));
+  }
+
+  std::lock_guard<std::mutex> guard(this->psdMutex);
+
+  for (i = 0; i < size; ++i)
+    this->psd[i] += acc[i];
+}
+
+void
+CarrierDetector::decimate(size_t first, size_t count)
+{
+  su_ncqo_t ncqo = this->ncqo;
+  SUCOMPLEX *out = this->fft.data() + first;
+  SUFLOAT k = 1.f / this->decimation;
+  double omega = -static_cast<double>(this->coarse);
+  double phase;
+  size_t i, n;
+
+  for (; count-- > 0; ++first) {
+    const SUCOMPLEX *orig = this->data + first * this->decimation;
+    SUCOMPLEX acc = 0;
+
+    // Exact phase at every output: pieces and rounding errors do not
+    // shift the frequency
+    n = first * this->decimation;
+    phase = std::fmod(omega * static_cast<double>(n), 2 * M_PI);
+    if (phase < 0)
+      phase += 2 * M_PI;
+
+    su_ncqo_set_phase(&ncqo, static_cast<SUFLOAT>(phase));
+
+    for (i = 0; i < this->decimation; ++i)
+      acc += orig[i] * su_ncqo_read(&ncqo);
+
+    *out++ = k * acc;
+  }
+}
+
+bool
+CarrierDetector::startRefinement(void)
+{
+  size_t decimation =
+      (this->len + SIGDIGGER_CARRIER_DETECTOR_ZOOM_SIZE - 1)
+      / SIGDIGGER_CARRIER_DETECTOR_ZOOM_SIZE;
+
+  // The zoomed band must span a few Welch bins and hold the bandwidth the
+  // centroid is computed on. Otherwise the coarse estimate is as good.
+  if (decimation > SIGDIGGER_CARRIER_DETECTOR_WELCH_SIZE / 8
+      || this->avgRelBw * decimation > .5)
+    return false;
+
+  this->decimation = decimation;
+  this->zoomLen = this->len / decimation;
+  this->zoomDone = 0;
+
+  if (!this->fft.allocate(this->zoomLen))
+    return false;
+
+  this->allocation = this->fft.getSize();
+
+  su_ncqo_init(&this->ncqo, -SU_ANG2NORM_FREQ(this->coarse));
+
+  return true;
+}
+
+void
+CarrierDetector::refinePeak(void)
+{
+  int size = static_cast<int>(this->allocation);
+  int bins =
+      static_cast<int>(size * this->avgRelBw * this->decimation) + 1;
+  SUCOMPLEX *x = this->fft.data();
+  SUFLOAT notch = static_cast<SUFLOAT>(M_PI * this->dcNotchRelBw);
+  SUFLOAT binWidth =
+      static_cast<SUFLOAT>(2 * M_PI / (size * this->decimation));
+  SUFLOAT fine;
+
+  for (int i = 0; i < size; ++i)
+    x[i] *= SU_C_CONJ(x[i]);
+
+  // Decimation attenuates the edges of the zoomed band: the true peak is
+  // in the middle, within a couple of Welch bins from the coarse one
+  fine = findCentroid(
+        [x] (int i) { return SU_C_REAL(x[i]); },
+        size,
+        bins,
+        [this, size, notch, binWidth] (int i) {
+          int j = i < size / 2 ? i : i - size;
+
+          return std::abs(j) > size / 4
+              || std::fabs(wrapAngle(this->coarse + j * binWidth)) < notch;
+        });
+
+  this->peak = wrapAngle(
+        this->coarse + fine / static_cast<SUFLOAT>(this->decimation));
 }
 
 bool
 CarrierDetector::work(void)
 {
-  // Initializing state
   switch (this->state) {
     case ESTIMATING:
-      while (this->allocation < this->len)
-        this->allocation <<= 1;
+      if (this->welch) {
+        const size_t size = SIGDIGGER_CARRIER_DETECTOR_WELCH_SIZE;
+        std::vector<SUCOMPLEX> ones(size, 1);
 
-      if ((this->buffer = static_cast<SU_FFTW(_complex) *>(
-             SU_FFTW(_malloc)(this->allocation * sizeof(SUCOMPLEX)))) == nullptr) {
-        emit error(
-              "Failed to allocate "
-              + QString::number(this->allocation)
-              + " complex samples.");
-        return false;
+        su_taps_apply_blackmann_harris_complex(
+              ones.data(),
+              static_cast<SUSCOUNT>(size));
+
+        this->window.resize(size);
+        for (size_t i = 0; i < size; ++i)
+          this->window[i] = SU_C_REAL(ones[i]);
+
+        this->psd.assign(size, 0);
+        this->segments = (this->len - size) / (size / 2) + 1;
+        this->segmentsDone = 0;
+
+        this->transitionTo(AVERAGING);
+        break;
       }
 
-      if ((this->plan = SU_FFTW(_plan_dft_1d)(
-             this->allocation,
-             this->buffer,
-             this->buffer,
-             FFTW_FORWARD,
-             FFTW_ESTIMATE)) == nullptr) {
-        emit error("Failed to initialize FFT plan.");
+      // Plans are shared and cached: only the first run of a size pays
+      if (!this->fft.allocate(this->len)) {
+        emit error(
+              "Failed to allocate a "
+              + QString::number(this->len)
+              + " point FFT.");
         return false;
       }
 
+      this->allocation = this->fft.getSize();
+
       this->transitionTo(COPYING);
       break;
 
     case COPYING:
-      memcpy(this->buffer, this->data, this->len * sizeof(SUCOMPLEX));
-      memset(
-            this->buffer + this->len,
-            0,
-            (this->allocation - this->len) * sizeof(SUCOMPLEX));
+      this->fft.load(this->data, this->len);
 
       su_taps_apply_blackmann_harris_complex(
-            reinterpret_cast<SUCOMPLEX *>(this->buffer),
+            this->fft.data(),
             static_cast<SUSCOUNT>(this->len));
       this->transitionTo(EXECUTING);
       break;
 
-    case EXECUTING:
-      SU_FFTW(_execute)(this->plan);
-      this->transitionTo(COMPUTING);
-      break;
+    case AVERAGING: {
+      size_t count = std::min<size_t>(
+            SIGDIGGER_CARRIER_DETECTOR_WELCH_BLOCK,
+            this->segments - this->segmentsDone);
+      int size = SIGDIGGER_CARRIER_DETECTOR_WELCH_SIZE;
+      int skipLen = static_cast<int>(.5 * this->dcNotchRelBw * size);
+      const SUFLOAT *psd = this->psd.data();
 
-    case COMPUTING:
-      int i;
-      int maxNdx = 0;
-      int bins = static_cast<int>(this->allocation * this->avgRelBw) + 1;
-      int delta = (bins - 1) / 2;
-      int start;
-      int skipLen = static_cast<int>(.5 * this->dcNotchRelBw * this->allocation);
-      SUFLOAT maxVal = 0;
-      SUCOMPLEX *asSuComplex = reinterpret_cast<SUCOMPLEX *>(this->buffer);
-      SUFLOAT psd;
-      SUCOMPLEX acc = 0;
-
-      // Find maximum
-      for (i = skipLen; i < static_cast<int>(this->allocation) - skipLen; ++i) {
-        asSuComplex[i] *= SU_C_CONJ(asSuComplex[i]);
-        psd = SU_C_REAL(asSuComplex[i]);
-        if (psd > maxVal) {
-          maxVal = psd;
-          maxNdx = i;
-        }
+      this->addCpuTime(
+            Suscan::parallelFor(
+              this->segmentsDone,
+              count,
+              1,
+              [this] (size_t first, size_t n) {
+                this->averageSegments(first, n);
+              }));
+
+      if (this->allocFailed) {
+        emit error("Failed to allocate FFT buffers.");
+        return false;
       }
 
-      // Compute centroid.
-      start = maxNdx - delta;
+      this->segmentsDone += count;
+      this->setProgress(.5 * this->segmentsDone / this->segments);
 
-      for (i = 0; i < bins; ++i) {
-        int j = i + start;
-        if (j < 0)
-          j += this->allocation;
+      if (this->segmentsDone < this->segments)
+        break;
 
-        j %= this->allocation;
+      this->coarse = findCentroid(
+            [psd] (int i) { return psd[i]; },
+            size,
+            static_cast<int>(size * this->avgRelBw) + 1,
+            [size, skipLen] (int i) {
+              return i < skipLen || i >= size - skipLen;
+            });
 
-        psd = SU_C_REAL(asSuComplex[j]);
-        SUFLOAT nFreq = 2.f * j / static_cast<SUFLOAT>(this->allocation);
+      // Welch only leaves what the refinement needs in memory
+      this->psd.clear();
+      this->psd.shrink_to_fit();
 
-        acc += psd * SU_C_EXP(I * SU_ASFLOAT(M_PI) * nFreq);
+      if (!this->startRefinement()) {
+        this->peak = this->coarse;
+        emit done();
+        return false;
       }
 
-      // Finish
-      this->peak = SU_C_ARG(acc);
+      this->transitionTo(DECIMATING);
+      break;
+    }
+
+    case DECIMATING: {
+      size_t count = std::min<size_t>(
+            SIGDIGGER_CARRIER_DETECTOR_ZOOM_BLOCK,
+            this->zoomLen - this->zoomDone);
+
+      this->addCpuTime(
+            Suscan::parallelFor(
+              this->zoomDone,
+              count,
+              SIGDIGGER_CARRIER_DETECTOR_ZOOM_BLOCK / 16,
+              [this] (size_t first, size_t n) {
+                this->decimate(first, n);
+              }));
+
+      this->zoomDone += count;
+      this->setProgress(.5 + .4 * this->zoomDone / this->zoomLen);
+
+      if (this->zoomDone < this->zoomLen)
+        break;
 
-      if (this->peak > M_PI)
-        this->peak -= 2 * M_PI;
+      su_taps_apply_blackmann_harris_complex(
+            this->fft.data(),
+            static_cast<SUSCOUNT>(this->zoomLen));
+      std::fill(
+            this->fft.data() + this->zoomLen,
+            this->fft.data() + this->allocation,
+            0);
+
+      this->transitionTo(EXECUTING);
+      break;
+    }
+
+    case EXECUTING:
+      this->fft.execute();
+      this->transitionTo(COMPUTING);
+      break;
+
+    case COMPUTING:
+      if (this->welch) {
+        this->refinePeak();
+      } else {
+        int size = static_cast<int>(this->allocation);
+        int skipLen = static_cast<int>(.5 * this->dcNotchRelBw * size);
+        SUCOMPLEX *x = this->fft.data();
+
+        for (int i = 0; i < size; ++i)
+          x[i] *= SU_C_CONJ(x[i]);
+
+        this->peak = findCentroid(
+              [x] (int i) { return SU_C_REAL(x[i]); },
+              size,
+              static_cast<int>(size * this->avgRelBw) + 1,
+              [size, skipLen] (int i) {
+                return i < skipLen || i >= size - skipLen;
+              });
+      }
 
       emit done();
       return false;
@@ -18,6 +18,10 @@
 //
 
 #include <CarrierXlator.h>
+#include <SampleConversion.h>
+#include <sigutils/sampling.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace SigDigger;
 
@@ -26,13 +30,14 @@ CarrierXlator::CarrierXlator(
     SUCOMPLEX *destination,
     size_t length,
     SUFLOAT relFreq,
-    QObject *parent) : CancellableTask(parent)
+    QObject *parent) : SplittableTask(parent)
 {
   this->origin      = data;
   this->destination = destination;
   this->length      = length;
+  this->omega       = static_cast<double>(SU_NORM2ANG_FREQ(-relFreq));
 
-  su_ncqo_init(&this->ncqo, -relFreq);
+  this->setRange(0, length);
 
   this->setProgress(0);
 
@@ -43,35 +48,122 @@ CarrierXlator::~CarrierXlator()
 {
 }
 
-bool
-CarrierXlator::work(void)
-{
-  size_t amount = this->length - this->p;
-  size_t p = this->p;
-
-  if (amount > SIGDIGGER_CARRIER_XLATOR_BLOCK_LENGTH)
-    amount = SIGDIGGER_CARRIER_XLATOR_BLOCK_LENGTH;
+namespace {
+  //
+  // Lane k of the phasor holds exp(I * (phase + omega * (n + k))) for the
+  // next LANES samples starting at n, and every step advances all of them
+  // by exp(I * omega * LANES). Lanes are independent, so the compiler
+  // turns the inner loops into SIMD multiplications.
+  //
+  // out may be in: every step loads its samples before storing any. As
+  // the loads go to a local array, the compiler needs no aliasing checks
+  // to vectorize either way.
+  //
+  SIGDIGGER_VECTORIZE void
+  rotateBlock(
+      SUFLOAT *out,
+      const SUFLOAT *in,
+      size_t steps,
+      SUFLOAT *__restrict re,
+      SUFLOAT *__restrict im,
+      SUFLOAT stepRe,
+      SUFLOAT stepIm)
+  {
+    const unsigned int lanes = SIGDIGGER_CARRIER_XLATOR_LANES;
+    SUFLOAT x[2 * SIGDIGGER_CARRIER_XLATOR_LANES];
+
+    for (size_t j = 0; j < steps; ++j) {
+      for (unsigned int k = 0; k < 2 * lanes; ++k)
+        x[k] = in[k];
+
+      for (unsigned int k = 0; k < lanes; ++k) {
+        SUFLOAT xr = x[2 * k];
+        SUFLOAT xi = x[2 * k + 1];
+        SUFLOAT pr = re[k];
+        SUFLOAT pi = im[k];
+
+        out[2 * k]     = xr * pr - xi * pi;
+        out[2 * k + 1] = xr * pi + xi * pr;
+
+        re[k] = pr * stepRe - pi * stepIm;
+        im[k] = pr * stepIm + pi * stepRe;
+      }
+
+      in  += 2 * lanes;
+      out += 2 * lanes;
+    }
+  }
+}
 
-  while (amount--) {
-    this->destination[p] = this->origin[p] * su_ncqo_read(&this->ncqo);
-    ++p;
+void
+CarrierXlator::rotate(
+    SUCOMPLEX *out,
+    const SUCOMPLEX *in,
+    size_t len,
+    double omega,
+    double phase)
+{
+  const unsigned int lanes = SIGDIGGER_CARRIER_XLATOR_LANES;
+  SUFLOAT re[SIGDIGGER_CARRIER_XLATOR_LANES];
+  SUFLOAT im[SIGDIGGER_CARRIER_XLATOR_LANES];
+  SUFLOAT stepRe = static_cast<SUFLOAT>(std::cos(omega * lanes));
+  SUFLOAT stepIm = static_cast<SUFLOAT>(std::sin(omega * lanes));
+  size_t n = 0, count, steps;
+  unsigned int k;
+
+  while (n < len) {
+    count = std::min<size_t>(SIGDIGGER_CARRIER_XLATOR_RENORM, len - n);
+    steps = count / lanes;
+
+    // Exact phase of every lane, computed in double precision
+    for (k = 0; k < lanes; ++k) {
+      double angle = phase + omega * static_cast<double>(n + k);
+      re[k] = static_cast<SUFLOAT>(std::cos(angle));
+      im[k] = static_cast<SUFLOAT>(std::sin(angle));
+    }
+
+    rotateBlock(
+          reinterpret_cast<SUFLOAT *>(out + n),
+          reinterpret_cast<const SUFLOAT *>(in + n),
+          steps,
+          re,
+          im,
+          stepRe,
+          stepIm);
+
+    // Less than a full step left: lanes are already at the right phase
+    for (k = 0; k < count - steps * lanes; ++k) {
+      size_t i = n + steps * lanes + k;
+      out[i] = in[i] * SUCOMPLEX(re[k], im[k]);
+    }
+
+    n += count;
   }
+}
 
-  this->p = p;
+void
+CarrierXlator::processRange(size_t first, size_t len)
+{
+  double phase = std::fmod(this->omega * static_cast<double>(first), 2 * M_PI);
+
+  // Start where a single oscillator would be after the previous samples,
+  // so that pieces are stitched together without phase jumps
+  rotate(
+        this->destination + first,
+        this->origin + first,
+        len,
+        this->omega,
+        phase);
+}
 
+void
+CarrierXlator::blockDone(size_t first, size_t len)
+{
   this->setStatus("Translating ("
-                  + QString::number(p)
+                  + QString::number(first + len)
                   + "/"
                   + QString::number(this->length)
                   + ")...");
-
-  this->setProgress(static_cast<qreal>(p) / static_cast<qreal>(this->length));
-
-  if (this->p < this->length)
-    return true;
-
-  emit done();
-  return false;
 }
 
 void
@@ -42,11 +42,6 @@ DopplerCalculator::DopplerCalculator(
 
 DopplerCalculator::~DopplerCalculator()
 {
-  if (this->plan != nullptr)
-    SU_FFTW(_destroy_plan)(this->plan);
-
-  if (this->buffer != nullptr)
-    SU_FFTW(_free)(this->buffer);
 }
 
 bool
@@ -55,48 +50,33 @@ DopplerCalculator::work(void)
   // Initializing state
   switch (this->state) {
     case ESTIMATING:
-      while (this->allocation < this->len)
-        this->allocation <<= 1;
-
-      this->psd.resize(this->allocation);
-
-      if ((this->buffer = static_cast<SU_FFTW(_complex) *>(
-             SU_FFTW(_malloc)(this->allocation * sizeof(SUCOMPLEX)))) == nullptr) {
+      // Plans are shared and cached: only the first run of a size pays
+      if (!this->fft.allocate(this->len)) {
         emit error(
-              "Failed to allocate "
-              + QString::number(this->allocation)
-              + " complex samples.");
+              "Failed to allocate a "
+              + QString::number(this->len)
+              + " point FFT.");
         return false;
       }
 
-      if ((this->plan = SU_FFTW(_plan_dft_1d)(
-             this->allocation,
-             this->buffer,
-             this->buffer,
-             FFTW_FORWARD,
-             FFTW_ESTIMATE)) == nullptr) {
-        emit error("Failed to initialize FFT plan.");
-        return false;
-      }
+      this->allocation = this->fft.getSize();
+
+      this->psd.resize(this->allocation);
 
       this->transitionTo(COPYING);
       break;
 
     case COPYING:
-      memcpy(this->buffer, this->data, this->len * sizeof(SUCOMPLEX));
-      memset(
-            this->buffer + this->len,
-            0,
-            (this->allocation - this->len) * sizeof(SUCOMPLEX));
+      this->fft.load(this->data, this->len);
 
       su_taps_apply_blackmann_harris_complex(
-            reinterpret_cast<SUCOMPLEX *>(this->buffer),
+            this->fft.data(),
             static_cast<SUSCOUNT>(this->len));
       this->transitionTo(EXECUTING);
       break;
 
     case EXECUTING:
-      SU_FFTW(_execute)(this->plan);
+      this->fft.execute();
       this->transitionTo(COMPUTE);
       break;
 
@@ -107,7 +87,7 @@ DopplerCalculator::work(void)
       int delta = bins / 2;
       int start;
       SUFLOAT maxVal = 0;
-      SUCOMPLEX *asSuComplex = reinterpret_cast<SUCOMPLEX *>(this->buffer);
+      SUCOMPLEX *asSuComplex = this->fft.data();
       SUFLOAT psd;
       SUCOMPLEX acc = 0;
       SUFLOAT peak;
@@ -0,0 +1,236 @@
+//
+//    DopplerTracker.cpp: Doppler velocity over time
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <DopplerTracker.h>
+#include <FftService.h>
+#include <sigutils/taps.h>
+#include <sigutils/sampling.h>
+#include <algorithm>
+#include <cmath>
+
+#define SPEED_OF_LIGHT 299792458.
+
+using namespace SigDigger;
+
+DopplerTracker::DopplerTracker(
+    SUFREQ f0,
+    const SUCOMPLEX *data,
+    size_t len,
+    SUFLOAT fs,
+    QObject *parent) : SplittableTask(parent), allocFailed(false)
+{
+  std::vector<SUCOMPLEX> ones;
+
+  this->data      = data;
+  this->len       = len;
+  this->fs        = fs;
+  this->lambda    = static_cast<SUFLOAT>(SPEED_OF_LIGHT / f0);
+
+  // Biggest power of two that still gives enough frames to see a trend
+  while (this->frameLen < SIGDIGGER_DOPPLER_TRACKER_MAX_FFT
+         && 2 * this->frameLen * SIGDIGGER_DOPPLER_TRACKER_MIN_FRAMES <= len)
+    this->frameLen <<= 1;
+
+  // Selections shorter than a frame are transformed at once, zero-padded
+  this->windowLen = std::min(this->frameLen, len);
+  this->hop       = this->frameLen / 2;
+
+  if (len >= this->frameLen)
+    this->frames = (len - this->frameLen) / this->hop + 1;
+
+  ones.assign(this->windowLen, 1);
+  su_taps_apply_blackmann_harris_complex(
+        ones.data(),
+        static_cast<SUSCOUNT>(this->windowLen));
+
+  this->window.resize(this->windowLen);
+  for (size_t i = 0; i < this->windowLen; ++i)
+    this->window[i] = SU_C_REAL(ones[i]);
+
+  this->rawVelocity.resize(this->frames);
+  this->sigma.resize(this->frames);
+  this->energy.resize(this->frames);
+
+  this->setRange(0, this->frames);
+  this->setBlockLength(SIGDIGGER_DOPPLER_TRACKER_BLOCK);
+  this->setMinPieceLength(SIGDIGGER_DOPPLER_TRACKER_MIN_PIECE);
+
+  this->setProgress(0);
+
+  this->setStatus("Tracking Doppler...");
+}
+
+DopplerTracker::~DopplerTracker()
+{
+}
+
+void
+DopplerTracker::processRange(size_t first, size_t len)
+{
+  FftBuffer fft;
+  std::vector<SUFLOAT> psd(this->frameLen);
+  int bins = static_cast<int>(this->frameLen);
+  int peakBins = std::min(SIGDIGGER_DOPPLER_TRACKER_PEAK_BINS, bins / 2 - 1);
+  SUFLOAT binToHz = this->fs / bins;
+  SUCOMPLEX *x;
+  int i;
+
+  // Pieces run at the same time: each one gets a buffer of its own
+  if (!fft.allocate(this->frameLen)) {
+    this->allocFailed = true;
+    return;
+  }
+
+  x = fft.data();
+
+  for (; len-- > 0; ++first) {
+    const SUCOMPLEX *orig = this->data + first * this->hop;
+    int maxNdx = 0;
+    SUFLOAT maxVal = -1, peak;
+    double total = 0, acc = 0, dispAcc = 0, center = 0;
+
+    for (size_t j = 0; j < this->windowLen; ++j)
+      x[j] = orig[j] * this->window[j];
+
+    if (this->windowLen < this->frameLen)
+      std::fill(x + this->windowLen, x + this->frameLen, SUCOMPLEX(0));
+
+    fft.execute();
+
+    for (i = 0; i < bins; ++i) {
+      psd[i] = SU_C_REAL(x[i] * SU_C_CONJ(x[i]));
+      if (psd[i] > maxVal) {
+        maxVal = psd[i];
+        maxNdx = i;
+      }
+    }
+
+    // Centroid and dispersion of the bins around the peak. Offsets are
+    // relative to the peak, so the band edges need no special care.
+    for (i = -peakBins; i <= peakBins; ++i) {
+      double bin = psd[static_cast<unsigned>(maxNdx + i + bins) % bins];
+      total += bin;
+      acc   += bin * i;
+    }
+
+    if (total > 0) {
+      center = acc / total;
+
+      for (i = -peakBins; i <= peakBins; ++i) {
+        double bin = psd[static_cast<unsigned>(maxNdx + i + bins) % bins];
+        dispAcc += bin * (i - center) * (i - center);
+      }
+
+      dispAcc /= total;
+    }
+
+    peak = static_cast<SUFLOAT>(2 * M_PI * (maxNdx + center) / bins);
+    if (peak > PI)
+      peak -= 2 * PI;
+
+    this->rawVelocity[first] =
+        -this->lambda * SU_NORM2ABS_FREQ(this->fs, SU_ANG2NORM_FREQ(peak));
+    this->sigma[first]  =
+        this->lambda * binToHz * static_cast<SUFLOAT>(std::sqrt(dispAcc));
+    this->energy[first] = static_cast<SUFLOAT>(total);
+  }
+}
+
+void
+DopplerTracker::blockDone(size_t first, size_t len)
+{
+  if (this->allocFailed) {
+    this->fail(
+          "Failed to allocate "
+          + QString::number(this->frameLen)
+          + " point FFT buffers.");
+    return;
+  }
+
+  this->setStatus("Tracking Doppler ("
+                  + QString::number(first + len)
+                  + "/"
+                  + QString::number(this->frames)
+                  + " frames)...");
+}
+
+void
+DopplerTracker::cancel(void)
+{
+  emit cancelled();
+}
+
+qreal
+DopplerTracker::getFrameRate(void) const
+{
+  return static_cast<qreal>(this->fs) / this->hop;
+}
+
+qreal
+DopplerTracker::getTimeOffset(void) const
+{
+  return .5 * this->windowLen / static_cast<qreal>(this->fs);
+}
+
+std::vector<SUFLOAT> const &
+DopplerTracker::getRawVelocity(void) const
+{
+  return this->rawVelocity;
+}
+
+std::vector<SUFLOAT> const &
+DopplerTracker::getSigma(void) const
+{
+  return this->sigma;
+}
+
+std::vector<SUFLOAT> const &
+DopplerTracker::getEnergy(void) const
+{
+  return this->energy;
+}
+
+std::vector<SUFLOAT>
+DopplerTracker::smooth(
+    std::vector<SUFLOAT> const &values,
+    std::vector<SUFLOAT> const &weights,
+    unsigned int frames)
+{
+  size_t n = std::min(values.size(), weights.size());
+  std::vector<double> sumW(n + 1, 0), sumWV(n + 1, 0);
+  std::vector<SUFLOAT> result(n);
+
+  // Running sums make this linear in n, whatever the window
+  for (size_t i = 0; i < n; ++i) {
+    sumW[i + 1]  = sumW[i]  + static_cast<double>(weights[i]);
+    sumWV[i + 1] = sumWV[i]
+        + static_cast<double>(weights[i]) * static_cast<double>(values[i]);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    size_t lo = i > frames ? i - frames : 0;
+    size_t hi = std::min(n, i + frames + 1);
+    double w = sumW[hi] - sumW[lo];
+
+    result[i] = w > 0
+        ? static_cast<SUFLOAT>((sumWV[hi] - sumWV[lo]) / w)
+        : values[i];
+  }
+
+  return result;
+}
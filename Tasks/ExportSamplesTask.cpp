@@ -17,12 +17,106 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include <ExportSamplesTask.h>
+#include <SampleConversion.h>
 #include <QCoreApplication>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 using namespace SigDigger;
 
 #define SIGDIGGER_EXPORT_SAMPLES_BREATHE_INTERVAL_MS 100
-#define SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE  0x10000
+
+// Level 5 MAT-file data types and array classes
+#define MAT5_MI_INT8           1
+#define MAT5_MI_INT32          5
+#define MAT5_MI_UINT32         6
+#define MAT5_MI_SINGLE         7
+#define MAT5_MI_DOUBLE         9
+#define MAT5_MI_MATRIX         14
+#define MAT5_MX_DOUBLE_CLASS   6
+#define MAT5_MX_SINGLE_CLASS   7
+#define MAT5_HEADER_TEXT_SIZE  116
+
+// NumPy format 1.0. Headers are padded so that data is 64 byte aligned.
+#define NPY_MAGIC              "\x93NUMPY\x01\x00"
+#define NPY_MAGIC_SIZE         8
+#define NPY_ALIGNMENT          64
+
+#define SIGMF_DATA_SUFFIX      ".sigmf-data"
+#define SIGMF_META_SUFFIX      ".sigmf-meta"
+
+static inline uint32_t
+mat5Pad(size_t size)
+{
+  return static_cast<uint32_t>((size + 7) & ~static_cast<size_t>(7));
+}
+
+static void
+mat5AppendWords(std::vector<uint8_t> &buffer, uint32_t a, uint32_t b)
+{
+  uint32_t words[2] = {a, b};
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(words);
+
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(words));
+}
+
+//
+// Everything in a numeric matrix element but the data itself, which must
+// be padded to 8 bytes by the caller. Data elements above 4 GiB cannot be
+// described in a Level 5 MAT-file.
+//
+static void
+mat5AppendMatrix(
+    std::vector<uint8_t> &buffer,
+    const char *name,
+    uint32_t mxClass,
+    uint32_t miType,
+    uint32_t rows,
+    uint64_t cols,
+    size_t elementSize)
+{
+  size_t nameLen = strlen(name);
+  uint64_t dataSize = rows * cols * elementSize;
+
+  mat5AppendWords(
+        buffer,
+        MAT5_MI_MATRIX,
+        static_cast<uint32_t>(
+          16 + 16 + 8 + mat5Pad(nameLen) + 8 + mat5Pad(dataSize)));
+
+  mat5AppendWords(buffer, MAT5_MI_UINT32, 8);
+  mat5AppendWords(buffer, mxClass, 0);
+
+  mat5AppendWords(buffer, MAT5_MI_INT32, 8);
+  mat5AppendWords(buffer, rows, static_cast<uint32_t>(cols));
+
+  mat5AppendWords(buffer, MAT5_MI_INT8, static_cast<uint32_t>(nameLen));
+  buffer.insert(buffer.end(), name, name + nameLen);
+  buffer.resize(buffer.size() + mat5Pad(nameLen) - nameLen, 0);
+
+  mat5AppendWords(buffer, miType, static_cast<uint32_t>(dataSize));
+}
+
+static void
+mat5AppendScalar(std::vector<uint8_t> &buffer, const char *name, double value)
+{
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+
+  mat5AppendMatrix(
+        buffer,
+        name,
+        MAT5_MX_DOUBLE_CLASS,
+        MAT5_MI_DOUBLE,
+        1,
+        1,
+        sizeof(double));
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(double));
+}
 
 void
 ExportSamplesTask::breathe(quint64 i)
@@ -32,7 +126,7 @@ ExportSamplesTask::breathe(quint64 i)
   if (this->timer.elapsed() > SIGDIGGER_EXPORT_SAMPLES_BREATHE_INTERVAL_MS) {
     this->timer.restart();
     emit progress(
-        static_cast<qreal>(i) / static_cast<qreal>(size - 1),
+        size > 0 ? static_cast<qreal>(i) / static_cast<qreal>(size) : 1,
         "Saving data");
     QCoreApplication::processEvents();
   }
@@ -41,63 +135,84 @@ ExportSamplesTask::breathe(quint64 i)
 bool
 ExportSamplesTask::exportToMatlab(void)
 {
-  size_t size = this->data.size();
+  bool ok;
+
+  this->matlab.setProgressCallback(
+        [this] (size_t written) {
+          this->addCpuTime(this->matlab.takeWorkerCpuTime());
+          this->breathe(written);
+          return !this->cancelFlag;
+        });
+
+  ok = this->matlab.writeText(
+        "%\n"
+        "% Time domain capture file generated by SigDigger\n"
+        "%\n\n")
+      && this->matlab.writeScalar("sampleRate", this->fs)
+      && this->matlab.writeScalar("deltaT", 1 / this->fs)
+      && this->matlab.writeComplex("X", this->data.data(), this->data.size())
+      && this->matlab.close();
 
-  of << "%\n";
-  of << "% Time domain capture file generated by SigDigger\n";
-  of << "%\n\n";
+  if (!ok)
+    this->lastError =
+        "Cannot save data to MATLAB file "
+        + this->path
+        + ": "
+        + QString(strerror(errno));
 
-  of << "sampleRate = " << this->fs << ";\n";
-  of << "deltaT = " << 1 / this->fs << ";\n";
-  of << "X = [ ";
+  return ok;
+}
 
-  of << std::setprecision(std::numeric_limits<float>::digits10);
+bool
+ExportSamplesTask::exportBlocks(BlockWriter const &writer)
+{
+  size_t size = this->data.size();
+  size_t len;
 
+  for (
+       this->written = 0;
+       !this->cancelFlag && this->written < size;
+       this->written += len) {
+    len = std::min<size_t>(
+          SIGDIGGER_EXPORT_SAMPLES_BLOCK_SIZE,
+          size - this->written);
 
-  for (size_t i = 0; !this->cancelFlag && i < size; ++i) {
-    of
-       << SU_C_REAL(this->data[i]) << " + "
-       << SU_C_IMAG(this->data[i]) << "i, ";
+    if (!writer(this->data.data() + this->written, len))
+      return false;
 
-    if (i % SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE == 0)
-      this->breathe(i);
+    this->breathe(this->written + len);
   }
 
-  of << "];\n";
-
   return true;
 }
 
 bool
 ExportSamplesTask::exportToMat5(void)
 {
-  size_t size = this->data.size();
-  bool ok = false;
+  bool ok;
 
-  for (size_t i = 0; !this->cancelFlag && i < size; ++i) {
-    SU_TRYCATCH(
-          su_mat_file_stream_col(
-            this->mf,
-            SU_C_REAL(this->data[i]),
-            SU_C_IMAG(this->data[i])),
-          goto done);
-
-    if (i % SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE == 0) {
-      SU_TRYCATCH(su_mat_file_flush(mf), goto done);
-      this->breathe(i);
-    }
-  }
+  // A Mat5 matrix is stored by columns: our 2xN matrix is just the
+  // interleaved samples, which go to the file as they are.
+  ok = this->exportBlocks(
+        [this] (const SUCOMPLEX *block, size_t len) {
+          return fwrite(block, sizeof(SUCOMPLEX), len, this->mat5) == len;
+        });
 
-  SU_TRYCATCH(su_mat_file_flush(mf), goto done);
+  // Cancelled: fix the header so that the file holds what was written
+  if (ok && this->written < this->data.size())
+    ok = this->writeMat5Header(this->written);
 
-  ok = true;
+  if (ok) {
+    ok = fclose(this->mat5) == 0;
+    this->mat5 = nullptr;
+  }
 
-done:
   if (!ok)
-    emit error(
+    this->lastError =
         "Cannot save data to Mat5 file "
         + this->path
-        + ". See error log for details.");
+        + ": "
+        + QString(strerror(errno));
 
   return ok;
 }
@@ -105,44 +220,63 @@ done:
 bool
 ExportSamplesTask::exportToWav(void)
 {
-  size_t size = this->data.size();
-  bool ok = false;
-  size_t i = 0;
-
-  for (
-       i = 0;
-       !this->cancelFlag
-         && i < size - SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE;
-       i += SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE) {
-    if (sf_write_float(
-          this->sfp,
-          reinterpret_cast<const SUFLOAT *>(this->data.data() + i),
-          2 * SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE)
-        != 2 * static_cast<sf_count_t>(
-          SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE))
-        goto done;
-
-    goto done;
-
-    this->breathe(i);
-  }
+  bool ok;
 
-  if (i < size)
-    if (sf_write_float(
-        this->sfp,
-        reinterpret_cast<const SUFLOAT *>(this->data.data() + i),
-        static_cast<sf_count_t>(size - i) << 1) != 2)
-      goto done;
+  ok = this->exportBlocks(
+        [this] (const SUCOMPLEX *block, size_t len) {
+          sf_count_t count = 2 * static_cast<sf_count_t>(len);
 
-  ok = true;
+          return sf_write_float(
+                this->sfp,
+                reinterpret_cast<const SUFLOAT *>(block),
+                count) == count;
+        });
 
-done:
   if (!ok)
-    emit error(
+    this->lastError =
         "Cannot save data to WAV file "
         + this->path
         + ": "
-        + QString(sf_strerror(this->sfp)));
+        + QString(sf_strerror(this->sfp));
+
+  return ok;
+}
+
+bool
+ExportSamplesTask::exportToMap(void)
+{
+  bool int16 = this->format == "cs16";
+  bool ok;
+
+  // Samples are copied straight into the page cache
+  ok = this->exportBlocks(
+        [this, int16] (const SUCOMPLEX *block, size_t len) {
+          uint8_t *dest =
+              this->map + this->mapHeaderSize
+              + this->written * this->mapSampleSize;
+
+          if (int16)
+            realToInt16(
+                  reinterpret_cast<int16_t *>(dest),
+                  reinterpret_cast<const SUFLOAT *>(block),
+                  2 * len);
+          else
+            memcpy(dest, block, len * sizeof(SUCOMPLEX));
+
+          return true;
+        });
+
+  ok = this->closeMap() && ok;
+
+  if (ok && this->format == "sigmf")
+    ok = this->writeSigMFMeta();
+
+  if (!ok)
+    this->lastError =
+        "Cannot save data to "
+        + this->path
+        + ": "
+        + QString(strerror(errno));
 
   return ok;
 }
@@ -160,15 +294,17 @@ ExportSamplesTask::work(void)
     ok = this->exportToMatlab();
   else if (this->format == "wav")
     ok = this->exportToWav();
+  else if (this->isMapped())
+    ok = this->exportToMap();
   else
-    emit error("Unsupported data format " + this->format);
+    this->lastError = "Unsupported data format " + this->format;
 
-  if (ok) {
-    if (this->cancelFlag)
-      emit cancelled();
-    else
-      emit done();
-  }
+  if (!ok)
+    emit error(this->lastError);
+  else if (this->cancelFlag)
+    emit cancelled();
+  else
+    emit done();
 
   return false;
 }
@@ -179,37 +315,225 @@ ExportSamplesTask::cancel(void)
   this->cancelFlag = true;
 }
 
+bool
+ExportSamplesTask::writeMat5Header(quint64 samples)
+{
+  std::vector<uint8_t> header;
+  std::string text = "MATLAB 5.0 MAT-file, created by SigDigger";
+  uint16_t version = 0x0100;
+  uint16_t endian = 'M' << 8 | 'I';
+
+  text.resize(MAT5_HEADER_TEXT_SIZE, ' ');
+  header.insert(header.end(), text.begin(), text.end());
+  header.resize(header.size() + 8, 0); // No subsystem data
+  header.push_back(static_cast<uint8_t>(version & 0xff));
+  header.push_back(static_cast<uint8_t>(version >> 8));
+  header.push_back(static_cast<uint8_t>(endian & 0xff));
+  header.push_back(static_cast<uint8_t>(endian >> 8));
+
+  mat5AppendScalar(header, "sampleRate", this->fs);
+  mat5AppendScalar(header, "deltaT", 1 / this->fs);
+  mat5AppendMatrix(
+        header,
+        "X",
+        MAT5_MX_SINGLE_CLASS,
+        MAT5_MI_SINGLE,
+        2,
+        samples,
+        sizeof(SUFLOAT));
+
+  return fseeko(this->mat5, 0, SEEK_SET) == 0
+      && fwrite(header.data(), header.size(), 1, this->mat5) == 1
+      && fseeko(this->mat5, 0, SEEK_END) == 0;
+}
+
 bool
 ExportSamplesTask::openMat5(void)
 {
-  su_mat_matrix_t *mtx = nullptr;
-  bool ok = false;
+  // The size of each data element is a 32 bit field
+  if (this->data.size() * sizeof(SUCOMPLEX) > 0xffffff00) {
+    this->lastError =
+        "Selection is too big to be saved as Mat5 file (the format is "
+        "limited to 4 GiB). Please choose a different format.";
+    return false;
+  }
+
+  if ((this->mat5 = fopen(this->path.toStdString().c_str(), "wb"))
+      == nullptr
+      || !this->writeMat5Header(this->data.size())) {
+    this->lastError =
+        "Cannot create Mat5 file "
+        + this->path
+        + ": "
+        + QString(strerror(errno));
+    return false;
+  }
 
-  SU_TRYCATCH(this->mf = su_mat_file_new(), goto done);
+  return true;
+}
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_matrix(this->mf, "sampleRate", 1, 1),
-        goto done);
-  SU_TRYCATCH(su_mat_matrix_write_col(mtx, fs), goto done);
+std::string
+ExportSamplesTask::makeNpyHeader(quint64 samples, size_t size) const
+{
+  std::string header(NPY_MAGIC, NPY_MAGIC_SIZE);
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_matrix(this->mf, "deltaT", 1, 1),
-        goto done);
-  SU_TRYCATCH(su_mat_matrix_write_col(mtx, 1 / fs), goto done);
+  header.append(2, '\0'); // Header length, filled below
+  header +=
+      "{'descr': '<c8', 'fortran_order': False, 'shape': ("
+      + std::to_string(samples)
+      + ",), }";
 
-  SU_TRYCATCH(
-        mtx = su_mat_file_make_streaming_matrix(this->mf, "X", 2, 0),
-        goto done);
-  SU_TRYCATCH(su_mat_file_dump(mf, path.toStdString().c_str()), goto done);
+  // Pad with spaces up to the requested size, which must leave room for
+  // the dictionary of any shorter array too. The header ends with \n.
+  if (size == 0)
+    size = (header.size() + 1 + NPY_ALIGNMENT - 1)
+        & ~static_cast<size_t>(NPY_ALIGNMENT - 1);
 
-  ok = true;
+  header.resize(size - 1, ' ');
+  header += '\n';
 
-done:
-  if (!ok)
-    this->lastError =
-          "Cannot create Mat5 file "
-          + this->path
-          + ". See error log for details.";
+  header[NPY_MAGIC_SIZE]     = static_cast<char>((size - 10) & 0xff);
+  header[NPY_MAGIC_SIZE + 1] = static_cast<char>((size - 10) >> 8);
+
+  return header;
+}
+
+std::string
+ExportSamplesTask::getSigMFMetaPath(void) const
+{
+  std::string path = this->path.toStdString();
+  size_t suffixLen = strlen(SIGMF_DATA_SUFFIX);
+
+  if (path.size() >= suffixLen
+      && path.compare(path.size() - suffixLen, suffixLen, SIGMF_DATA_SUFFIX)
+      == 0)
+    path.resize(path.size() - suffixLen);
+
+  return path + SIGMF_META_SUFFIX;
+}
+
+bool
+ExportSamplesTask::writeSigMFMeta(void)
+{
+  std::ostringstream meta;
+  FILE *fp;
+  bool ok;
+
+  meta.precision(17);
+  meta
+      << "{\n"
+      << "  \"global\": {\n"
+      << "    \"core:datatype\": \"cf32_le\",\n"
+      << "    \"core:sample_rate\": " << this->fs << ",\n"
+      << "    \"core:version\": \"1.0.0\",\n"
+      << "    \"core:recorder\": \"SigDigger\"\n"
+      << "  },\n"
+      << "  \"captures\": [\n"
+      << "    { \"core:sample_start\": 0 }\n"
+      << "  ],\n"
+      << "  \"annotations\": []\n"
+      << "}\n";
+
+  if ((fp = fopen(this->getSigMFMetaPath().c_str(), "w")) == nullptr)
+    return false;
+
+  ok = fputs(meta.str().c_str(), fp) >= 0;
+
+  return fclose(fp) == 0 && ok;
+}
+
+bool
+ExportSamplesTask::isMapped(void) const
+{
+  return this->format == "npy"
+      || this->format == "cf32"
+      || this->format == "cs16"
+      || this->format == "sigmf";
+}
+
+bool
+ExportSamplesTask::openMap(void)
+{
+  std::string header;
+  size_t size;
+
+  if (this->format == "npy")
+    header = this->makeNpyHeader(this->data.size());
+
+  this->mapHeaderSize = header.size();
+  this->mapSampleSize =
+      this->format == "cs16" ? 2 * sizeof(int16_t) : sizeof(SUCOMPLEX);
+  size = this->mapHeaderSize + this->data.size() * this->mapSampleSize;
+
+  if ((this->fd = open(
+         this->path.toStdString().c_str(),
+         O_RDWR | O_CREAT | O_TRUNC,
+         0644)) == -1)
+    goto fail;
+
+  if (size == 0)
+    return true;
+
+  // Reserve the blocks now: running out of space while writing to the
+  // map would kill us with SIGBUS instead of failing gracefully.
+  if (ftruncate(this->fd, static_cast<off_t>(size)) == -1)
+    goto fail;
+
+  if ((errno = posix_fallocate(this->fd, 0, static_cast<off_t>(size))) != 0)
+    goto fail;
+
+  if ((this->map = static_cast<uint8_t *>(
+         mmap(
+           nullptr,
+           size,
+           PROT_READ | PROT_WRITE,
+           MAP_SHARED,
+           this->fd,
+           0))) == MAP_FAILED) {
+    this->map = nullptr;
+    goto fail;
+  }
+
+  this->mapSize = size;
+  memcpy(this->map, header.data(), header.size());
+
+  return true;
+
+fail:
+  this->lastError =
+      "Cannot create "
+      + this->path
+      + ": "
+      + QString(strerror(errno));
+
+  return false;
+}
+
+bool
+ExportSamplesTask::closeMap(void)
+{
+  size_t size = this->mapHeaderSize + this->written * this->mapSampleSize;
+  bool ok = true;
+
+  if (this->map != nullptr) {
+    // Cancelled: the array holds the samples that made it to the file
+    if (this->written < this->data.size() && this->format == "npy")
+      memcpy(
+            this->map,
+            this->makeNpyHeader(this->written, this->mapHeaderSize).data(),
+            this->mapHeaderSize);
+
+    ok = munmap(this->map, this->mapSize) == 0;
+    this->map = nullptr;
+  }
+
+  if (this->fd != -1) {
+    if (ok && size < this->mapSize)
+      ok = ftruncate(this->fd, static_cast<off_t>(size)) == 0;
+
+    ok = close(this->fd) == 0 && ok;
+    this->fd = -1;
+  }
 
   return ok;
 }
@@ -223,9 +547,7 @@ ExportSamplesTask::getLastError(void) const
 bool
 ExportSamplesTask::openMatlab(void)
 {
-  this->of = std::ofstream(path.toStdString().c_str(), std::ofstream::binary);
-
-  if (!of.is_open()) {
+  if (!this->matlab.open(this->path.toStdString())) {
     this->lastError =
         "Cannot open "
         + this->path
@@ -270,8 +592,10 @@ ExportSamplesTask::attemptOpen(void)
     return this->openMatlab();
   else if (this->format == "wav")
     return this->openWav();
+  else if (this->isMapped())
+    return this->openMap();
 
-  this->lastError = "Unsupported format \"" + this->lastError + "\"";
+  this->lastError = "Unsupported format \"" + this->format + "\"";
 
   return false;
 }
@@ -281,23 +605,27 @@ ExportSamplesTask::~ExportSamplesTask(void)
   if (this->sfp != nullptr)
     sf_close(this->sfp);
 
-  if (this->mf != nullptr)
-    su_mat_file_destroy(this->mf);
+  if (this->mat5 != nullptr)
+    fclose(this->mat5);
+
+  this->closeMap();
 }
 
 ExportSamplesTask::ExportSamplesTask(
     QString const &path,
     QString const &format,
-    const SUCOMPLEX *data,
-    size_t length,
+    SampleBuffer const &data,
     qreal fs,
     int start,
-    int end)
+    int end) :
+  cancelFlag(false)
 {
   if (start < 0)
     start = 0;
-  if (end > static_cast<int>(length))
-    end = static_cast<int>(length);
+  if (end > static_cast<int>(data.size()))
+    end = static_cast<int>(data.size());
+  if (end < start)
+    end = start;
 
   this->start  = start;
   this->end    = end;
@@ -305,7 +633,10 @@ ExportSamplesTask::ExportSamplesTask(
   this->path   = path;
   this->format = format;
 
-  this->data.resize(static_cast<unsigned>(end - start));
-  this->data.assign(data + start, data + end);
+  // Just a reference: takes no memory, even while the task is queued
+  this->data = data.slice(
+        static_cast<size_t>(start),
+        static_cast<size_t>(end - start));
   this->setDataSize(this->data.size());
+  this->setResource(Suscan::TaskResource::DISK);
 }
@@ -23,67 +23,65 @@ using namespace SigDigger;
 
 HistogramFeeder::HistogramFeeder(
     SamplingProperties const &props,
-    QObject *parent) : CancellableTask(parent)
+    QObject *parent) : SplittableTask(parent)
 {
   this->properties = props;
+  this->block.resize(SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH);
+
+  // Instantaneous frequency needs the previous sample
+  this->setRange(
+        props.space == FREQUENCY && props.length > 0 ? 1 : 0,
+        props.length);
+  this->setBlockLength(SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH);
 }
 
 HistogramFeeder::~HistogramFeeder()
 {
 }
 
-bool
-HistogramFeeder::work(void)
+void
+HistogramFeeder::processRange(size_t first, size_t len)
 {
-  size_t amount = this->properties.length - this->p;
-  size_t p = this->p;
-  unsigned int q = 0;
-
-  if (amount > SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH)
-    amount = SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH;
+  // Blocks start every SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH samples
+  size_t offset =
+      (first - this->getRangeFirst()) % SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH;
+  const SUCOMPLEX *data = this->properties.data + first;
+  SUFLOAT *q = this->block.data() + offset;
 
   switch (this->properties.space) {
     case AMPLITUDE:
-      while (amount--)
-        this->block[q++] = SU_C_ABS(this->properties.data[p++]);
+      while (len--)
+        *q++ = SU_C_ABS(*data++);
       break;
 
     case PHASE:
-      while (amount--)
-        this->block[q++] = SU_C_ARG(this->properties.data[p++]);
+      while (len--)
+        *q++ = SU_C_ARG(*data++);
       break;
 
     case FREQUENCY:
-      while (amount--) {
-        if (p > 0)
-          this->block[q++] = SU_C_ARG(
-              this->properties.data[p]
-              * SU_C_CONJ(this->properties.data[p - 1]));
-        ++p;
+      while (len--) {
+        *q++ = SU_C_ARG(data[0] * SU_C_CONJ(data[-1]));
+        ++data;
       }
 
       break;
   }
+}
 
-
-  this->p = p;
-
+void
+HistogramFeeder::blockDone(size_t first, size_t len)
+{
   this->setStatus("Measuring ("
-                  + QString::number(p)
+                  + QString::number(first + len)
                   + "/"
                   + QString::number(this->properties.length)
                   + ")...");
 
-  this->setProgress(
-        static_cast<qreal>(p) / static_cast<qreal>(this->properties.length));
-
-  emit data(this->block, q);
-
-  if (this->p < this->properties.length)
-    return true;
-
-  emit done();
-  return false;
+  // The receiver reads the block from another thread: once delivered,
+  // it must not be touched until we go through the event loop again.
+  emit data(this->block.data(), static_cast<unsigned int>(len));
+  this->endSlice();
 }
 
 void
@@ -0,0 +1,183 @@
+//
+//    PipelineStages.cpp: Translation, filtering and measurement stages
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <PipelineStages.h>
+#include <CarrierXlator.h>
+#include <Suscan/Library.h>
+#include <sigutils/sampling.h>
+#include <cmath>
+
+using namespace SigDigger;
+
+//////////////////////////////// XlatorStage ///////////////////////////////////
+XlatorStage::XlatorStage(SUFLOAT relFreq, QObject *parent) :
+  PipelineStage(parent)
+{
+  this->omega = static_cast<double>(SU_NORM2ANG_FREQ(-relFreq));
+}
+
+void
+XlatorStage::process(SampleBlock &block)
+{
+  double phase = std::fmod(
+        this->omega * static_cast<double>(block.offset),
+        2 * M_PI);
+
+  // Same rotation as CarrierXlator: blocks are stitched together without
+  // phase jumps, and rounding errors do not pile up along the stream
+  CarrierXlator::rotate(
+        block.samples.data(),
+        block.samples.data(),
+        block.samples.size(),
+        this->omega,
+        phase);
+}
+
+/////////////////////////////// LowpassStage ///////////////////////////////////
+LowpassStage::LowpassStage(
+    unsigned int order,
+    SUFLOAT relCutoff,
+    QObject *parent) : PipelineStage(parent)
+{
+  SU_ATTEMPT(su_iir_bwlpf_init(&this->filt, order, relCutoff));
+  this->filtInit = true;
+}
+
+LowpassStage::~LowpassStage()
+{
+  if (this->filtInit)
+    su_iir_filt_finalize(&this->filt);
+}
+
+void
+LowpassStage::process(SampleBlock &block)
+{
+  for (auto &x : block.samples)
+    x = su_iir_filt_feed(&this->filt, x);
+}
+
+////////////////////////////// HistogramStage //////////////////////////////////
+HistogramStage::HistogramStage(SamplingSpace space, QObject *parent) :
+  PipelineStage(parent)
+{
+  qRegisterMetaType<QVector<float>>();
+
+  this->space = space;
+}
+
+void
+HistogramStage::process(SampleBlock &block)
+{
+  QVector<float> values;
+
+  values.reserve(static_cast<int>(block.samples.size()));
+
+  switch (this->space) {
+    case AMPLITUDE:
+      for (auto x : block.samples)
+        values.push_back(SU_C_ABS(x));
+      break;
+
+    case PHASE:
+      for (auto x : block.samples)
+        values.push_back(SU_C_ARG(x));
+      break;
+
+    case FREQUENCY:
+      for (auto x : block.samples) {
+        if (this->havePrev)
+          values.push_back(SU_C_ARG(x * SU_C_CONJ(this->prev)));
+        this->prev = x;
+        this->havePrev = true;
+      }
+      break;
+  }
+
+  // Values travel by copy: the block goes back to the pipeline right away
+  emit data(values);
+}
+
+/////////////////////////////// SamplerStage ///////////////////////////////////
+SamplerStage::SamplerStage(
+    SamplingProperties const &props,
+    const Decider *decider,
+    QObject *parent) : PipelineStage(parent)
+{
+  SUFLOAT bnor = SU_ABS2NORM_BAUD(props.fs, props.rate);
+
+  qRegisterMetaType<SigDigger::WaveSampleSet>();
+
+  this->properties = props;
+  this->decider    = decider;
+
+  SU_ATTEMPT(
+        su_clock_detector_init(
+          &this->cd,
+          props.loopGain,
+          bnor,
+          SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH) != -1);
+  this->cdInit = true;
+}
+
+SamplerStage::~SamplerStage()
+{
+  if (this->cdInit)
+    su_clock_detector_finalize(&this->cd);
+}
+
+void
+SamplerStage::deliver(void)
+{
+  SUSDIFF count;
+
+  while ((count = su_clock_detector_read(
+            &this->cd,
+            this->set.block,
+            SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH)) > 0) {
+    this->set.len = static_cast<size_t>(count);
+    this->decider->decide(this->set.block, this->set.symbols, this->set.len);
+    emit data(this->set);
+  }
+}
+
+void
+SamplerStage::process(SampleBlock &block)
+{
+  size_t i = 0;
+
+  // The detector buffers at most one block of symbols: read them often
+  for (auto x : block.samples) {
+    if (this->properties.space == FREQUENCY) {
+      su_clock_detector_feed(&this->cd, x * SU_C_CONJ(this->prev));
+      this->prev = x;
+    } else {
+      su_clock_detector_feed(&this->cd, x);
+    }
+
+    if (++i % SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH == 0)
+      this->deliver();
+  }
+
+  this->deliver();
+}
+
+void
+SamplerStage::finish(void)
+{
+  this->deliver();
+}
@@ -0,0 +1,284 @@
+//
+//    SamplePipeline.cpp: Streaming sample processing pipelines
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#include <SamplePipeline.h>
+#include <algorithm>
+
+using namespace SigDigger;
+
+///////////////////////////// SampleBlockQueue /////////////////////////////////
+SampleBlockQueue::SampleBlockQueue(size_t capacity)
+{
+  this->capacity = std::max<size_t>(capacity, 1);
+}
+
+bool
+SampleBlockQueue::push(SampleBlock &&block)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  this->cond.wait(
+        lock,
+        [this] () {
+          return this->aborted || this->blocks.size() < this->capacity;
+        });
+
+  if (this->aborted)
+    return false;
+
+  this->blocks.push_back(std::move(block));
+  this->cond.notify_all();
+
+  return true;
+}
+
+bool
+SampleBlockQueue::pop(SampleBlock &block)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  this->cond.wait(
+        lock,
+        [this] () {
+          return this->aborted || this->closed || !this->blocks.empty();
+        });
+
+  if (this->aborted || this->blocks.empty())
+    return false;
+
+  block = std::move(this->blocks.front());
+  this->blocks.pop_front();
+  this->cond.notify_all();
+
+  return true;
+}
+
+void
+SampleBlockQueue::close(void)
+{
+  std::lock_guard<std::mutex> guard(this->mutex);
+
+  this->closed = true;
+  this->cond.notify_all();
+}
+
+void
+SampleBlockQueue::abort(void)
+{
+  std::lock_guard<std::mutex> guard(this->mutex);
+
+  this->aborted = true;
+  this->cond.notify_all();
+}
+
+////////////////////////////// PipelineStage ///////////////////////////////////
+PipelineStage::PipelineStage(QObject *parent) : QObject(parent)
+{
+}
+
+PipelineStage::~PipelineStage()
+{
+}
+
+void
+PipelineStage::finish(void)
+{
+}
+
+////////////////////////////// SamplePipeline //////////////////////////////////
+SamplePipeline::SamplePipeline(SampleBuffer const &source, QObject *parent) :
+  CancellableTask(parent),
+  consumed(0),
+  cancelFlag(false)
+{
+  this->source = source;
+
+  this->setDataSize(source.size());
+  this->setProgress(0);
+  this->setStatus("Starting pipeline");
+}
+
+SamplePipeline::~SamplePipeline()
+{
+  this->abort();
+  this->join();
+
+  for (auto q : this->queues)
+    delete q;
+
+  for (auto s : this->stages)
+    delete s;
+}
+
+void
+SamplePipeline::addStage(PipelineStage *stage)
+{
+  if (!this->started)
+    this->stages.push_back(stage);
+}
+
+void
+SamplePipeline::runStage(size_t index)
+{
+  SampleBlockQueue *in  = this->queues[index];
+  SampleBlockQueue *out = this->queues[index + 1];
+  bool last = index + 1 == this->stages.size();
+  SampleBlock block;
+
+  while (in->pop(block)) {
+    size_t len = block.samples.size();
+
+    this->stages[index]->process(block);
+
+    // Only fails if the pipeline was aborted
+    if (!out->push(std::move(block)))
+      break;
+
+    if (last)
+      this->consumed += len;
+  }
+
+  // Closed and drained: nothing else is coming
+  if (!this->cancelFlag) {
+    this->stages[index]->finish();
+
+    if (!last)
+      out->close();
+  }
+
+  // This thread belongs to the pipeline: all its CPU time counts
+  this->addCpuTime(threadCpuTime());
+}
+
+void
+SamplePipeline::start(void)
+{
+  size_t blocks = (this->stages.size() + 1) * SIGDIGGER_PIPELINE_QUEUE_DEPTH;
+  SampleBlockQueue *spare;
+
+  std::lock_guard<std::mutex> guard(this->threadMutex);
+
+  if (this->cancelFlag)
+    return;
+
+  for (size_t i = 0; i < this->stages.size(); ++i)
+    this->queues.push_back(
+          new SampleBlockQueue(SIGDIGGER_PIPELINE_QUEUE_DEPTH));
+
+  // Every block of the pipeline fits in here, so pushing never waits
+  spare = new SampleBlockQueue(blocks);
+  this->queues.push_back(spare);
+
+  for (size_t i = 0; i < blocks; ++i) {
+    SampleBlock block;
+
+    block.samples.reserve(SIGDIGGER_PIPELINE_BLOCK_LENGTH);
+    spare->push(std::move(block));
+  }
+
+  for (size_t i = 0; i < this->stages.size(); ++i)
+    this->threads.push_back(std::thread(&SamplePipeline::runStage, this, i));
+
+  this->started = true;
+}
+
+void
+SamplePipeline::abort(void)
+{
+  std::lock_guard<std::mutex> guard(this->threadMutex);
+
+  this->cancelFlag = true;
+
+  for (auto q : this->queues)
+    q->abort();
+}
+
+void
+SamplePipeline::join(void)
+{
+  std::lock_guard<std::mutex> guard(this->threadMutex);
+
+  for (auto &thread : this->threads)
+    if (thread.joinable())
+      thread.join();
+}
+
+bool
+SamplePipeline::work(void)
+{
+  SampleBlock block;
+  size_t len;
+
+  if (!this->started)
+    this->start();
+
+  if (this->cancelFlag)
+    return false;
+
+  if (this->stages.empty()) {
+    emit done();
+    return false;
+  }
+
+  if (this->p < this->source.size()) {
+    // Waits for a block to come back if all of them are in use
+    if (!this->queues.back()->pop(block))
+      return false;
+
+    len = std::min<size_t>(
+          SIGDIGGER_PIPELINE_BLOCK_LENGTH,
+          this->source.size() - this->p);
+
+    block.samples.assign(
+          this->source.data() + this->p,
+          this->source.data() + this->p + len);
+    block.offset = this->p;
+    this->p += len;
+
+    if (!this->queues.front()->push(std::move(block)))
+      return false;
+
+    this->setProgress(
+          static_cast<qreal>(this->consumed)
+          / static_cast<qreal>(this->source.size()));
+    this->setStatus(
+          "Processing ("
+          + QString::number(this->consumed)
+          + "/"
+          + QString::number(this->source.size())
+          + ")...");
+
+    return true;
+  }
+
+  // Let the stages drain what is left
+  this->queues.front()->close();
+  this->join();
+
+  emit done();
+  return false;
+}
+
+void
+SamplePipeline::cancel(void)
+{
+  this->abort();
+  this->join();
+
+  emit cancelled();
+}
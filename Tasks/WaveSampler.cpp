@@ -19,13 +19,13 @@
 
 #include <WaveSampler.h>
 #include <Suscan/Library.h>
+#include <Suscan/SplittableTask.h>
 #include <sigutils/sampling.h>
 #include <sigutils/taps.h>
+#include <algorithm>
 
 using namespace SigDigger;
 
-Q_DECLARE_METATYPE(SigDigger::WaveSampleSet);
-
 static bool registered;
 
 WaveSampler::WaveSampler(
@@ -88,66 +88,97 @@ WaveSampler::~WaveSampler()
 #endif // SIGDIGGER_WAVESAMPLER_USE_MF
 }
 
-bool
-WaveSampler::sampleManual(void)
+SUCOMPLEX
+WaveSampler::sampleSymbol(long p, SUCOMPLEX &prev) const
 {
-  long amount = static_cast<long>(this->properties.symbolCount) - this->p;
-  long p = this->p;
-
-  unsigned int q = 0;
   SUFLOAT start, end;
   SUFLOAT tStart, tEnd;
   SUFLOAT deltaInv = 1.f / static_cast<SUFLOAT>(this->delta);
   long iStart, iEnd;
 
-  SUCOMPLEX avg;
-  SUCOMPLEX x = 0, prev = this->prevSample;
+  SUCOMPLEX avg = 0;
+  SUCOMPLEX x = 0;
 
-  if (amount > SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH)
-    amount = SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH;
+  start = static_cast<SUFLOAT>(
+        (p - this->sampOffset) * this->delta + this->properties.symbolSync);
+  end = start + static_cast<SUFLOAT>(this->delta);
 
-  while (amount--) {
-    start = static_cast<SUFLOAT>(
-          (p++ - this->sampOffset) * this->delta + this->properties.symbolSync);
-    end = start + static_cast<SUFLOAT>(this->delta);
-    avg = 0;
-
-    iStart = static_cast<long>(std::floor(start));
-    iEnd   = static_cast<long>(std::ceil(end));
-
-    tStart = 1 - (start - iStart);
-    tEnd   = 1 - (iEnd  - end);
-
-    // Average all symbols between start and end. This is actually some
-    // terrible filtering algorithm, but it should work
-
-    for (auto i = iStart; i <= iEnd; ++i) {
-      if (i >= 0 && i < static_cast<long>(this->properties.length)) {
-        if (i == iStart)
-          x = tStart * this->properties.data[i];
-        else if (i == iEnd)
-          x = tEnd * this->properties.data[i];
-        else
-          x = this->properties.data[i];
-      } else {
-        x = 0;
-      }
-
-      if (this->properties.space == FREQUENCY)
-        avg += x * SU_C_CONJ(prev);
-      else
-        avg += x;
+  iStart = static_cast<long>(std::floor(start));
+  iEnd   = static_cast<long>(std::ceil(end));
 
-      prev = x;
+  tStart = 1 - (start - iStart);
+  tEnd   = 1 - (iEnd  - end);
+
+  // Average all symbols between start and end. This is actually some
+  // terrible filtering algorithm, but it should work
+
+  for (auto i = iStart; i <= iEnd; ++i) {
+    if (i >= 0 && i < static_cast<long>(this->properties.length)) {
+      if (i == iStart)
+        x = tStart * this->properties.data[i];
+      else if (i == iEnd)
+        x = tEnd * this->properties.data[i];
+      else
+        x = this->properties.data[i];
+    } else {
+      x = 0;
     }
 
-    this->set.block[q++] = deltaInv * avg;
+    if (this->properties.space == FREQUENCY)
+      avg += x * SU_C_CONJ(prev);
+    else
+      avg += x;
+
+    prev = x;
   }
 
-  this->prevSample = prev;
+  return deltaInv * avg;
+}
 
-  this->p = p;
-  this->set.len = q;
+bool
+WaveSampler::sampleManual(void)
+{
+  long amount = static_cast<long>(this->properties.symbolCount) - this->p;
+  long p0 = this->p;
+  SUCOMPLEX initial = this->prevSample;
+  SUCOMPLEX last = initial;
+  size_t minPiece = static_cast<size_t>(
+        SIGDIGGER_WAVESAMPLER_MIN_PIECE_SAMPLES / std::max(this->delta, 1.));
+
+  if (amount > SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH)
+    amount = SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH;
+
+  if (amount < 0)
+    amount = 0;
+
+  // A symbol only depends on the samples it spans and, in FREQUENCY space,
+  // on the last sample of the previous symbol. Pieces of the block can be
+  // sampled at the same time if each one works that sample out first.
+  this->addCpuTime(
+        Suscan::parallelFor(
+          static_cast<size_t>(p0),
+          static_cast<size_t>(amount),
+          minPiece,
+          [this, p0, amount, initial, &last] (size_t first, size_t len) {
+            long p = static_cast<long>(first);
+            SUCOMPLEX prev = initial;
+
+            if (p > p0)
+              (void) this->sampleSymbol(p - 1, prev);
+
+            while (len--) {
+              this->set.block[p - p0] = this->sampleSymbol(p, prev);
+              ++p;
+            }
+
+            if (p == p0 + amount)
+              last = prev;
+          }));
+
+  this->prevSample = last;
+
+  this->p = p0 + amount;
+  this->set.len = static_cast<size_t>(amount);
 
   this->progress = this->p / this->properties.symbolCount;
 
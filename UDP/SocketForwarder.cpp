@@ -20,9 +20,19 @@
 #include <SocketForwarder.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
 #include <stdexcept>
+#include <memory>
+#include <deque>
+#include <atomic>
 
 #ifndef MSG_NOSIGNAL
 #  define MSG_NOSIGNAL 0
@@ -32,23 +42,41 @@ using namespace SigDigger;
 
 namespace SigDigger {
   class SocketDataWriter : public GenericDataWriter {
-    std::string host;
-    uint16_t port;
-    char pad[2];
+    SocketForwarder::ForwarderParams params;
     struct sockaddr_in addr;
     int fd = -1;
     bool solved = false;
-    bool tcp = false;
-    char pad2[2];
+    char pad[3];
     unsigned int size = 0;
+    size_t samplesPerDatagram = 0;
+    size_t samplesPerUnit = 1; // Real samples packed in a SUCOMPLEX
     std::string lastError;
 
+    // Framing state
+    uint32_t sequence = 0;
+    uint64_t sampleIndex = 0; // In SUCOMPLEX units
+
+    // Pacing state
+    struct timespec paceStart;
+    quint64 paceBytes = 0;
+
+    // Preallocated batch
+    ForwarderFrameHeader headers[SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+    struct iovec iov[2 * SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+#ifdef __linux__
+    struct mmsghdr msgs[SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+#else
+    struct msghdr msgs[SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+#endif // __linux__
+    size_t counts[SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+
+    void pace(quint64 bytes);
+    int sendBatch(unsigned int n);
+    ssize_t writeStream(const SUCOMPLEX *data, size_t len);
+    ssize_t writeDatagrams(const SUCOMPLEX *data, size_t len);
+
   public:
-    SocketDataWriter(
-        std::string const &host,
-        uint16_t port,
-        unsigned int size,
-        bool tcp);
+    SocketDataWriter(SocketForwarder::ForwarderParams const &params);
 
     bool prepare(void) override;
     std::string getError(void) const override;
@@ -57,16 +85,131 @@ namespace SigDigger {
     bool close(void) override;
     ~SocketDataWriter() override;
   };
+
+  typedef std::shared_ptr<const std::vector<SUCOMPLEX>> SampleBlock;
+
+  struct ServerClient {
+    int fd = -1;
+    std::deque<SampleBlock> queue;
+    size_t offset = 0;   // Bytes of the first block already sent
+    size_t queued = 0;   // Bytes waiting in the queue
+    quint64 dropped = 0; // Bytes dropped due to a full queue
+    bool closing = false;
+  };
+
+  class SocketServerWriter;
+
+  class SocketServerThread : public QThread {
+    SocketServerWriter *writer;
+
+    void run() override;
+
+  public:
+    SocketServerThread(SocketServerWriter *writer) : writer(writer) { }
+  };
+
+  class SocketServerWriter : public GenericDataWriter {
+    SocketForwarder::ForwarderParams params;
+    std::string lastError;
+    int wakeFds[2] = {-1, -1};
+    bool prepared = false;
+
+    // Read by the event loop and the data worker, set by the owner
+    std::atomic<int> listenFd;
+    std::atomic<bool> running;
+    quint64 dropped = 0;
+
+    // Only the event loop adds or removes clients. Queues are filled
+    // from the data worker thread.
+    std::vector<std::unique_ptr<ServerClient>> clients;
+    mutable QMutex mutex;
+    SocketServerThread thread;
+
+    void wake(void);
+    void acceptClients(void);
+    void flushClient(ServerClient *client);
+    void loop(void);
+
+  public:
+    SocketServerWriter(SocketForwarder::ForwarderParams const &params);
+
+    bool prepare(void) override;
+    std::string getError(void) const override;
+    bool canWrite(void) const override;
+    ssize_t write(const SUCOMPLEX *data, size_t len) override;
+    quint64 getDropped(void) const override;
+    bool close(void) override;
+    ~SocketServerWriter() override;
+
+    friend class SocketServerThread;
+  };
+}
+
+static bool
+setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL);
+
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+static inline uint64_t
+hostToBigEndian64(uint64_t val)
+{
+  return
+      (static_cast<uint64_t>(htonl(static_cast<uint32_t>(val))) << 32)
+      | htonl(static_cast<uint32_t>(val >> 32));
+}
+
+static size_t
+forwarderSampleSize(ForwarderSampleFormat format)
+{
+  switch (format) {
+    case FORWARDER_FORMAT_FLOAT32:
+      return sizeof(float);
+
+    case FORWARDER_FORMAT_INT16:
+      return sizeof(int16_t);
+
+    default:
+      return sizeof(SUCOMPLEX);
+  }
+}
+
+static inline uint64_t
+timespecToNs(struct timespec const &ts)
+{
+  return
+      static_cast<uint64_t>(ts.tv_sec) * 1000000000ull
+      + static_cast<uint64_t>(ts.tv_nsec);
 }
 
 SocketDataWriter::SocketDataWriter(
-    std::string const &host,
-    uint16_t port,
-    unsigned int size,
-    bool tcp) :
-  host(host), port(port), tcp(tcp), size(size / sizeof(SUCOMPLEX))
+    SocketForwarder::ForwarderParams const &params) :
+  params(params),
+  size(params.size / sizeof(SUCOMPLEX))
 {
-  this->pad[0] = this->pad2[0] = 0; // Shut up
+  size_t payload = params.size;
+
+  this->pad[0] = 0; // Shut up
+
+  if (params.framed)
+    payload = payload > sizeof(ForwarderFrameHeader)
+        ? payload - sizeof(ForwarderFrameHeader)
+        : 0;
+
+  this->samplesPerDatagram = payload / sizeof(SUCOMPLEX);
+  this->samplesPerUnit =
+      sizeof(SUCOMPLEX) / forwarderSampleSize(params.format);
+
+  // Datagram sizes are still counted in SUCOMPLEX units
+  if (this->samplesPerDatagram == 0)
+    this->samplesPerDatagram = 1;
+  else if (this->samplesPerDatagram > UINT16_MAX / this->samplesPerUnit)
+    this->samplesPerDatagram = UINT16_MAX / this->samplesPerUnit;
+
+  memset(this->msgs, 0, sizeof(this->msgs));
+  memset(&this->paceStart, 0, sizeof(this->paceStart));
 }
 
 bool
@@ -75,25 +218,25 @@ SocketDataWriter::prepare(void)
   if (!this->solved) {
     struct hostent *ent;
 
-    if ((ent = gethostbyname(this->host.c_str())) == nullptr) {
-      this->lastError = "Failed to resolve hostname " + this->host;
+    if ((ent = gethostbyname(this->params.host.c_str())) == nullptr) {
+      this->lastError = "Failed to resolve hostname " + this->params.host;
       return false;
     }
 
     if ((this->fd = socket(
            AF_INET,
-           this->tcp ? SOCK_STREAM : SOCK_DGRAM,
+           this->params.tcp ? SOCK_STREAM : SOCK_DGRAM,
            0)) == -1) {
       this->lastError = "Failed to open socket: " + std::string(strerror(errno));
       return false;
     }
 
     this->addr.sin_family = AF_INET;
-    this->addr.sin_port = htons(this->port);
+    this->addr.sin_port = htons(this->params.port);
     this->addr.sin_addr = *reinterpret_cast<struct in_addr *>(ent->h_addr);
     memset(this->addr.sin_zero, 0, 8);
 
-    if (this->tcp) {
+    if (this->params.tcp) {
       if (connect(
             this->fd,
             reinterpret_cast<struct sockaddr *>(&this->addr),
@@ -120,8 +263,55 @@ SocketDataWriter::canWrite(void) const
   return !this->solved || this->fd != -1;
 }
 
+void
+SocketDataWriter::pace(quint64 bytes)
+{
+  struct timespec now, delay;
+  uint64_t elapsed, expected;
+
+  if (this->params.pacing == 0)
+    return;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if (this->paceBytes == 0)
+    this->paceStart = now;
+
+  this->paceBytes += bytes;
+
+  expected = static_cast<uint64_t>(
+        1e9 * static_cast<double>(this->paceBytes)
+        / static_cast<double>(this->params.pacing));
+  elapsed = timespecToNs(now) - timespecToNs(this->paceStart);
+
+  if (expected > elapsed) {
+    delay.tv_sec  = static_cast<time_t>((expected - elapsed) / 1000000000ull);
+    delay.tv_nsec = static_cast<long>((expected - elapsed) % 1000000000ull);
+    nanosleep(&delay, nullptr);
+  } else if (elapsed - expected > 100000000ull) {
+    // More than 100 ms behind: do not try to catch up in a burst
+    this->paceBytes = 0;
+  }
+}
+
+int
+SocketDataWriter::sendBatch(unsigned int n)
+{
+#ifdef __linux__
+  return sendmmsg(this->fd, this->msgs, n, MSG_NOSIGNAL);
+#else
+  unsigned int i;
+
+  for (i = 0; i < n; ++i)
+    if (sendmsg(this->fd, &this->msgs[i], MSG_NOSIGNAL) == -1)
+      break;
+
+  return i == 0 && n > 0 ? -1 : static_cast<int>(i);
+#endif // __linux__
+}
+
 ssize_t
-SocketDataWriter::write(const SUCOMPLEX *data, size_t len)
+SocketDataWriter::writeStream(const SUCOMPLEX *data, size_t len)
 {
   ssize_t sent;
 
@@ -139,13 +329,102 @@ SocketDataWriter::write(const SUCOMPLEX *data, size_t len)
   if (sent < 1)
     this->lastError = std::string(strerror(errno));
 
-
   sent /= static_cast<ssize_t>(sizeof(SUCOMPLEX));
 
-
   return sent;
 }
 
+ssize_t
+SocketDataWriter::writeDatagrams(const SUCOMPLEX *data, size_t len)
+{
+  struct timespec ts;
+  struct msghdr *hdr;
+  struct iovec *iov;
+  uint64_t timestamp;
+  unsigned int n = 0;
+  size_t offset = 0;
+  size_t samples = 0;
+  quint64 bytes = 0;
+  int i, sent;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  timestamp = hostToBigEndian64(timespecToNs(ts));
+
+  // Slice data into datagrams. Payloads point to the caller's buffer.
+  while (n < SIGDIGGER_UDPFORWARDER_BATCH_SIZE && offset < len) {
+    size_t count = len - offset;
+
+    if (count > this->samplesPerDatagram)
+      count = this->samplesPerDatagram;
+
+#ifdef __linux__
+    hdr = &this->msgs[n].msg_hdr;
+#else
+    hdr = &this->msgs[n];
+#endif // __linux__
+    iov = this->iov + 2 * n;
+
+    hdr->msg_name    = &this->addr;
+    hdr->msg_namelen = sizeof(struct sockaddr_in);
+    hdr->msg_iov     = iov;
+    hdr->msg_iovlen  = 0;
+
+    if (this->params.framed) {
+      ForwarderFrameHeader *header = &this->headers[n];
+
+      header->magic       = htonl(SIGDIGGER_FORWARDER_FRAME_MAGIC);
+      header->version     = SIGDIGGER_FORWARDER_FRAME_VERSION;
+      header->format      = static_cast<uint8_t>(this->params.format);
+      header->count       = htons(
+            static_cast<uint16_t>(count * this->samplesPerUnit));
+      header->sequence    = htonl(this->sequence + n);
+      header->flags       = 0;
+      header->sampleIndex = hostToBigEndian64(
+            (this->sampleIndex + offset) * this->samplesPerUnit);
+      header->timestamp   = timestamp;
+
+      iov[hdr->msg_iovlen].iov_base = header;
+      iov[hdr->msg_iovlen].iov_len  = sizeof(ForwarderFrameHeader);
+      ++hdr->msg_iovlen;
+    }
+
+    iov[hdr->msg_iovlen].iov_base = const_cast<SUCOMPLEX *>(data + offset);
+    iov[hdr->msg_iovlen].iov_len  = count * sizeof(SUCOMPLEX);
+    ++hdr->msg_iovlen;
+
+    this->counts[n++] = count;
+    offset += count;
+  }
+
+  if ((sent = this->sendBatch(n)) < 1) {
+    this->lastError = std::string(strerror(errno));
+    return -1;
+  }
+
+  for (i = 0; i < sent; ++i) {
+    samples += this->counts[i];
+    bytes   += this->counts[i] * sizeof(SUCOMPLEX);
+    if (this->params.framed)
+      bytes += sizeof(ForwarderFrameHeader);
+  }
+
+  this->sequence    += static_cast<uint32_t>(sent);
+  this->sampleIndex += samples;
+
+  this->pace(bytes);
+
+  return static_cast<ssize_t>(samples);
+}
+
+ssize_t
+SocketDataWriter::write(const SUCOMPLEX *data, size_t len)
+{
+  if (this->params.tcp)
+    return this->writeStream(data, len);
+
+  return this->writeDatagrams(data, len);
+}
+
 bool
 SocketDataWriter::close(void)
 {
@@ -164,14 +443,357 @@ SocketDataWriter::~SocketDataWriter(void)
   this->close();
 }
 
+//////////////////////////// SocketServerWriter ////////////////////////////////
+void
+SocketServerThread::run(void)
+{
+  this->writer->loop();
+}
+
+SocketServerWriter::SocketServerWriter(
+    SocketForwarder::ForwarderParams const &params) :
+  params(params),
+  listenFd(-1),
+  running(false),
+  thread(this)
+{
+}
+
+bool
+SocketServerWriter::prepare(void)
+{
+  struct sockaddr_in addr;
+  struct hostent *ent;
+  int on = 1;
+
+  // A single attempt. If it fails, canWrite() reports it from now on.
+  if (this->prepared)
+    return this->listenFd != -1;
+
+  this->prepared = true;
+
+  memset(&addr, 0, sizeof(struct sockaddr_in));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(this->params.port);
+
+  if (this->params.host.empty()) {
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  } else {
+    if ((ent = gethostbyname(this->params.host.c_str())) == nullptr) {
+      this->lastError = "Failed to resolve hostname " + this->params.host;
+      return false;
+    }
+    addr.sin_addr = *reinterpret_cast<struct in_addr *>(ent->h_addr);
+  }
+
+  if ((this->listenFd = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
+    this->lastError = "Failed to open socket: " + std::string(strerror(errno));
+    return false;
+  }
+
+  (void) setsockopt(
+        this->listenFd,
+        SOL_SOCKET,
+        SO_REUSEADDR,
+        &on,
+        sizeof(int));
+
+  if (bind(
+        this->listenFd,
+        reinterpret_cast<struct sockaddr *>(&addr),
+        sizeof(struct sockaddr_in)) == -1) {
+    this->lastError = "Cannot bind to port: " + std::string(strerror(errno));
+    this->close();
+    return false;
+  }
+
+  if (listen(this->listenFd, 16) == -1
+      || !setNonBlocking(this->listenFd)) {
+    this->lastError = "Cannot listen: " + std::string(strerror(errno));
+    this->close();
+    return false;
+  }
+
+  if (pipe(this->wakeFds) == -1) {
+    this->lastError = "Cannot create pipe: " + std::string(strerror(errno));
+    this->close();
+    return false;
+  }
+
+  (void) setNonBlocking(this->wakeFds[0]);
+  (void) setNonBlocking(this->wakeFds[1]);
+
+  this->running = true;
+  this->thread.start();
+
+  return true;
+}
+
+std::string
+SocketServerWriter::getError(void) const
+{
+  return this->lastError;
+}
+
+bool
+SocketServerWriter::canWrite(void) const
+{
+  return !this->prepared || this->listenFd != -1;
+}
+
+void
+SocketServerWriter::wake(void)
+{
+  char c = 0;
+
+  // If the pipe is full, the loop is already awake.
+  (void) ::write(this->wakeFds[1], &c, 1);
+}
+
+void
+SocketServerWriter::acceptClients(void)
+{
+  int fd;
+  int on = 1;
+
+  while ((fd = accept(this->listenFd, nullptr, nullptr)) != -1) {
+    std::unique_ptr<ServerClient> client(new ServerClient);
+
+    if (!setNonBlocking(fd)) {
+      ::close(fd);
+      continue;
+    }
+
+    (void) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(int));
+#ifdef SO_NOSIGPIPE
+    (void) setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(int));
+#endif // SO_NOSIGPIPE
+
+    client->fd = fd;
+
+    QMutexLocker locker(&this->mutex);
+    this->clients.push_back(std::move(client));
+  }
+}
+
+// Protected by mutex
+void
+SocketServerWriter::flushClient(ServerClient *client)
+{
+  struct iovec iov[SIGDIGGER_UDPFORWARDER_BATCH_SIZE];
+  struct msghdr msg;
+  size_t offset = client->offset;
+  size_t blockSize;
+  unsigned int n = 0;
+  ssize_t sent;
+
+  for (auto &block : client->queue) {
+    if (n == SIGDIGGER_UDPFORWARDER_BATCH_SIZE)
+      break;
+
+    iov[n].iov_base =
+        reinterpret_cast<char *>(const_cast<SUCOMPLEX *>(block->data()))
+        + offset;
+    iov[n].iov_len  = block->size() * sizeof(SUCOMPLEX) - offset;
+    offset = 0;
+    ++n;
+  }
+
+  if (n == 0)
+    return;
+
+  // Same as writev(), but without raising SIGPIPE
+  memset(&msg, 0, sizeof(struct msghdr));
+  msg.msg_iov    = iov;
+  msg.msg_iovlen = n;
+
+  if ((sent = sendmsg(client->fd, &msg, MSG_NOSIGNAL)) == -1) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      client->closing = true;
+    return;
+  }
+
+  client->queued -= static_cast<size_t>(sent);
+  sent += static_cast<ssize_t>(client->offset);
+
+  while (!client->queue.empty()) {
+    blockSize = client->queue.front()->size() * sizeof(SUCOMPLEX);
+    if (static_cast<size_t>(sent) < blockSize)
+      break;
+    sent -= static_cast<ssize_t>(blockSize);
+    client->queue.pop_front();
+  }
+
+  client->offset = static_cast<size_t>(sent);
+}
+
+void
+SocketServerWriter::loop(void)
+{
+  std::vector<struct pollfd> fds;
+  char discard[256];
+  size_t i;
+  ssize_t got;
+
+  while (this->running) {
+    fds.resize(2);
+
+    fds[0].fd = this->wakeFds[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = this->listenFd;
+    fds[1].events = POLLIN;
+
+    {
+      QMutexLocker locker(&this->mutex);
+
+      for (auto &client : this->clients) {
+        struct pollfd pfd;
+
+        pfd.fd = client->fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        if (client->queued > 0)
+          pfd.events |= POLLOUT;
+
+        fds.push_back(pfd);
+      }
+    }
+
+    if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    if (fds[0].revents & POLLIN)
+      while (read(this->wakeFds[0], discard, sizeof(discard)) > 0);
+
+    if (fds[1].revents & POLLIN)
+      this->acceptClients();
+
+    QMutexLocker locker(&this->mutex);
+
+    for (i = 2; i < fds.size(); ++i) {
+      ServerClient *client = this->clients[i - 2].get();
+
+      if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+        client->closing = true;
+
+      // Clients are not expected to talk. Just detect disconnections.
+      if (!client->closing && (fds[i].revents & POLLIN)) {
+        got = recv(client->fd, discard, sizeof(discard), 0);
+        if (got == 0 || (got == -1 && errno != EAGAIN && errno != EINTR))
+          client->closing = true;
+      }
+
+      if (!client->closing && (fds[i].revents & POLLOUT))
+        this->flushClient(client);
+    }
+
+    // Clients accepted during this iteration were not polled. Keep them.
+    for (i = 0; i < this->clients.size();) {
+      if (this->clients[i]->closing) {
+        ::close(this->clients[i]->fd);
+        this->clients.erase(this->clients.begin() + static_cast<long>(i));
+      } else {
+        ++i;
+      }
+    }
+  }
+}
+
+ssize_t
+SocketServerWriter::write(const SUCOMPLEX *data, size_t len)
+{
+  size_t bytes = len * sizeof(SUCOMPLEX);
+  SampleBlock block;
+
+  if (this->listenFd == -1)
+    return 0;
+
+  {
+    QMutexLocker locker(&this->mutex);
+
+    // All clients share the same copy of the data.
+    for (auto &client : this->clients) {
+      if (client->closing)
+        continue;
+
+      if (client->queued + bytes > this->params.clientQueueSize) {
+        if (this->params.slowClientPolicy == FORWARDER_SLOW_CLIENT_DISCONNECT)
+          client->closing = true;
+
+        client->dropped += bytes;
+        this->dropped += bytes;
+        continue;
+      }
+
+      if (!block)
+        block = std::make_shared<const std::vector<SUCOMPLEX>>(
+              data,
+              data + len);
+
+      client->queue.push_back(block);
+      client->queued += bytes;
+    }
+  }
+
+  this->wake();
+
+  // Never blocks: slow clients do not stall the data worker.
+  return static_cast<ssize_t>(len);
+}
+
+quint64
+SocketServerWriter::getDropped(void) const
+{
+  QMutexLocker locker(&this->mutex);
+
+  return this->dropped;
+}
+
+bool
+SocketServerWriter::close(void)
+{
+  if (this->running) {
+    this->running = false;
+    this->wake();
+    this->thread.wait();
+  }
+
+  for (auto &client : this->clients)
+    ::close(client->fd);
+
+  this->clients.clear();
+
+  if (this->listenFd != -1) {
+    ::close(this->listenFd);
+    this->listenFd = -1;
+  }
+
+  if (this->wakeFds[0] != -1) {
+    ::close(this->wakeFds[0]);
+    ::close(this->wakeFds[1]);
+    this->wakeFds[0] = this->wakeFds[1] = -1;
+  }
+
+  return true;
+}
+
+SocketServerWriter::~SocketServerWriter(void)
+{
+  this->close();
+}
+
+///////////////////////////// SocketForwarder //////////////////////////////////
 SocketForwarder::SocketForwarder(
-    std::string const &host,
-    uint16_t port,
-    unsigned int size,
-    bool tcp,
+    ForwarderParams const &params,
     QObject *parent) :
   GenericDataSaver(
-    this->writer = new SocketDataWriter(host, port, size, tcp),
+    this->writer = params.server
+      ? static_cast<GenericDataWriter *>(new SocketServerWriter(params))
+      : static_cast<GenericDataWriter *>(new SocketDataWriter(params)),
     parent)
 {
 
@@ -78,6 +78,12 @@ UIMediator::connectSourcePanel(void)
         SIGNAL(ppmChanged(void)),
         this,
         SLOT(onPPMChanged(void)));
+
+  connect(
+        this->ui->sourcePanel,
+        SIGNAL(preRollChanged(void)),
+        this,
+        SLOT(onPreRollChanged(void)));
 }
 
 void
@@ -86,6 +92,12 @@ UIMediator::onToggleRecord(void)
   emit toggleRecord();
 }
 
+void
+UIMediator::onPreRollChanged(void)
+{
+  emit preRollChanged();
+}
+
 void
 UIMediator::onThrottleConfigChanged(void)
 {
@@ -268,6 +268,18 @@ UIMediator::connectMainWindow(void)
         this,
         SLOT(onTriggerBackgroundTasks(void)));
 
+  connect(
+        this->ui->main->actionRecordings,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onTriggerRecordings(void)));
+
+  connect(
+        this->ui->main->actionCaptureOverview,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onTriggerCaptureOverview(void)));
+
   connect(
         this->ui->main->actionAddBookmark,
         SIGNAL(triggered(bool)),
@@ -413,6 +425,12 @@ UIMediator::setAudioRecordIORate(qreal rate)
   this->ui->audioPanel->setIORate(rate);
 }
 
+void
+UIMediator::setAudioRecordStats(DataSaverStats const &stats)
+{
+  this->ui->audioPanel->setStats(stats);
+}
+
 void
 UIMediator::setState(State state)
 {
@@ -453,12 +471,6 @@ UIMediator::resetRawInspector(qreal fs)
   this->ui->inspectorPanel->resetRawInspector(fs);
 }
 
-void
-UIMediator::feedRawInspector(const SUCOMPLEX *data, size_t size)
-{
-  this->ui->inspectorPanel->feedRawInspector(data, size);
-}
-
 
 void
 UIMediator::setMinPanSpectrumBw(quint64 bw)
@@ -560,6 +572,12 @@ UIMediator::setCaptureSize(quint64 size)
   this->ui->sourcePanel->setCaptureSize(size);
 }
 
+void
+UIMediator::setCaptureStats(DataSaverStats const &stats)
+{
+  this->ui->sourcePanel->setCaptureStats(stats);
+}
+
 Inspector *
 UIMediator::lookupInspector(Suscan::InspectorId handle) const
 {
@@ -1162,6 +1180,18 @@ UIMediator::onTriggerBackgroundTasks(void)
   this->ui->backgroundTasksDialog->show();
 }
 
+void
+UIMediator::onTriggerRecordings(void)
+{
+  this->ui->recordingsDialog->show();
+}
+
+void
+UIMediator::onTriggerCaptureOverview(void)
+{
+  this->ui->captureOverviewDialog->show();
+}
+
 void
 UIMediator::onAddBookmark(void)
 {
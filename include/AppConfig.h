@@ -37,6 +37,10 @@
 #define SIGDIGGER_AUDIO_INSPECTOR_BANDWIDTH   200000
 #define SIGDIGGER_AUDIO_INSPECTOR_REQID       0xaaaaaaaa
 
+// Second channel of audio recordings, only open while recording
+#define SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_MAGIC_ID 0xa01d1100
+#define SIGDIGGER_AUDIO_CHANNEL_INSPECTOR_REQID    0xaaaaaaab
+
 #define SIGDIGGER_RAW_INSPECTOR_MAGIC_ID      0xe0e0e0e0
 #define SIGDIGGER_RAW_INSPECTOR_REQID         0xeeeeeeee
 
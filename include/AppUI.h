@@ -37,6 +37,8 @@
 #include "PanoramicDialog.h"
 #include "LogDialog.h"
 #include "BackgroundTasksDialog.h"
+#include "RecordingsDialog.h"
+#include "CaptureOverviewDialog.h"
 #include "AddBookmarkDialog.h"
 #include "BookmarkManagerDialog.h"
 
@@ -55,6 +57,8 @@ namespace SigDigger {
     DataSaverUI *dataSaverUI = nullptr;
     LogDialog *logDialog = nullptr;
     BackgroundTasksDialog *backgroundTasksDialog = nullptr;
+    RecordingsDialog *recordingsDialog = nullptr;
+    CaptureOverviewDialog *captureOverviewDialog = nullptr;
     AddBookmarkDialog *addBookmarkDialog = nullptr;
     BookmarkManagerDialog *bookmarkManagerDialog = nullptr;
 
@@ -28,6 +28,9 @@
 #include "UIMediator.h"
 #include "AudioPlayback.h"
 #include "FileDataSaver.h"
+#include "PreRollBuffer.h"
+#include "SubbandExtractor.h"
+#include "SampleBus.h"
 #include "AudioFileSaver.h"
 #include "Scanner.h"
 #include <BookmarkInfo.h>
@@ -51,13 +54,17 @@ namespace SigDigger {
   };
 
 
-  class Application : public QMainWindow {
+  class Application : public QMainWindow, public SampleConsumer {
     Q_OBJECT
 
     // Suscan core object
     std::unique_ptr<Suscan::Analyzer> analyzer = nullptr;
     std::unique_ptr<FileDataSaver> dataSaver = nullptr;
     std::unique_ptr<AudioFileSaver> audioFileSaver = nullptr;
+    PreRollBuffer preRoll;
+    SubbandExtractor subband;
+    SubbandDDC::Params subbandParams;
+    bool recordSubband = false;
 
     bool profileSelected = false;
     unsigned int currSampleRate;
@@ -77,6 +84,11 @@ namespace SigDigger {
     SUFREQ maxAudioBw = SIGDIGGER_AUDIO_INSPECTOR_BANDWIDTH;
     SUFREQ lastAudioLo = 0;
 
+    // Second audio channel of recordings
+    Suscan::Handle audioChanInspHandle = 0;
+    bool audioChanInspectorOpened = false;
+    SUFREQ lastAudioChanLo = 0;
+
     // Raw inspector for time view
     Suscan::Handle rawInspHandle = 0;
     bool rawInspectorOpened = false;
@@ -106,9 +118,16 @@ namespace SigDigger {
     void connectDeviceDetect(void);
     void connectScanner(void);
 
+    unsigned int getRecordSampleRate(void) const;
+    SUFREQ getRecordFrequency(void) const;
+    std::string captureFilePrefix(void) const;
     int  openCaptureFile(void);
+    bool openDataSaver(void);
+    void attachDataSaver(void);
     void installDataSaver(int fd);
+    void installDataSaver(FileDataSaver::SegmentParams const &);
     void uninstallDataSaver(void);
+    void installPreRoll(void);
     bool openAudioFileSaver(void);
     void closeAudioFileSaver(void);
     void orderedHalt(void);
@@ -118,9 +137,13 @@ namespace SigDigger {
         unsigned int demod,
         bool squelch,
         SUFLOAT squelchLevel);
+    SUFREQ getAudioSidebandOffset(void) const;
     SUFREQ getAudioInspectorLo(void) const;
     SUFREQ getAudioInspectorBandwidth(void) const;
     void   assertAudioInspectorLo(void);
+    SUFREQ getAudioChannelLo(void) const;
+    bool   openAudioChannelInspector(void);
+    void   closeAudioChannelInspector(void);
 
   public:
     // Application methods
@@ -137,6 +160,11 @@ namespace SigDigger {
     void closeAudio(void);
 
     FileDataSaver *getSaver(void) const;
+    PreRollBuffer *getPreRoll(void);
+    SubbandExtractor *getSubband(void);
+
+    // Audio inspector samples, from the sample bus
+    void consume(SampleBuffer const &buffer) override;
 
     explicit Application(QWidget *parent = nullptr);
     ~Application();
@@ -160,6 +188,7 @@ namespace SigDigger {
     void onCloseRawInspector(void);
     void onThrottleConfigChanged(void);
     void onToggleRecord(void);
+    void onPreRollChanged(void);
     void onToggleDCRemove(void);
     void onToggleIQReverse(void);
     void onToggleAGCEnabled(void);
@@ -20,7 +20,10 @@
 #define AUDIOFILESAVER_H
 
 #include <GenericDataSaver.h>
+#include <SampleBus.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace SigDigger {
   class AudioFileWriter;
@@ -32,23 +35,73 @@ namespace SigDigger {
     LSB
   };
 
+  enum AudioFileFormat {
+    AUDIO_FILE_FORMAT_WAV,
+    AUDIO_FILE_FORMAT_FLAC,
+    AUDIO_FILE_FORMAT_OGG
+  };
+
+  class AudioFileSaver;
+
+  // Feeds the samples of an inspector to one channel of an audio file
+  class AudioChannelFeeder : public SampleConsumer {
+    AudioFileSaver *saver;
+    unsigned int channel;
+
+  public:
+    AudioChannelFeeder(AudioFileSaver *saver, unsigned int channel);
+
+    void consume(SampleBuffer const &buffer) override;
+  };
+
   class AudioFileSaver : public GenericDataSaver {
     Q_OBJECT
 
     AudioFileWriter *writer = nullptr;
 
+    // Samples of each channel not yet written as whole frames
+    std::vector<std::vector<SUFLOAT>> staging;
+    std::vector<bool> started;
+    std::vector<SUCOMPLEX> frames;
+
+    std::vector<std::unique_ptr<AudioChannelFeeder>> feeders;
+
   public:
     struct AudioFileParams {
       std::string savePath;
       AudioDemod modulation;
       SUFREQ frequency;
       unsigned int sampRate;
+      AudioFileFormat format = AUDIO_FILE_FORMAT_WAV;
+
+      // Frequencies of the channels after the first one, if any
+      std::vector<SUFREQ> extraFrequencies;
     };
 
     AudioFileParams params;
 
     AudioFileSaver(AudioFileParams const &, QObject *);
     ~AudioFileSaver();
+
+    unsigned int getChannelCount(void) const;
+
+    // Bytes on disk. Compressed formats have no fixed size per sample.
+    quint64 getFileSize(void) const;
+
+    //
+    // Multi-channel files are fed one channel at a time. Nothing is
+    // written until every channel has delivered samples, so that they
+    // start together (to within one inspector batch). Frames are written
+    // as soon as every channel has delivered its sample. A channel that
+    // falls more than one second behind is padded with silence, so the
+    // others keep going if one of the sources stalls.
+    //
+    void writeChannel(unsigned int channel, const SUCOMPLEX *data, size_t len);
+
+    // Subscribes a channel to the samples of an inspector
+    void feedChannelFrom(unsigned int channel, Suscan::InspectorId id);
+
+    static std::string formatExtension(AudioFileFormat format);
   };
 }
 
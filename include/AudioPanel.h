@@ -33,6 +33,7 @@ namespace SigDigger {
     bool enabled = false;
     std::string demod;
     std::string savePath;
+    std::string format = "wav";
     unsigned int rate = 44100;
     SUFLOAT cutOff = 15000;
     SUFLOAT volume = -6;
@@ -41,6 +42,10 @@ namespace SigDigger {
     SUFLOAT amSquelch = .1f;
     SUFLOAT ssbSquelch = 1e-3f;
 
+    // Second channel of recordings
+    bool channel = false;
+    SUFREQ channelFreq = 0;
+
     // Overriden methods
     void deserialize(Suscan::Object const &conf) override;
     Suscan::Object &&serialize(void) override;
@@ -67,6 +72,7 @@ namespace SigDigger {
   public:
     static AudioDemod strToDemod(std::string const &str);
     static std::string demodToStr(AudioDemod);
+    static AudioFileFormat strToFormat(std::string const &str);
 
     explicit AudioPanel(QWidget *parent = nullptr);
     ~AudioPanel() override;
@@ -82,12 +88,16 @@ namespace SigDigger {
 
     void setSquelchEnabled(bool);
     void setSquelchLevel(SUFLOAT);
+    void setRecordFormat(AudioFileFormat);
+    void setRecordChannelEnabled(bool);
+    void setRecordChannelFrequency(SUFREQ);
 
     // Overriden setters
     void setRecordSavePath(std::string const &) override;
     void setSaveEnabled(bool enabled) override;
     void setCaptureSize(quint64) override;
     void setIORate(qreal) override;
+    void setStats(DataSaverStats const &stats) override;
     void setRecordState(bool state) override;
 
     // Getters
@@ -102,6 +112,9 @@ namespace SigDigger {
 
     bool getSquelchEnabled(void) const;
     SUFLOAT getSquelchLevel(void) const;
+    AudioFileFormat getRecordFormat(void) const;
+    bool getRecordChannelEnabled(void) const;
+    SUFREQ getRecordChannelFrequency(void) const;
 
     // Overriden getters
     bool getRecordState(void) const override;
@@ -123,6 +136,8 @@ namespace SigDigger {
     void onRecordStartStop(void);
     void onToggleSquelch(void);
     void onSquelchLevelChanged(void);
+    void onFormatChanged(void);
+    void onChannelChanged(void);
 
   signals:
     void changed(void);
@@ -55,6 +55,7 @@ namespace SigDigger {
       QSortFilterProxyModel *proxy = nullptr;
       int prevRows = 0;
       void connectAll(void);
+      void refreshSummary(void);
 
     public:
       explicit BackgroundTasksDialog(QWidget *parent = nullptr);
@@ -70,6 +71,8 @@ namespace SigDigger {
       void onCancelAll(void);
       void onLayoutChanged(void);
       void onCancelClicked(QModelIndex);
+      void onHistoryChanged(void);
+      void onExportHistory(void);
       void onError(QString title, QString err);
   };
 }
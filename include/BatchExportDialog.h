@@ -0,0 +1,80 @@
+//
+//    BatchExportDialog.h: Export many selections at once
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef BATCHEXPORTDIALOG_H
+#define BATCHEXPORTDIALOG_H
+
+#include <QDialog>
+#include <BatchExportTask.h>
+#include <vector>
+
+namespace Ui {
+  class BatchExportDialog;
+}
+
+namespace SigDigger {
+  class BatchExportDialog : public QDialog
+  {
+      Q_OBJECT
+
+      std::vector<std::pair<int, int>> selections; // [start, end)
+      qreal fs = 1;
+
+      void connectAll(void);
+      void refreshUi(void);
+      QString getFileName(size_t index) const;
+      QString getExtension(void) const;
+
+    public:
+      explicit BatchExportDialog(QWidget *parent = nullptr);
+      ~BatchExportDialog() override;
+
+      void setSampleRate(qreal fs);
+      void addSelection(int start, int end);
+      void clear(void);
+      size_t getSelectionCount(void) const;
+
+      QString getFormat(void) const;
+      std::vector<BatchExportItem> makeItems(void) const;
+
+      // %n: 1-based number, %s: first sample, %t: start time, %%: %
+      static QString expandPattern(
+          QString const &pattern,
+          size_t index,
+          size_t count,
+          int start,
+          qreal fs);
+
+    private:
+      Ui::BatchExportDialog *ui;
+
+    signals:
+      void selectionsChanged(void);
+      void exportRequested(void);
+
+    public slots:
+      void onRemove(void);
+      void onClear(void);
+      void onBrowse(void);
+      void onPatternChanged(void);
+      void onAccept(void);
+  };
+}
+
+#endif // BATCHEXPORTDIALOG_H
@@ -0,0 +1,81 @@
+//
+//    BatchExportTask.h: Export many selections at once
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef BATCHEXPORTTASK_H
+#define BATCHEXPORTTASK_H
+
+#include <Suscan/CancellableTask.h>
+#include <QMutex>
+#include <SampleBus.h>
+#include <atomic>
+#include <vector>
+
+namespace SigDigger {
+  class ExportSamplesTask;
+
+  struct BatchExportItem {
+    QString path;
+    int start;
+    int end;
+  };
+
+  //
+  // Saves each item to its own file, one after another, with a
+  // ExportSamplesTask. Like any other disk task, it takes a single disk
+  // slot of the task controller.
+  //
+  class BatchExportTask : public Suscan::CancellableTask
+  {
+      Q_OBJECT
+
+      SampleBuffer data;
+      qreal fs;
+      QString format;
+      std::vector<BatchExportItem> items;
+
+      size_t current = 0;
+      size_t failed = 0;
+      quint64 currentSize = 0;
+      quint64 samplesDone = 0;
+      quint64 samplesTotal = 0;
+      std::atomic<bool> cancelFlag;
+
+      QMutex mutex;
+      ExportSamplesTask *running = nullptr;
+      QString firstError;
+
+      void exportItem(BatchExportItem const &item);
+
+    public:
+      BatchExportTask(
+          SampleBuffer const &data,
+          qreal fs,
+          QString const &format,
+          std::vector<BatchExportItem> const &items);
+      ~BatchExportTask() override;
+
+      bool work(void) override;
+      void cancel(void) override;
+
+    public slots:
+      void onItemProgress(qreal, QString);
+  };
+}
+
+#endif // BATCHEXPORTTASK_H
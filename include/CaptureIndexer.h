@@ -0,0 +1,108 @@
+//
+//    CaptureIndexer.h: Build a low resolution overview of a capture file
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef CAPTUREINDEXER_H
+#define CAPTUREINDEXER_H
+
+#include <Suscan/CancellableTask.h>
+#include <QElapsedTimer>
+#include <sigutils/types.h>
+#include <vector>
+#include <string>
+#include <atomic>
+
+#define SIGDIGGER_OVERVIEW_MAGIC        0x564f4453 // "SDOV"
+#define SIGDIGGER_OVERVIEW_VERSION      1
+#define SIGDIGGER_OVERVIEW_SUFFIX       ".overview"
+
+// Time slices (rows) and frequency bins of the overview spectrogram
+#define SIGDIGGER_OVERVIEW_ROWS         1024
+#define SIGDIGGER_OVERVIEW_BINS         512
+
+// Averaged FFTs per row, and power envelope points per row
+#define SIGDIGGER_OVERVIEW_FFTS_PER_ROW 16
+#define SIGDIGGER_OVERVIEW_ENV_PER_ROW  8
+
+namespace SigDigger {
+  //
+  // The overview of a complex float32 capture file, as saved next to it.
+  // Rows are consecutive time slices of the file, each one of them
+  // holding a DC-centered spectrum and a few envelope points, in dB.
+  //
+  struct CaptureOverview {
+    quint64 fileSize = 0;
+    qint64  mtime = 0;
+    quint64 samples = 0;
+    unsigned int rows = 0;
+    unsigned int bins = 0;
+    unsigned int envPerRow = 0;
+
+    std::vector<SUFLOAT> spectrogram; // rows x bins
+    std::vector<SUFLOAT> envelope;    // rows x envPerRow
+
+    static std::string sidecarPath(std::string const &capture);
+
+    // Fails if the sidecar is missing, corrupt or older than the capture
+    bool load(std::string const &capture);
+    bool save(std::string const &capture) const;
+
+    quint64
+    rowToSample(unsigned int row) const
+    {
+      return this->samples * row / this->rows;
+    }
+  };
+
+  class CaptureIndexer : public Suscan::CancellableTask
+  {
+      Q_OBJECT
+
+      std::string path;
+      int fd = -1;
+      const SUCOMPLEX *map = nullptr;
+      size_t mapSize = 0;
+      unsigned int threads = 1;
+
+      SU_FFTW(_plan) plan = nullptr;
+      std::vector<SU_FFTW(_complex) *> buffers;
+
+      CaptureOverview overview;
+      QElapsedTimer timer;
+      std::atomic<bool> cancelFlag;
+
+      bool open(void);
+      void indexRows(unsigned int first, unsigned int count, unsigned int n);
+      void breathe(unsigned int row);
+
+    public:
+      CaptureIndexer(std::string const &path, QObject *parent = nullptr);
+      ~CaptureIndexer() override;
+
+      bool work(void) override;
+      void cancel(void) override;
+
+      CaptureOverview const &
+      getOverview(void) const
+      {
+        return this->overview;
+      }
+  };
+}
+
+#endif // CAPTUREINDEXER_H
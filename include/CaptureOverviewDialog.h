@@ -0,0 +1,71 @@
+//
+//    CaptureOverviewDialog.h: Browse huge capture files
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef CAPTUREOVERVIEWDIALOG_H
+#define CAPTUREOVERVIEWDIALOG_H
+
+#include <QDialog>
+#include <sigutils/types.h>
+
+// Largest region that is loaded into the sample viewer at once (128 MiB)
+#define SIGDIGGER_CAPTURE_OVERVIEW_MAX_REGION (1 << 24)
+
+namespace Ui {
+  class CaptureOverviewDialog;
+}
+
+namespace SigDigger {
+  class CaptureOverviewView;
+  class TimeWindow;
+
+  class CaptureOverviewDialog : public QDialog
+  {
+      Q_OBJECT
+
+      CaptureOverviewView *view = nullptr;
+      TimeWindow *timeWindow = nullptr;
+      std::string path;
+      std::string indexing;
+      quint64 samples = 0;
+
+      void connectAll(void);
+      void parseFileName(void);
+      void refreshUi(void);
+      bool loadRegion(quint64 start, quint64 len);
+
+    public:
+      explicit CaptureOverviewDialog(QWidget *parent = nullptr);
+      ~CaptureOverviewDialog() override;
+
+      void openCapture(QString const &path);
+
+    private:
+      Ui::CaptureOverviewDialog *ui;
+
+    public slots:
+      void onOpenCapture(void);
+      void onIndexDone(void);
+      void onIndexError(QString);
+      void onIndexCancelled(void);
+      void onSelectionChanged(qreal, qreal);
+      void onOpenRegion(void);
+  };
+}
+
+#endif // CAPTUREOVERVIEWDIALOG_H
@@ -0,0 +1,76 @@
+//
+//    CaptureOverviewView.h: Spectrogram and envelope of a capture file
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef CAPTUREOVERVIEWVIEW_H
+#define CAPTUREOVERVIEWVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <CaptureIndexer.h>
+
+#define SIGDIGGER_CAPTURE_OVERVIEW_ENVELOPE_HEIGHT 64
+
+namespace SigDigger {
+  //
+  // Time runs from left to right. The spectrogram sits on top (positive
+  // frequencies up) and the power envelope below it. Dragging the mouse
+  // selects a time span of the capture.
+  //
+  class CaptureOverviewView : public QWidget
+  {
+      Q_OBJECT
+
+      CaptureOverview overview;
+      QImage image;
+      SUFLOAT envMin = 0;
+      SUFLOAT envMax = 0;
+
+      bool selecting = false;
+      qreal selStart = 0;
+      qreal selEnd = 0;
+
+      void renderImage(void);
+      qreal xToTime(int x) const;
+      int timeToX(qreal t) const;
+
+    protected:
+      void paintEvent(QPaintEvent *event) override;
+      void mousePressEvent(QMouseEvent *event) override;
+      void mouseMoveEvent(QMouseEvent *event) override;
+      void mouseReleaseEvent(QMouseEvent *event) override;
+      void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+    public:
+      explicit CaptureOverviewView(QWidget *parent = nullptr);
+
+      void setOverview(CaptureOverview const &overview);
+      void clear(void);
+      bool hasOverview(void) const;
+
+      // Selection bounds, as fractions of the capture length
+      qreal getSelectionStart(void) const;
+      qreal getSelectionEnd(void) const;
+
+    signals:
+      void selectionChanged(qreal, qreal);
+      void regionActivated(qreal, qreal);
+  };
+}
+
+#endif // CAPTUREOVERVIEWVIEW_H
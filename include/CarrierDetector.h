@@ -21,56 +21,84 @@
 
 #include <Suscan/CancellableTask.h>
 #include <sigutils/types.h>
+#include <sigutils/ncqo.h>
+#include <FftService.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Longer captures are estimated with Welch's method instead of one FFT
+#define SIGDIGGER_CARRIER_DETECTOR_MAX_FFT_SIZE   (1 << 22)
+
+// Length of Welch segments. They overlap by half.
+#define SIGDIGGER_CARRIER_DETECTOR_WELCH_SIZE     (1 << 16)
+
+// Welch segments transformed in every call to work()
+#define SIGDIGGER_CARRIER_DETECTOR_WELCH_BLOCK    64
+
+// Upper bound of the decimated capture used to refine the peak
+#define SIGDIGGER_CARRIER_DETECTOR_ZOOM_SIZE      (1 << 20)
+
+// Decimated samples computed in every call to work()
+#define SIGDIGGER_CARRIER_DETECTOR_ZOOM_BLOCK     (1 << 14)
 
 namespace SigDigger {
+  //
+  // Finds the dominant frequency of a capture. Short captures get a single
+  // zero-padded FFT. Long ones get a Welch periodogram, computed in
+  // parallel with bounded memory, and the peak is then refined with a
+  // zoom FFT: the capture is moved to the coarse peak, decimated and
+  // transformed again, which gives back the resolution of the full FFT.
+  //
   class CarrierDetector : public Suscan::CancellableTask {
     Q_OBJECT
 
     enum State {
       ESTIMATING,
       COPYING,
+      AVERAGING,
+      DECIMATING,
       EXECUTING,
       COMPUTING
     };
 
     State state             = ESTIMATING;
     const SUCOMPLEX   *data = nullptr;
-    SU_FFTW(_plan)     plan = nullptr;
-    SU_FFTW(_complex) *buffer = nullptr;
+    FftBuffer fft;
     SUFLOAT peak = 0;
     size_t len;
     size_t allocation = 1;
     qreal avgRelBw;
     qreal dcNotchRelBw;
+
+    // Welch's method
+    bool welch = false;
+    std::vector<SUFLOAT> window;
+    std::vector<SUFLOAT> psd;
+    std::mutex psdMutex;
+    std::atomic<bool> allocFailed;
+    size_t segments = 0;
+    size_t segmentsDone = 0;
+
+    // Zoom FFT
+    SUFLOAT coarse = 0;
+    su_ncqo_t ncqo;
+    size_t decimation = 1;
+    size_t zoomLen = 0;
+    size_t zoomDone = 0;
+
+    void averageSegments(size_t first, size_t count);
+    void decimate(size_t first, size_t count);
+    bool startRefinement(void);
+    void refinePeak(void);
+
     State
     getState(void) const
     {
       return this->state;
     }
 
-    void
-    transitionTo(State s)
-    {
-      this->state = s;
-      this->setProgress(static_cast<qreal>(s) / 3);
-
-      switch (s) {
-        case ESTIMATING:
-          this->setStatus("Estimating best FFT plan");
-          break;
-
-        case COPYING:
-          this->setStatus("Copying I/Q data to FFT buffer");
-          break;
-
-        case EXECUTING:
-          this->setStatus("Executing FFT");
-          break;
-
-        case COMPUTING:
-          this->setStatus("Computing dominant frequency");
-      }
-    }
+    void transitionTo(State s);
 
   public:
     CarrierDetector(
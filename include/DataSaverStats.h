@@ -0,0 +1,77 @@
+//
+//    DataSaverStats.h: Writer path instrumentation
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef DATASAVERSTATS_H
+#define DATASAVERSTATS_H
+
+#include <QString>
+#include <string>
+
+// Power-of-two latency bins: [0, 1) us, [1, 2) us, ..., [2^30, inf) us
+#define SIGDIGGER_DATASAVER_LATENCY_BINS 32
+
+namespace SigDigger {
+  //
+  // Everything we know about the way a data saver is writing: how long
+  // each commit takes to reach the writer, how fast data flows, how full
+  // the double buffer gets and how much data was lost on the way. Times
+  // are in microseconds, sizes in bytes.
+  //
+  struct DataSaverStats {
+    quint64 commits = 0;
+    quint64 bytes = 0;
+    quint64 elapsed = 0;      // From the first to the last commit
+    quint64 writeTime = 0;    // Total time spent in writer calls
+    quint64 maxLatency = 0;
+    quint64 latency[SIGDIGGER_DATASAVER_LATENCY_BINS] = {};
+
+    qreal occupancy = 0;      // Buffer usage at the last commit, 0 to 1
+    qreal peakOccupancy = 0;
+
+    quint64 swamps = 0;       // Times the buffer was full
+    quint64 dropped = 0;      // Bytes lost because of swamps or the writer
+
+    quint64 syncs = 0;
+    quint64 syncTime = 0;
+    quint64 maxSyncTime = 0;
+    quint64 syncErrors = 0;   // Failed syncs. They stop the recording.
+
+    void reset(void);
+    void addLatency(quint64 usec);
+    void addSync(quint64 usec);
+    void addSyncError(void);
+    void addOccupancy(qreal occupancy);
+
+    // Accumulate the stats of another saver running at the same time
+    void merge(DataSaverStats const &other);
+
+    qreal bytesPerSecond(void) const;
+    qreal meanLatency(void) const;
+    quint64 latencyPercentile(qreal p) const;
+
+    QString summary(void) const;
+    std::string toCsv(void) const;
+    std::string toJson(void) const;
+
+    // JSON if the file name ends in .json, CSV otherwise
+    bool saveToFile(std::string const &path) const;
+  };
+}
+
+#endif // DATASAVERSTATS_H
@@ -21,6 +21,7 @@
 #define DATASAVERUI_H
 
 #include <GenericDataSaverUI.h>
+#include <SampleConversion.h>
 
 namespace Ui {
   class DataSaverUI;
@@ -30,6 +31,13 @@ namespace SigDigger {
   class DataSaverConfig : public Suscan::Serializable {
   public:
     std::string path;
+    unsigned int splitSize = 0; // MiB
+    unsigned int splitTime = 0; // Seconds
+    unsigned int quota = 0;     // MiB
+    unsigned int preRoll = 0;   // Seconds
+    unsigned int sync = 0;      // Seconds between syncs, 0 is never
+    std::string format = "complex";
+    bool subband = false;
 
     // Overriden methods
     void deserialize(Suscan::Object const &conf) override;
@@ -42,6 +50,9 @@ namespace SigDigger {
     DataSaverConfig *config = nullptr;
       void connectAll(void);
 
+      static RealSampleFormat strToFormat(std::string const &str);
+      static std::string formatToStr(RealSampleFormat format);
+
   protected:
       void setDiskUsage(qreal) override;
 
@@ -52,10 +63,22 @@ namespace SigDigger {
       void setCaptureSize(quint64) override;
       void setIORate(qreal) override;
       void setRecordState(bool state) override;
+      void setStats(DataSaverStats const &stats) override;
+      void setPreRollVisible(bool visible);
+      void setFormatVisible(bool visible);
+      void setSubbandVisible(bool visible);
+      void setRealFormat(RealSampleFormat format);
 
       // Getters
       bool getRecordState(void) const override;
       std::string getRecordSavePath(void) const override;
+      quint64 getSegmentSize(void) const;
+      quint64 getSegmentDuration(void) const;
+      quint64 getQuota(void) const;
+      unsigned int getPreRoll(void) const;
+      unsigned int getSyncInterval(void) const;
+      RealSampleFormat getRealFormat(void) const;
+      bool getSubband(void) const;
 
       // Other overriden methods
       Suscan::Serializable *allocConfig(void) override;
@@ -67,6 +90,14 @@ namespace SigDigger {
   public slots:
       void onChangeSavePath(void);
       void onRecordStartStop(void);
+      void onSegmentationChanged(void);
+      void onPreRollChanged(void);
+      void onSyncChanged(void);
+      void onFormatChanged(void);
+      void onSubbandChanged(void);
+
+  signals:
+      void preRollChanged(void);
 
   private:
       Ui::DataSaverUI *ui;
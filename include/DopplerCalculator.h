@@ -21,6 +21,7 @@
 
 #include <Suscan/CancellableTask.h>
 #include <sigutils/types.h>
+#include <FftService.h>
 
 namespace SigDigger {
   class DopplerCalculator : public Suscan::CancellableTask {
@@ -35,8 +36,7 @@ namespace SigDigger {
 
     State state             = ESTIMATING;
     const SUCOMPLEX   *data = nullptr;
-    SU_FFTW(_plan)     plan = nullptr;
-    SU_FFTW(_complex) *buffer = nullptr;
+    FftBuffer fft;
     std::vector<SUCOMPLEX> psd;
     SUFLOAT peak = 0;
     SUFLOAT sigma;
@@ -39,10 +39,19 @@ namespace SigDigger {
     qreal sigmaV;
     qreal max = 1;
 
+    // Velocity over time
+    std::vector<SUFLOAT> trackVelocity;
+    std::vector<SUFLOAT> trackSigma;
+    std::vector<SUFLOAT> trackEnergy;
+    std::vector<SUCOMPLEX> trackData;
+    qreal trackRate = 1;
+    qreal trackOffset = 0;
+
     bool exportToMatlab(QString const &path);
 
     void connectAll(void);
     void zoomReset(void);
+    void refreshTrack(void);
 
   public:
     explicit DopplerDialog(QWidget *parent = nullptr);
@@ -54,6 +63,12 @@ namespace SigDigger {
     void setMax(qreal ax);
     void setVelocityStep(qreal fs);
     void giveSpectrum(std::vector<SUCOMPLEX> &&);
+    void giveTrack(
+        std::vector<SUFLOAT> const &velocity,
+        std::vector<SUFLOAT> const &sigma,
+        std::vector<SUFLOAT> const &energy,
+        qreal frameRate,
+        qreal timeOffset);
     void setColorConfig(ColorConfig const &);
 
     void showEvent(QShowEvent *);
@@ -61,6 +76,7 @@ namespace SigDigger {
   public slots:
     void onSave(void);
     void onZoomReset(void);
+    void onSmoothingChanged(void);
 
   private:
     Ui::DopplerDialog *ui;
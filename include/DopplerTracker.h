@@ -0,0 +1,104 @@
+//
+//    DopplerTracker.h: Doppler velocity over time
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef DOPPLERTRACKER_H
+#define DOPPLERTRACKER_H
+
+#include <Suscan/SplittableTask.h>
+#include <sigutils/types.h>
+#include <atomic>
+#include <vector>
+
+// Selections are cut in at least this many frames
+#define SIGDIGGER_DOPPLER_TRACKER_MIN_FRAMES 64
+
+// Bounds of the frame length (and FFT size). Frames overlap by half.
+#define SIGDIGGER_DOPPLER_TRACKER_MIN_FFT    256
+#define SIGDIGGER_DOPPLER_TRACKER_MAX_FFT    65536
+
+// Frames transformed in every call to work()
+#define SIGDIGGER_DOPPLER_TRACKER_BLOCK      256
+
+// Bins at each side of the peak of a frame used for centroid and dispersion
+#define SIGDIGGER_DOPPLER_TRACKER_PEAK_BINS  8
+
+// Frames transformed by a single thread, at least
+#define SIGDIGGER_DOPPLER_TRACKER_MIN_PIECE  4
+
+namespace SigDigger {
+  //
+  // Short-time version of DopplerCalculator: the selection is cut in
+  // overlapping frames, transformed in parallel, and every frame gives a
+  // dominant velocity and a velocity dispersion around it. Frames are short
+  // and noisy, so both come from the bins next to the peak of each frame.
+  //
+  class DopplerTracker : public Suscan::SplittableTask {
+    Q_OBJECT
+
+    const SUCOMPLEX *data = nullptr;
+    size_t len;
+    SUFLOAT fs;
+    SUFLOAT lambda;
+
+    size_t frameLen = SIGDIGGER_DOPPLER_TRACKER_MIN_FFT;
+    size_t windowLen;
+    size_t hop;
+    size_t frames = 1;
+    std::vector<SUFLOAT> window;
+
+    std::vector<SUFLOAT> rawVelocity;
+    std::vector<SUFLOAT> sigma;
+    std::vector<SUFLOAT> energy;
+    std::atomic<bool> allocFailed;
+
+  protected:
+    void processRange(size_t first, size_t len) override;
+    void blockDone(size_t first, size_t len) override;
+
+  public:
+    DopplerTracker(
+        SUFREQ f0,
+        const SUCOMPLEX *data,
+        size_t len,
+        SUFLOAT fs,
+        QObject *parent = nullptr);
+    virtual ~DopplerTracker() override;
+
+    virtual void cancel(void) override;
+
+    // Frames per second
+    qreal getFrameRate(void) const;
+
+    // Time of the center of the first frame, from the selection start
+    qreal getTimeOffset(void) const;
+
+    // m/s, one per frame. Callers smooth them with smooth() if needed.
+    std::vector<SUFLOAT> const &getRawVelocity(void) const;
+    std::vector<SUFLOAT> const &getSigma(void) const;
+    std::vector<SUFLOAT> const &getEnergy(void) const;
+
+    // Centered moving average of 2 * frames + 1 frames, weighted by the
+    // energy of each frame so that fades do not drag the curve around
+    static std::vector<SUFLOAT> smooth(
+        std::vector<SUFLOAT> const &values,
+        std::vector<SUFLOAT> const &weights,
+        unsigned int frames);
+  };
+}
+
+#endif // DOPPLERTRACKER_H
@@ -21,39 +21,64 @@
 
 #include <Suscan/CancellableTask.h>
 #include <QElapsedTimer>
-#include <sigutils/matfile.h>
-#include <iomanip>
-#include <fstream>
 #include "SigDiggerHelpers.h"
+#include "MatlabWriter.h"
+#include <functional>
+#include <atomic>
+#include <cstdio>
+
+// Samples handed to the file in one go, between progress updates
+#define SIGDIGGER_EXPORT_SAMPLES_BLOCK_SIZE 0x100000
 
 namespace SigDigger {
   class ExportSamplesTask : public Suscan::CancellableTask
   {
       Q_OBJECT
 
-      std::ofstream of;
+      MatlabWriter matlab;
       SNDFILE *sfp = nullptr;
-      su_mat_file_t *mf = nullptr;
+      FILE *mat5 = nullptr;
+
+      // Memory mapped formats: header, then samples
+      int fd = -1;
+      uint8_t *map = nullptr;
+      size_t mapSize = 0;
+      size_t mapHeaderSize = 0;
+      size_t mapSampleSize = 0;
 
       QElapsedTimer timer;
       QString path;
       QString format;
-      std::vector<SUCOMPLEX> data;
+      SampleBuffer data;
       qreal fs;
       int start;
       int end;
+      quint64 written = 0;
 
       QString lastError;
 
+      // Writes len samples, returns false on error
+      typedef std::function<bool (const SUCOMPLEX *, size_t)> BlockWriter;
+
+      bool writeMat5Header(quint64 samples);
+      std::string makeNpyHeader(quint64 samples, size_t size = 0) const;
+      std::string getSigMFMetaPath(void) const;
+      bool writeSigMFMeta(void);
+      bool isMapped(void) const;
+      bool closeMap(void);
+      bool exportBlocks(BlockWriter const &writer);
+
       bool openMat5(void);
       bool openMatlab(void);
       bool openWav(void);
+      bool openMap(void);
 
       bool exportToMat5(void);
       bool exportToMatlab(void);
       bool exportToWav(void);
+      bool exportToMap(void);
 
-      bool cancelFlag = false;
+      std::atomic<bool> cancelFlag;
 
       void breathe(quint64);
 
@@ -61,8 +86,7 @@ namespace SigDigger {
       ExportSamplesTask(
           QString const &path,
           QString const &format,
-          const SUCOMPLEX *data,
-          size_t length,
+          SampleBuffer const &data,
           qreal fs,
           int start,
           int end);
@@ -72,6 +96,7 @@ namespace SigDigger {
       bool work(void) override;
       void cancel(void) override;
 
+      // Why attemptOpen() or work() failed
       QString getLastError(void) const;
   };
 }
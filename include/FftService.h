@@ -0,0 +1,158 @@
+//
+//    FftService.h: Shared FFT plans and FFTW wisdom
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef FFTSERVICE_H
+#define FFTSERVICE_H
+
+#include <sigutils/types.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Transforms at least this long are split across threads, if FFTW can
+#define SIGDIGGER_FFT_THREADED_MIN_SIZE  (1 << 18)
+
+// Longest transform measured in the background. Longer ones are usually
+// one-off (a whole capture), not worth a scratch buffer and the planner.
+#define SIGDIGGER_FFT_MEASURE_MAX_SIZE   (1 << 16)
+
+// Wisdom file, inside the user's suscan configuration directory
+#define SIGDIGGER_FFT_WISDOM_FILE        "fftw_wisdom"
+
+namespace SigDigger {
+  class FftPlan {
+      SU_FFTW(_plan) plan;
+      size_t size;
+
+    public:
+      FftPlan(SU_FFTW(_plan) plan, size_t size);
+      ~FftPlan();
+
+      size_t
+      getSize(void) const
+      {
+        return this->size;
+      }
+
+      // Thread-safe. Buffer must come from FftService::allocBuffer
+      void execute(SU_FFTW(_complex) *buffer) const;
+  };
+
+  typedef std::shared_ptr<const FftPlan> FftPlanPtr;
+
+  //
+  // In-place complex transforms with plans shared by everyone. Plans are
+  // cached by size and direction. The first request of a size gets a quick
+  // FFTW_ESTIMATE plan. Up to SIGDIGGER_FFT_MEASURE_MAX_SIZE, and if FFTW
+  // has a thread-safe planner (SIGDIGGER_HAVE_FFTW_THREADS), a better one
+  // is measured in the background and replaces it for the next requests.
+  // Measurements are kept as FFTW wisdom across sessions.
+  //
+  class FftService {
+      struct Entry {
+        FftPlanPtr plan;
+        bool measured = false;
+      };
+
+      typedef std::pair<size_t, int> Key; // Size, direction
+
+      static FftService *instance; // Singleton instance
+
+      // The FFTW planner is not reentrant: all planning goes through here
+      std::mutex plannerMutex;
+
+      std::mutex mutex;
+      std::condition_variable cond;
+      std::map<Key, Entry> plans;
+      std::deque<Key> pending;
+      std::thread measurer;
+      bool running = true;
+      bool wisdomChanged = false;
+      std::string wisdomPath;
+
+      FftService();
+
+      SU_FFTW(_plan) makePlan(
+          Key const &key,
+          unsigned int flags,
+          SU_FFTW(_complex) *buffer = nullptr);
+      void runMeasurer(void);
+
+    public:
+      static FftService *getInstance(void);
+
+      // Thread-safe. Nullptr if FFTW could not make a plan. If given, new
+      // plans are made on buffer (from allocBuffer, of the given size),
+      // which is left untouched, instead of a scratch one.
+      FftPlanPtr getPlan(
+          size_t size,
+          int direction = FFTW_FORWARD,
+          SU_FFTW(_complex) *buffer = nullptr);
+
+      static SU_FFTW(_complex) *allocBuffer(size_t size);
+      static void freeBuffer(SU_FFTW(_complex) *buffer);
+
+      // Stops measuring and saves the wisdom gathered in this session
+      void shutdown(void);
+
+      // Only called by FftPlan
+      void destroyPlan(SU_FFTW(_plan) plan);
+
+      ~FftService();
+  };
+
+  //
+  // Buffer for a zero-padded, in-place transform of at least some length,
+  // rounded up to the next power of two.
+  //
+  class FftBuffer {
+      FftPlanPtr plan;
+      SU_FFTW(_complex) *buffer = nullptr;
+      size_t size = 0;
+
+    public:
+      FftBuffer() = default;
+      FftBuffer(FftBuffer const &) = delete;
+      FftBuffer &operator=(FftBuffer const &) = delete;
+      ~FftBuffer();
+
+      bool allocate(size_t minSize, int direction = FFTW_FORWARD);
+
+      // Copies len samples and zeroes the rest
+      void load(const SUCOMPLEX *data, size_t len);
+      void execute(void);
+
+      SUCOMPLEX *
+      data(void) const
+      {
+        return reinterpret_cast<SUCOMPLEX *>(this->buffer);
+      }
+
+      size_t
+      getSize(void) const
+      {
+        return this->size;
+      }
+  };
+}
+
+#endif // FFTSERVICE_H
@@ -21,17 +21,42 @@
 #define ASYNCDATASAVER_H
 
 #include "GenericDataSaver.h"
+#include <string>
 
 namespace SigDigger {
-  class FileDataWriter;
-
   class FileDataSaver : public GenericDataSaver {
     Q_OBJECT
 
-    FileDataWriter *writer = nullptr;
+    GenericDataWriter *writer = nullptr;
 
   public:
-    FileDataSaver(int fd, QObject *parent = nullptr);
+    //
+    // Segmented recordings are written to prefix_0001suffix,
+    // prefix_0002suffix... Zero in any of the limits disables it.
+    //
+    struct SegmentParams {
+      std::string prefix;
+      std::string suffix = ".raw";
+      quint64 maxSize = 0;         // Segment size, in bytes
+      quint64 maxDuration = 0;     // Segment duration, in seconds
+      quint64 quota = 0;           // Total size of kept segments, in bytes
+      unsigned int sampRate = 0;
+
+      bool
+      enabled(void) const
+      {
+        return this->maxSize > 0 || this->maxDuration > 0;
+      }
+    };
+
+    FileDataSaver(
+        int fd,
+        QObject *parent = nullptr,
+        QThread *thread = nullptr);
+    FileDataSaver(
+        SegmentParams const &params,
+        QObject *parent = nullptr,
+        QThread *thread = nullptr);
     ~FileDataSaver();
   };
 }
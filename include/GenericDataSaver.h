@@ -25,11 +25,18 @@
 #include <QThread>
 #include <QMutex>
 #include <vector>
+#include <atomic>
 #include <sigutils/types.h>
 #include <sys/time.h>
+#include <DataSaverStats.h>
+
+// Minimum time between two writer syncs, in milliseconds. Syncing is
+// opt-in (the "Disk sync" setting of recordings): 0 means never.
+#define SIGDIGGER_DATASAVER_SYNC_INTERVAL_MS 0
 
 namespace SigDigger {
   class GenericDataSaver;
+  class PreRollBuffer;
 
 
   class GenericDataWriter {
@@ -39,6 +46,14 @@ namespace SigDigger {
     virtual ssize_t write(const SUCOMPLEX *data, size_t len) = 0;
     virtual bool close(void) = 0;
     virtual std::string getError(void) const = 0;
+
+    // Writers backed by storage flush their data to it here
+    virtual bool canSync(void) const;
+    virtual bool sync(void);
+
+    // Bytes the writer discarded on its own (e.g. slow network clients)
+    virtual quint64 getDropped(void) const;
+
     virtual ~GenericDataWriter();
   };
 
@@ -48,10 +63,19 @@ namespace SigDigger {
       bool failed = false;
       bool writerPrepared = false;
       GenericDataSaver *instance;
+      struct timeval firstCommit;
+      struct timeval lastSync;
+
+      void syncWriter(struct timeval const &now);
+
+      bool writeAll(const SUCOMPLEX *data, size_t len);
 
     private slots:
       void onCommit(void);
       void onPrepare(void);
+      void onFlushPreRoll(void);
+      void onDetach(void);
+      void onFlush(void);
 
     public:
       GenericDataWorker(GenericDataSaver *intance);
@@ -75,14 +99,21 @@ namespace SigDigger {
       unsigned int buffer = 0;
       unsigned int commitedSize;
       unsigned int ptr = 0;
+      size_t tail = 0; // Bytes of a partially filled sample after ptr
       GenericDataWriter *writer = nullptr;
+      PreRollBuffer *preRoll = nullptr;
       bool bufferReady = true;
       bool dataWritten = false;
       QThread workerThread;
+      QThread *workerHost = nullptr;
       GenericDataWorker workerObject;
 
       QMutex dataMutex;
 
+      DataSaverStats stats;
+      mutable QMutex statsMutex;
+      std::atomic<unsigned int> syncInterval;
+
       struct timeval lastCommit;
       quint64 commitTime = 0;
       quint64 writeTime = 0;
@@ -90,19 +121,34 @@ namespace SigDigger {
 
       // Private methods
       void doCommit(void);
+      void writeBytes(const void *data, size_t bytes);
 
     public:
+      // If thread is null, the saver runs its own worker thread
       explicit GenericDataSaver(
           GenericDataWriter *writer,
-          QObject *parent = nullptr);
+          QObject *parent = nullptr,
+          QThread *thread = nullptr);
       ~GenericDataSaver();
 
       // Public methods
       void setBufferSize(unsigned int size);
       void setSampleRate(unsigned int i);
+      void setPreRoll(PreRollBuffer *preRoll);
+      void setSyncInterval(unsigned int ms);
       void write(const SUCOMPLEX *data, size_t size);
+
+      // Real-valued streams are packed into the same buffers. Writers
+      // see them as complex samples holding several real ones each.
+      void write(const SUFLOAT *data, size_t size);
+      void write(const int16_t *data, size_t size);
+
+      // Waits until the worker has written every commit issued so far
+      void flush(void);
+
       QString getLastError(void) const;
       quint64 getSize(void) const;
+      DataSaverStats getStats(void) const;
 
       // Friend classes
       friend class GenericDataWorker;
@@ -110,6 +156,7 @@ namespace SigDigger {
     signals:
       void prepare(void);
       void commit(void);
+      void flushPreRoll(void);
 
       void ready(void);
       void stopped(void);
@@ -21,6 +21,7 @@
 #define GENERICDATASAVERUI_H
 
 #include <PersistentWidget.h>
+#include <DataSaverStats.h>
 
 //
 // TODO: How about doing the same with the network forwarder?
@@ -31,6 +32,8 @@ namespace SigDigger {
     Q_OBJECT
 
   protected:
+    DataSaverStats stats;
+
     virtual void setDiskUsage(qreal) = 0;
 
   public:
@@ -38,6 +41,7 @@ namespace SigDigger {
     virtual ~GenericDataSaverUI();
 
     void refreshDiskUsage(void);
+    static void saveStats(QWidget *parent, DataSaverStats const &stats);
 
     // Setters
     virtual void setRecordSavePath(std::string const &) = 0;
@@ -45,11 +49,15 @@ namespace SigDigger {
     virtual void setCaptureSize(quint64) = 0;
     virtual void setIORate(qreal) = 0;
     virtual void setRecordState(bool state) = 0;
+    virtual void setStats(DataSaverStats const &stats);
 
     // Getters
     virtual bool getRecordState(void) const = 0;
     virtual std::string getRecordSavePath(void) const = 0;
 
+  public slots:
+    void onSaveStats(void);
+
   signals:
     void recordSavePathChanged(QString);
     void recordStateChanged(bool state);
@@ -19,19 +19,24 @@
 #ifndef HISTOGRAMFEEDER_H
 #define HISTOGRAMFEEDER_H
 
-#include <Suscan/CancellableTask.h>
+#include <Suscan/SplittableTask.h>
 #include "SamplingProperties.h"
+#include <vector>
 
-#define SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH 4096
+// Samples measured in every call to work() and delivered through data()
+#define SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH (1 << 20)
 
 namespace SigDigger {
-  class HistogramFeeder : public Suscan::CancellableTask {
+  class HistogramFeeder : public Suscan::SplittableTask {
     Q_OBJECT
 
     SamplingProperties properties;
-    size_t p = 0;
 
-    SUFLOAT block[SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH];
+    std::vector<SUFLOAT> block;
+
+  protected:
+    void processRange(size_t first, size_t len) override;
+    void blockDone(size_t first, size_t len) override;
 
   public:
     HistogramFeeder(
@@ -39,7 +44,6 @@ namespace SigDigger {
         QObject *parent = nullptr);
     virtual ~HistogramFeeder() override;
 
-    virtual bool work(void) override;
     virtual void cancel(void) override;
 
 
@@ -5,12 +5,13 @@
 #include <Suscan/Analyzer.h>
 #include <Suscan/Config.h>
 #include <InspectorUI.h>
+#include <SampleBus.h>
 #include <Suscan/Messages/InspectorMessage.h>
 
 namespace SigDigger {
   class AppConfig;
 
-  class Inspector : public QWidget
+  class Inspector : public QWidget, public SampleConsumer
   {
       Q_OBJECT
 
@@ -33,11 +34,7 @@ namespace SigDigger {
         return this->id;
       }
 
-      void
-      setId(Suscan::InspectorId id)
-      {
-        this->id = id;
-      }
+      void setId(Suscan::InspectorId id);
 
       Suscan::Analyzer *
       getAnalyzer(void) const
@@ -53,6 +50,7 @@ namespace SigDigger {
 
       void setAnalyzer(Suscan::Analyzer *analyzer);
       void feed(const SUCOMPLEX *data, unsigned int size);
+      void consume(SampleBuffer const &buffer) override;
       void feedSpectrum(const SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate);
       void updateEstimator(Suscan::EstimatorId id, float val);
       void showEvent(QShowEvent *event);
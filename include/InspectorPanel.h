@@ -22,6 +22,7 @@
 #include <PersistentWidget.h>
 #include <TimeWindow.h>
 #include <ColorConfig.h>
+#include <SampleBus.h>
 
 #define SIGDIGGER_DEFAULT_SQUELCH_TRIGGER  10
 #define SIGDIGGER_DEFAULT_UPDATEUI_PERIOD_MS 250.
@@ -47,7 +48,7 @@ namespace SigDigger {
     Suscan::Object &&serialize(void) override;
   };
 
-  class InspectorPanel : public PersistentWidget
+  class InspectorPanel : public PersistentWidget, public SampleConsumer
   {
     Q_OBJECT
 
@@ -75,7 +76,12 @@ namespace SigDigger {
     // UI State
     State state = DETACHED;
 
-    std::vector<SUCOMPLEX> data;
+    // Captured batches are kept by reference, and only laid out
+    // contiguously (in data) when the sample viewer is opened
+    std::vector<SampleBuffer> pending;
+    size_t pendingSamples = 0;
+    std::shared_ptr<const std::vector<SUCOMPLEX>> data =
+        std::make_shared<std::vector<SUCOMPLEX>>();
     std::vector<SUCOMPLEX> history;
     unsigned int historyPtr = 0;
     SUFLOAT  currEnergy = 0;
@@ -97,6 +103,9 @@ namespace SigDigger {
     void refreshCaptureInfo(void);
     void openTimeWindow(void);
     void transferHistory(void);
+    void appendCapture(SampleBuffer const &buffer);
+    void flushCapture(void);
+    size_t getCaptureSize(void) const;
 
   public:
     explicit InspectorPanel(QWidget *parent = nullptr);
@@ -111,7 +120,8 @@ namespace SigDigger {
     void setState(enum State state);
 
     void resetRawInspector(qreal sampleRate);
-    void feedRawInspector(const SUCOMPLEX *data, size_t size);
+    void feedRawInspector(SampleBuffer const &buffer);
+    void consume(SampleBuffer const &buffer) override;
 
     unsigned int getBandwidth(void) const;
     std::string getInspectorClass(void) const;
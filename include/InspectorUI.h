@@ -85,6 +85,8 @@ namespace SigDigger {
     bool estimating = false;
     struct timeval last_estimator_update;
     std::vector<SUCOMPLEX> buffer;
+    std::vector<SUFLOAT> realBuffer;
+    std::vector<int16_t> intBuffer;
 
     // UI objects
     std::vector<Suscan::Estimator> estimators;
@@ -100,6 +102,8 @@ namespace SigDigger {
     NetForwarderUI *netForwarderUI = nullptr;
     FileDataSaver *dataSaver = nullptr;
     SocketForwarder *socketForwarder = nullptr;
+    RealSampleFormat recordFormat = REAL_SAMPLE_FORMAT_COMPLEX;
+    RealSampleFormat forwardFormat = REAL_SAMPLE_FORMAT_COMPLEX;
 
     TVProcessorTab *tvTab = nullptr;
     WaveformTab *wfTab = nullptr;
@@ -124,7 +128,14 @@ namespace SigDigger {
     void connectDataSaver(void);
     void connectNetForwarder(void);
     void refreshSizes(void);
+    std::string captureFilePrefix(void) const;
     std::string captureFileName(void) const;
+    RealSampleFormat streamFormat(RealSampleFormat requested) const;
+    void writeSamples(
+        GenericDataSaver *saver,
+        RealSampleFormat format,
+        const SUCOMPLEX *data,
+        unsigned int size);
     unsigned int getVScrollPageSize(void) const;
     unsigned int getHScrollOffset(void) const;
     void refreshVScrollBar(void) const;
@@ -0,0 +1,105 @@
+//
+//    MatlabWriter.h: Fast MATLAB / Octave text file writer
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef MATLABWRITER_H
+#define MATLABWRITER_H
+
+#include <sigutils/types.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+// Room for the longest string of MatlabWriter::formatFloat (-1.23456789e-45)
+#define SIGDIGGER_MATLAB_FLOAT_MAX_LEN     16
+
+// Elements formatted by a single thread in one go
+#define SIGDIGGER_MATLAB_CHUNK_ELEMENTS    0x10000
+
+// Upper bound of formatting threads
+#define SIGDIGGER_MATLAB_MAX_THREADS       8
+
+namespace SigDigger {
+  //
+  // Writes .m files with big arrays. Numbers are printed with the shortest
+  // representation that reads back as the same float, and arrays are cut
+  // in chunks that are formatted in parallel and written in order.
+  //
+  class MatlabWriter {
+    public:
+      // Called after every batch of chunks with the number of elements
+      // written so far. Returning false aborts the write.
+      typedef std::function<bool (size_t)> ProgressCallback;
+
+    private:
+      // Formats count elements starting from first into buf, returns length
+      typedef std::function<size_t (char *, size_t, size_t)> ChunkFormatter;
+
+      FILE *fp = nullptr;
+      unsigned int threads;
+      std::vector<std::vector<char>> buffers;
+      ProgressCallback onProgress;
+      uint64_t workerCpuTime = 0;
+
+      bool writeChunks(
+          size_t count,
+          size_t maxElementLen,
+          ChunkFormatter const &formatter);
+
+    public:
+      MatlabWriter();
+      ~MatlabWriter();
+
+      bool open(std::string const &path);
+      bool close(void);
+      bool isOpen(void) const;
+
+      void setProgressCallback(ProgressCallback const &cb);
+
+      // CPU time (microseconds) of the formatting threads other than the
+      // caller since the last call. The caller's own time is not included.
+      uint64_t takeWorkerCpuTime(void);
+
+      bool writeText(std::string const &text);
+      bool writeScalar(std::string const &name, double value);
+
+      // name = [ re + imi, ... ];
+      bool writeComplex(
+          std::string const &name,
+          const SUCOMPLEX *data,
+          size_t len);
+
+      // name = [ x ... ];
+      bool writeReal(std::string const &name, const SUFLOAT *data, size_t len);
+
+      // name = [ re, im; ... ] (one row per sample, two columns)
+      bool writeColumns(
+          std::string const &name,
+          const SUCOMPLEX *data,
+          size_t len);
+
+      // Shortest decimal string that is parsed back as exactly the same
+      // float, in the style of %g. buf must hold at least
+      // SIGDIGGER_MATLAB_FLOAT_MAX_LEN bytes. No terminator is written.
+      static size_t formatFloat(char *buf, float value);
+  };
+}
+
+#endif // MATLABWRITER_H
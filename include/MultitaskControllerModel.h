@@ -21,6 +21,10 @@
 
 #include <QAbstractTableModel>
 #include <Suscan/MultitaskController.h>
+#include <string>
+
+// Finished tasks remembered by the model. Older ones are forgotten.
+#define SIGDIGGER_TASK_HISTORY_LENGTH 1000
 
 namespace SigDigger {
   class MultitaskControllerModel : public QAbstractTableModel
@@ -29,6 +33,7 @@ namespace SigDigger {
 
       Suscan::MultitaskController *controller;
       QVector<Suscan::CancellableTaskContext *> taskVec;
+      QList<Suscan::TaskTelemetry> history;
 
       void connectAll(void);
 
@@ -42,13 +47,24 @@ namespace SigDigger {
       QVariant data(const QModelIndex &, int) const override;
       QVariant headerData(int, Qt::Orientation, int) const override;
 
+      QList<Suscan::TaskTelemetry> const &getHistory(void) const;
+      void clearHistory(void);
+
+      std::string historyToCsv(void) const;
+      std::string historyToJson(void) const;
+
+      // JSON if path ends with .json, CSV otherwise
+      bool saveHistory(std::string const &path) const;
+
     signals:
       void taskError(QString, QString);
+      void historyChanged(void);
 
     public slots:
       void onListChanged(void);
       void onError(int, QString);
       void onProgress(int, qreal, QString);
+      void onTaskFinished(Suscan::TaskTelemetry);
   };
 }
 
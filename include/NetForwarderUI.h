@@ -22,6 +22,8 @@
 
 #include <QWidget>
 #include <WaitingSpinnerWidget.h>
+#include <SocketForwarder.h>
+#include <DataSaverStats.h>
 
 namespace Ui {
   class UDPForwarderUI;
@@ -33,6 +35,7 @@ namespace SigDigger {
     Q_OBJECT
 
     WaitingSpinnerWidget *spinner = nullptr;
+    DataSaverStats stats;
 
     void connectAll(void);
 
@@ -50,6 +53,7 @@ namespace SigDigger {
     void setForwardEnabled(bool enabled);
     void setCaptureSize(quint64 size);
     void setTcp(bool);
+    void setStats(DataSaverStats const &stats);
 
     // Getters
     std::string getHost(void) const;
@@ -57,9 +61,16 @@ namespace SigDigger {
     unsigned int getFrameLen(void) const;
     bool getForwardState(void) const;
     bool getTcp(void) const;
+    bool getFramed(void) const;
+    bool getServer(void) const;
+    ForwarderSlowClientPolicy getSlowClientPolicy(void) const;
+    ForwarderSampleFormat getFormat(void) const;
+    quint64 getPacing(void) const;
 
   public slots:
     void onForwardStartStop(void);
+    void onSocketTypeChanged(void);
+    void onSaveStats(void);
 
   signals:
     void forwardStateChanged(bool state);
@@ -0,0 +1,104 @@
+//
+//    PipelineStages.h: Translation, filtering and measurement stages
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef PIPELINESTAGES_H
+#define PIPELINESTAGES_H
+
+#include <SamplePipeline.h>
+#include <SamplingProperties.h>
+#include <WaveSampler.h>
+#include <QVector>
+#include <sigutils/iir.h>
+#include <sigutils/clock.h>
+
+namespace SigDigger {
+  // Moves a carrier at relFreq (normalized) to baseband
+  class XlatorStage : public PipelineStage {
+      Q_OBJECT
+
+      double omega; // Radians per sample
+
+    public:
+      explicit XlatorStage(SUFLOAT relFreq, QObject *parent = nullptr);
+
+      void process(SampleBlock &block) override;
+  };
+
+  // Butterworth low-pass filter, cutoff in normalized frequency
+  class LowpassStage : public PipelineStage {
+      Q_OBJECT
+
+      su_iir_filt_t filt;
+      bool filtInit = false;
+
+    public:
+      LowpassStage(
+          unsigned int order,
+          SUFLOAT relCutoff,
+          QObject *parent = nullptr);
+      ~LowpassStage() override;
+
+      void process(SampleBlock &block) override;
+  };
+
+  // Measures samples in the given space, like HistogramFeeder does
+  class HistogramStage : public PipelineStage {
+      Q_OBJECT
+
+      SamplingSpace space;
+      SUCOMPLEX prev = 0;
+      bool havePrev = false;
+
+    public:
+      explicit HistogramStage(SamplingSpace space, QObject *parent = nullptr);
+
+      void process(SampleBlock &block) override;
+
+    signals:
+      void data(QVector<float>);
+  };
+
+  // Gardner clock recovery and symbol decision, like WaveSampler does
+  class SamplerStage : public PipelineStage {
+      Q_OBJECT
+
+      SamplingProperties properties;
+      const Decider *decider;
+      su_clock_detector_t cd;
+      bool cdInit = false;
+      SUCOMPLEX prev = 0;
+      WaveSampleSet set;
+
+      void deliver(void);
+
+    public:
+      SamplerStage(
+          SamplingProperties const &props,
+          const Decider *decider,
+          QObject *parent = nullptr);
+      ~SamplerStage() override;
+
+      void process(SampleBlock &block) override;
+      void finish(void) override;
+
+    signals:
+      void data(SigDigger::WaveSampleSet);
+  };
+}
+
+#endif // PIPELINESTAGES_H
@@ -0,0 +1,67 @@
+//
+//    PreRollBuffer.h: Keep the last seconds of data before a recording
+//    Copyright (C) 2019 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef PREROLLBUFFER_H
+#define PREROLLBUFFER_H
+
+#include <QMutex>
+#include <vector>
+#include <sigutils/types.h>
+
+namespace SigDigger {
+  class GenericDataSaver;
+
+  //
+  // The pre-roll buffer sits between the sample source and the data saver.
+  // While nothing is being recorded, samples are kept in a preallocated
+  // ring. When a saver is attached, the ring is frozen and handed over to
+  // the saver's worker thread, which writes it to disk before any other
+  // sample. Once done, the worker thaws the ring and it starts filling again.
+  //
+  class PreRollBuffer {
+    std::vector<SUCOMPLEX> ring;
+    size_t ptr = 0;
+    size_t filled = 0;
+    bool frozen = false;
+
+    GenericDataSaver *saver = nullptr;
+    QMutex mutex;
+
+    void store(const SUCOMPLEX *data, size_t len);
+
+  public:
+    bool setLength(size_t len);
+    size_t getLength(void) const;
+
+    void feed(const SUCOMPLEX *data, size_t len);
+    void attach(GenericDataSaver *saver);
+    void detach(void);
+    void thaw(void);
+    void clear(void);
+
+    // Only meaningful while frozen
+    void getSpans(
+        const SUCOMPLEX *&first,
+        size_t &firstLen,
+        const SUCOMPLEX *&second,
+        size_t &secondLen) const;
+  };
+}
+
+#endif // PREROLLBUFFER_H
@@ -0,0 +1,94 @@
+//
+//    RecordingService.h: Shared writer threads for channel recordings
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RECORDINGSERVICE_H
+#define RECORDINGSERVICE_H
+
+#include <QThread>
+#include <list>
+#include <vector>
+#include <string>
+#include <DataSaverStats.h>
+
+#define SIGDIGGER_RECORDING_SERVICE_MAX_THREADS 4
+
+namespace SigDigger {
+  class GenericDataSaver;
+
+  //
+  // Channel recordings (inspector outputs) are narrowband and many. Instead
+  // of giving each of them a thread of its own, they share a small pool of
+  // writer threads. Channels assigned to the same thread have their commits
+  // written one after another, which keeps the number of concurrent writers
+  // hitting the disk bounded no matter how many channels are recorded.
+  //
+  class RecordingService {
+  public:
+    struct ChannelStats {
+      std::string name;
+      unsigned int thread;
+      DataSaverStats stats;
+    };
+
+  private:
+    struct Channel {
+      std::string name;
+      GenericDataSaver *saver;
+      unsigned int thread;
+    };
+
+    static RecordingService *instance; // Singleton instance
+
+    std::vector<QThread *> threads;
+    std::vector<unsigned int> load;
+    std::list<Channel> channels;
+    bool down = false;
+
+    RecordingService();
+
+  public:
+    static RecordingService *getInstance(void);
+
+    // Least loaded thread of the pool, grown on demand. Null after
+    // shutdown(), which makes new savers run their own thread.
+    QThread *acquireThread(void);
+
+    void registerSaver(
+        std::string const &name,
+        GenericDataSaver *saver,
+        QThread *thread);
+    void unregisterSaver(GenericDataSaver *saver);
+
+    unsigned int getChannelCount(void) const;
+    unsigned int getThreadCount(void) const;
+    std::vector<ChannelStats> getChannelStats(void) const;
+    DataSaverStats getTotalStats(void) const;
+
+    // JSON if the file name ends in .json, CSV otherwise
+    bool saveStats(std::string const &path) const;
+
+    // Writes pending commits and stops the pool. Savers still recording
+    // keep their buffers, but nothing is written from now on.
+    void shutdown(void);
+
+    ~RecordingService();
+  };
+}
+
+#endif // RECORDINGSERVICE_H
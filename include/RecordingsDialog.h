@@ -0,0 +1,58 @@
+//
+//    RecordingsDialog.h: Shared view of channel recordings
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RECORDINGSDIALOG_H
+#define RECORDINGSDIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+
+#define SIGDIGGER_RECORDINGS_DIALOG_REFRESH_MS 1000
+
+namespace Ui {
+  class RecordingsDialog;
+}
+
+namespace SigDigger {
+  class RecordingsDialog : public QDialog
+  {
+      Q_OBJECT
+
+      QTimer timer;
+
+      void connectAll(void);
+
+    protected:
+      void showEvent(QShowEvent *event) override;
+      void hideEvent(QHideEvent *event) override;
+
+    public:
+      explicit RecordingsDialog(QWidget *parent = nullptr);
+      ~RecordingsDialog() override;
+
+    private:
+      Ui::RecordingsDialog *ui;
+
+    public slots:
+      void onRefresh(void);
+      void onSaveStats(void);
+  };
+}
+
+#endif // RECORDINGSDIALOG_H
@@ -0,0 +1,139 @@
+//
+//    SampleBus.h: Zero-copy distribution of inspector samples
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SAMPLEBUS_H
+#define SAMPLEBUS_H
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <Suscan/Message.h>
+#include <sigutils/types.h>
+
+namespace Suscan {
+  class SamplesMessage;
+}
+
+namespace SigDigger {
+  //
+  // Immutable, reference counted view of a block of samples. Copies of
+  // a SampleBuffer share the same storage, which stays alive (be it a
+  // suscan message or a vector) until the last copy goes away.
+  //
+  class SampleBuffer {
+    std::shared_ptr<const void> owner;
+    const SUCOMPLEX *ptr = nullptr;
+    size_t len = 0;
+
+  public:
+    SampleBuffer();
+
+    // Wraps the message payload, no copy involved
+    explicit SampleBuffer(Suscan::SamplesMessage const &msg);
+
+    // Takes ownership of the vector contents
+    explicit SampleBuffer(std::vector<SUCOMPLEX> &&data);
+
+    // Shares a vector. It must not be modified while buffers refer to it:
+    // owners replace it instead (see SampleBuffer::isShared).
+    explicit SampleBuffer(
+        std::shared_ptr<const std::vector<SUCOMPLEX>> const &data);
+
+    SampleBuffer slice(size_t offset, size_t len) const;
+
+    const SUCOMPLEX *
+    data(void) const
+    {
+      return this->ptr;
+    }
+
+    size_t
+    size(void) const
+    {
+      return this->len;
+    }
+
+    bool
+    empty(void) const
+    {
+      return this->len == 0;
+    }
+
+    const SUCOMPLEX &
+    operator[](size_t index) const
+    {
+      return this->ptr[index];
+    }
+
+    // Whether someone besides the owner of data refers to it
+    template<class T>
+    static bool
+    isShared(std::shared_ptr<T> const &data, long ownerRefs = 1)
+    {
+      return data.use_count() > ownerRefs;
+    }
+  };
+
+  class SampleConsumer {
+  public:
+    // Called from the thread that publishes the samples (the GUI thread).
+    // Consumers that run on a thread of their own should keep a copy of
+    // the buffer (it is just a reference) and return immediately.
+    virtual void consume(SampleBuffer const &buffer) = 0;
+
+    virtual ~SampleConsumer();
+  };
+
+  //
+  // Publish / subscribe hub for the sample batches the analyzer delivers
+  // to inspectors. Every consumer subscribed to an inspector id gets a
+  // reference to the same buffer. Subscription and publication happen
+  // in the GUI thread.
+  //
+  class SampleBus {
+    static SampleBus *instance; // Singleton instance
+
+    std::multimap<Suscan::InspectorId, SampleConsumer *> consumers;
+
+    // Publications in progress, with a snapshot of their consumers
+    struct Dispatch {
+      Suscan::InspectorId id;
+      std::vector<SampleConsumer *> targets;
+    };
+
+    std::vector<Dispatch *> dispatches;
+
+    SampleBus();
+
+    // Drops consumer from the snapshots (of the given id, or all if null)
+    void forget(SampleConsumer *consumer, const Suscan::InspectorId *id);
+
+  public:
+    static SampleBus *getInstance(void);
+
+    void subscribe(Suscan::InspectorId id, SampleConsumer *consumer);
+    void unsubscribe(Suscan::InspectorId id, SampleConsumer *consumer);
+    void unsubscribe(SampleConsumer *consumer);
+
+    // Returns the number of consumers the buffer was delivered to
+    unsigned int publish(Suscan::InspectorId id, SampleBuffer const &buffer);
+  };
+}
+
+#endif // SAMPLEBUS_H
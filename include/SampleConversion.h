@@ -0,0 +1,64 @@
+//
+//    SampleConversion.h: Vectorizable sample format conversions
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SAMPLECONVERSION_H
+#define SAMPLECONVERSION_H
+
+#include <sigutils/types.h>
+#include <cstdint>
+#include <cstddef>
+
+//
+// Sample loops marked with SIGDIGGER_VECTORIZE are written so that the
+// compiler can turn them into SIMD code: no function calls (not even fabs,
+// which is not inlined into functions built with different optimization
+// flags), no data-dependent branches and no aliasing between input and
+// output. GCC does not vectorize at -O2 before version 12, and refuses to
+// turn conditionals into selects unless floating point traps are ignored.
+//
+#if defined(__GNUC__) && !defined(__clang__)
+#  define SIGDIGGER_VECTORIZE \
+  __attribute__((optimize("tree-vectorize", "no-trapping-math")))
+#else
+#  define SIGDIGGER_VECTORIZE
+#endif // defined(__GNUC__) && !defined(__clang__)
+
+namespace SigDigger {
+  //
+  // Sample formats of the real-valued recording path. Phase and frequency
+  // decisions only need the argument of each sample, so storing them as
+  // complex numbers with a zero imaginary part wastes half the bandwidth.
+  //
+  enum RealSampleFormat {
+    REAL_SAMPLE_FORMAT_COMPLEX, // Legacy: arg in the real part, zero imag
+    REAL_SAMPLE_FORMAT_FLOAT32,
+    REAL_SAMPLE_FORMAT_INT16
+  };
+
+  // Bytes taken by a single sample in the given format
+  size_t realSampleSize(RealSampleFormat format);
+
+  // out[i] = arg(I * in[i]) / PI, in [-1, 1]. Absolute error below 1e-7.
+  void phaseToReal(SUFLOAT *out, const SUCOMPLEX *in, size_t len);
+
+  // Scale [-1, 1] to the full int16 range, rounding and saturating
+  void realToInt16(int16_t *out, const SUFLOAT *in, size_t len);
+}
+
+#endif // SAMPLECONVERSION_H
@@ -0,0 +1,129 @@
+//
+//    SamplePipeline.h: Streaming sample processing pipelines
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SAMPLEPIPELINE_H
+#define SAMPLEPIPELINE_H
+
+#include <Suscan/CancellableTask.h>
+#include <SampleBus.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Samples travelling together between stages
+#define SIGDIGGER_PIPELINE_BLOCK_LENGTH 0x10000
+
+// Blocks waiting in front of every stage
+#define SIGDIGGER_PIPELINE_QUEUE_DEPTH  4
+
+namespace SigDigger {
+  struct SampleBlock {
+    std::vector<SUCOMPLEX> samples;
+    size_t offset = 0; // Position of the first sample in the stream
+  };
+
+  //
+  // Bounded FIFO of blocks. Producers wait while it is full and consumers
+  // while it is empty, so a slow stage throttles the ones before it.
+  //
+  class SampleBlockQueue {
+      std::mutex mutex;
+      std::condition_variable cond;
+      std::deque<SampleBlock> blocks;
+      size_t capacity;
+      bool closed = false;
+      bool aborted = false;
+
+    public:
+      explicit SampleBlockQueue(size_t capacity);
+
+      // False if the queue was aborted
+      bool push(SampleBlock &&block);
+
+      // False if the queue was aborted, or closed and drained
+      bool pop(SampleBlock &block);
+
+      // No more blocks will be pushed
+      void close(void);
+
+      // Wakes up everyone waiting and makes further calls fail
+      void abort(void);
+  };
+
+  //
+  // A step of a pipeline. Each stage runs in its own thread and receives
+  // the blocks of the stream in order.
+  //
+  class PipelineStage : public QObject {
+      Q_OBJECT
+
+    public:
+      explicit PipelineStage(QObject *parent = nullptr);
+      virtual ~PipelineStage() override;
+
+      // Samples may be modified in place for the next stages
+      virtual void process(SampleBlock &block) = 0;
+
+      // Called after the last block, unless the pipeline was cancelled
+      virtual void finish(void);
+  };
+
+  //
+  // Streams a sample buffer through a chain of stages. Only a handful of
+  // blocks exist at any time, which are recycled once the last stage is
+  // done with them, so memory usage does not depend on the buffer length.
+  //
+  class SamplePipeline : public Suscan::CancellableTask {
+      Q_OBJECT
+
+      SampleBuffer source;
+      size_t p = 0;
+      bool started = false;
+
+      std::vector<PipelineStage *> stages;
+
+      // queues[i] feeds stages[i]. The last one holds free blocks.
+      std::vector<SampleBlockQueue *> queues;
+      std::vector<std::thread> threads;
+      std::mutex threadMutex;
+      std::atomic<size_t> consumed;
+      std::atomic<bool> cancelFlag;
+
+      void start(void);
+      void abort(void);
+      void join(void);
+      void runStage(size_t index);
+
+    public:
+      explicit SamplePipeline(
+          SampleBuffer const &source,
+          QObject *parent = nullptr);
+      virtual ~SamplePipeline() override;
+
+      // Takes ownership. Stages cannot be added once work() is called.
+      void addStage(PipelineStage *stage);
+
+      virtual bool work(void) override;
+      virtual void cancel(void) override;
+  };
+}
+
+#endif // SAMPLEPIPELINE_H
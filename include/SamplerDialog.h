@@ -21,6 +21,7 @@
 
 #include <QDialog>
 #include "WaveSampler.h"
+#include "PipelineStages.h"
 #include "ColorConfig.h"
 
 namespace Ui {
@@ -56,6 +57,7 @@ namespace SigDigger {
     void closeEvent(QCloseEvent *);
 
     WaveSampler *makeSampler(void);
+    SamplerStage *makeSamplerStage(void);
 
   signals:
     void resample(void);
@@ -23,8 +23,10 @@
 #include <vector>
 #include <Suscan/Library.h>
 #include <Palette.h>
+#include <SampleBus.h>
 #include <QStyledItemDelegate>
 #include <QItemDelegate>
+#include <QStringList>
 
 class QComboBox;
 
@@ -58,10 +60,15 @@ namespace SigDigger {
         const SUCOMPLEX *data,
         int length);
 
+    // Name filters of the sample export formats: "Description (*.ext)"
+    static QStringList sampleFileFilters(void);
+    static QString sampleFileExtension(QString const &filter);
+    static QString sampleFileFormat(QString const &filter);
+
+    // The export task keeps a reference to data, not a copy
     static void openSaveSamplesDialog(
         QWidget *root,
-        const SUCOMPLEX *data,
-        size_t len,
+        SampleBuffer const &data,
         qreal fs,
         int start,
         int end,
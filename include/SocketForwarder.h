@@ -20,26 +20,74 @@
 #define UDPFORWARDER_H
 
 #include "GenericDataSaver.h"
+#include <cstdint>
 
 #define SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE 508
 #define SIGDIGGER_UDPFORWARDER_MAX_UDP_SAMPLES \
   (SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE / static_cast<ssize_t>(sizeof(float _Complex)))
 
+// Number of datagrams handed to the kernel in a single system call
+#define SIGDIGGER_UDPFORWARDER_BATCH_SIZE 64
+
+// Pending data allowed per client in server mode, in bytes
+#define SIGDIGGER_FORWARDER_CLIENT_QUEUE_SIZE (16 << 20)
+
+//
+// Framed UDP datagrams start with this header. All fields are big endian.
+// The sequence number increments by one in every datagram, and the sample
+// index counts samples since the beginning of the stream, so receivers can
+// detect both lost and reordered datagrams. Both count samples of the
+// format announced by the header, not bytes.
+//
+#define SIGDIGGER_FORWARDER_FRAME_MAGIC   0x53444658 // "SDFX"
+#define SIGDIGGER_FORWARDER_FRAME_VERSION 1
+
 namespace SigDigger {
-  class SocketDataWriter;
+  enum ForwarderSampleFormat {
+    FORWARDER_FORMAT_COMPLEX_FLOAT32 = 0,
+    FORWARDER_FORMAT_FLOAT32         = 1,
+    FORWARDER_FORMAT_INT16           = 2
+  };
+
+  struct ForwarderFrameHeader {
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  format;
+    uint16_t count;       // Samples in this datagram
+    uint32_t sequence;
+    uint32_t flags;       // Reserved, zero
+    uint64_t sampleIndex; // Index of the first sample in this datagram
+    uint64_t timestamp;   // Transmission time, ns since the Unix epoch
+  };
+
+  enum ForwarderSlowClientPolicy {
+    FORWARDER_SLOW_CLIENT_DROP,
+    FORWARDER_SLOW_CLIENT_DISCONNECT
+  };
 
   class SocketForwarder : public GenericDataSaver {
     Q_OBJECT
 
-    SocketDataWriter *writer = nullptr;
+    GenericDataWriter *writer = nullptr;
 
   public:
-    SocketForwarder(
-        std::string const &host,
-        uint16_t port,
-        unsigned int size,
-        bool tcp,
-        QObject *parent = nullptr);
+    struct ForwarderParams {
+      std::string host;       // Bind address in server mode
+      uint16_t port;
+      unsigned int size;      // Maximum datagram size, in bytes
+      bool tcp = false;
+      bool framed = false;    // Prepend a ForwarderFrameHeader (UDP only)
+      quint64 pacing = 0;     // Maximum rate in bytes per second (UDP only)
+      ForwarderSampleFormat format = FORWARDER_FORMAT_COMPLEX_FLOAT32;
+
+      // Server mode: accept any number of TCP clients and stream the
+      // same samples to all of them.
+      bool server = false;
+      size_t clientQueueSize = SIGDIGGER_FORWARDER_CLIENT_QUEUE_SIZE;
+      ForwarderSlowClientPolicy slowClientPolicy = FORWARDER_SLOW_CLIENT_DROP;
+    };
+
+    SocketForwarder(ForwarderParams const &params, QObject *parent = nullptr);
   };
 }
 
@@ -111,6 +111,42 @@ namespace SigDigger {
         return this->saverUI->getRecordSavePath();
       }
 
+      quint64
+      getRecordSegmentSize(void) const
+      {
+        return this->saverUI->getSegmentSize();
+      }
+
+      quint64
+      getRecordSegmentDuration(void) const
+      {
+        return this->saverUI->getSegmentDuration();
+      }
+
+      quint64
+      getRecordQuota(void) const
+      {
+        return this->saverUI->getQuota();
+      }
+
+      unsigned int
+      getRecordPreRoll(void) const
+      {
+        return this->saverUI->getPreRoll();
+      }
+
+      unsigned int
+      getRecordSyncInterval(void) const
+      {
+        return this->saverUI->getSyncInterval();
+      }
+
+      bool
+      getRecordSubband(void) const
+      {
+        return this->saverUI->getSubband();
+      }
+
       bool
       isThrottleEnabled(void) const
       {
@@ -165,6 +201,7 @@ namespace SigDigger {
       void setCaptureSize(quint64);
       void setDiskUsage(qreal);
       void setIORate(qreal);
+      void setCaptureStats(DataSaverStats const &);
       void setRecordState(bool state);
       void setSavePath(std::string const &path);
       void setDCRemove(bool remove);
@@ -191,6 +228,7 @@ namespace SigDigger {
       void toggleAGCEnabled(void);
       void bandwidthChanged(void);
       void ppmChanged(void);
+      void preRollChanged(void);
 
     public slots:
       void onGainChanged(QString name, float val);
@@ -205,6 +243,7 @@ namespace SigDigger {
       void onToggleAGCEnabled(void);
       void onBandwidthChanged(void);
       void onPPMChanged(void);
+      void onPreRollChanged(void);
   };
 };
 
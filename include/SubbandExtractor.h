@@ -0,0 +1,141 @@
+//
+//    SubbandExtractor.h: Record a single channel of the source
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SUBBANDEXTRACTOR_H
+#define SUBBANDEXTRACTOR_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <vector>
+#include <sigutils/types.h>
+
+// Filter taps per polyphase branch. Enough for ~70 dB of alias rejection
+#define SIGDIGGER_SUBBAND_TAPS_PER_PHASE 32
+
+// Output sample rate relative to the channel bandwidth
+#define SIGDIGGER_SUBBAND_OVERSAMPLING   1.25
+
+// NCO lanes, and samples between two NCO resyncs
+#define SIGDIGGER_SUBBAND_NCO_LANES      8
+#define SIGDIGGER_SUBBAND_NCO_BLOCK      1024
+
+namespace SigDigger {
+  class GenericDataSaver;
+  class SubbandExtractor;
+
+  //
+  // Digital downconverter: an NCO brings the channel to DC and a low pass
+  // FIR, only evaluated at the decimated instants (which is what a
+  // polyphase decimator computes), reduces the sample rate.
+  //
+  class SubbandDDC {
+    std::vector<SUFLOAT> taps;     // Interleaved: every tap appears twice
+    std::vector<SUCOMPLEX> line;   // Mixed samples, oldest first
+    unsigned int decimation = 1;
+    size_t next = 0;               // Position of the next output in line
+
+    SUDOUBLE omega = 0;            // Radians per sample
+    SUDOUBLE phase = 0;            // Phase of the next input sample
+
+    void mix(SUCOMPLEX *out, const SUCOMPLEX *in, size_t len);
+
+  public:
+    struct Params {
+      SUFLOAT sampRate = 0;  // Input sample rate
+      SUFLOAT offset = 0;    // Channel frequency, relative to the center
+      SUFLOAT bandwidth = 0; // Channel bandwidth
+    };
+
+    static unsigned int decimationFor(SUFLOAT sampRate, SUFLOAT bandwidth);
+
+    void configure(Params const &params);
+    void reset(void);
+
+    unsigned int
+    getDecimation(void) const
+    {
+      return this->decimation;
+    }
+
+    // Appends the decimated samples to out
+    void feed(
+        const SUCOMPLEX *data,
+        size_t len,
+        std::vector<SUCOMPLEX> &out);
+  };
+
+  class SubbandWorker : public QObject {
+    Q_OBJECT
+
+    SubbandExtractor *instance;
+    std::vector<SUCOMPLEX> output;
+
+  public:
+    SubbandWorker(SubbandExtractor *instance);
+
+  public slots:
+    void onProcess(void);
+  };
+
+  //
+  // Sits between the source and a data saver. Samples are copied into a
+  // double buffer from the analyzer thread and downconverted in a worker
+  // thread of their own, so the source is never slowed down by the DSP.
+  //
+  class SubbandExtractor : public QObject {
+    Q_OBJECT
+
+    SubbandDDC ddc;
+    GenericDataSaver *saver = nullptr;
+
+    std::vector<SUCOMPLEX> buffers[2];
+    unsigned int buffer = 0;
+    size_t ptr = 0;
+    size_t committed = 0;
+    size_t chunk = 0;
+    bool workerReady = true;
+    bool overflow = false;
+
+    QMutex dataMutex;    // Protects the double buffer
+    QMutex saverMutex;   // Held by the worker while it uses the saver
+
+    QThread workerThread;
+    SubbandWorker workerObject;
+
+  public:
+    SubbandExtractor(QObject *parent = nullptr);
+    ~SubbandExtractor();
+
+    void attach(GenericDataSaver *saver, SubbandDDC::Params const &params);
+    void detach(void);
+    bool isAttached(void) const;
+
+    // Called from the analyzer thread
+    void feed(const SUCOMPLEX *data, size_t len);
+
+    friend class SubbandWorker;
+
+  signals:
+    void process(void);
+    void swamped(void);
+  };
+}
+
+#endif // SUBBANDEXTRACTOR_H
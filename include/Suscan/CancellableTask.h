@@ -21,8 +21,19 @@
 
 #include <QObject>
 #include <QThread>
+#include <atomic>
+
+// Time spent calling work() in a row before reporting progress
+#define SUSCAN_CANCELLABLE_TASK_SLICE_MS 20
 
 namespace Suscan {
+  // What a task spends most of its time on. Background task controllers
+  // limit how many tasks of each kind run at the same time.
+  enum class TaskResource {
+    CPU,
+    DISK
+  };
+
   class CancellableTask : public QObject
   {
     Q_OBJECT
@@ -30,12 +41,25 @@ namespace Suscan {
     qreal prog;
     QString status;
     quint64 dataSize = 0;
+    TaskResource resource = TaskResource::CPU;
+    bool sliceEnded = false;
+    std::atomic<bool> cancelPending;
+    std::atomic<quint64> cpuTime; // Microseconds
 
   protected:
+    // Samples the task goes through, for the processing rate
     void setDataSize(quint64);
+    void setResource(TaskResource);
     void setProgress(qreal progress);
     void setStatus(QString status);
 
+    // Return to the event loop right after the current work() call. For
+    // tasks that emit pointers to buffers that the next call overwrites.
+    void endSlice(void);
+
+    // For tasks that do part of their work in threads of their own
+    void addCpuTime(quint64 us);
+
   public:
     explicit CancellableTask(QObject *parent = nullptr);
     virtual ~CancellableTask(void);
@@ -61,6 +85,27 @@ namespace Suscan {
       return this->dataSize;
     }
 
+    TaskResource
+    getResource(void) const
+    {
+      return this->resource;
+    }
+
+    // Thread-safe. CPU time spent so far, in microseconds
+    quint64
+    getCpuTime(void) const
+    {
+      return this->cpuTime;
+    }
+
+    // CPU time consumed by the calling thread, in microseconds. Zero if
+    // the platform does not tell.
+    static quint64 threadCpuTime(void);
+
+    // Thread-safe. Cuts the current time slice short so that a queued
+    // cancel request is delivered without waiting for it to expire.
+    void interrupt(void);
+
     static void assertTypeRegistration(void);
 
   public slots:
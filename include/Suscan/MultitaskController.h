@@ -26,32 +26,83 @@
 #include <QVector>
 #include <QThread>
 #include <QDateTime>
+#include <QElapsedTimer>
+
+// Disk-bound tasks running at the same time. More than this only makes
+// them compete for the disk
+#define SUSCAN_MULTITASK_MAX_DISK_TASKS 2
+
+// Slots per resource that only interactive tasks may take, so they do not
+// wait behind a pool full of background work
+#define SUSCAN_MULTITASK_INTERACTIVE_SLOTS 1
+
+// Weight of the latest progress report in the processing rate
+#define SUSCAN_MULTITASK_RATE_ALPHA .25
 
 namespace Suscan {
+  enum class TaskPriority {
+    INTERACTIVE, // The user is waiting for the result
+    BACKGROUND
+  };
+
+  enum class TaskOutcome {
+    DONE,
+    CANCELLED,
+    FAILED
+  };
+
+  // What a task took, reported once it is over
+  struct TaskTelemetry {
+    QString title;
+    TaskOutcome outcome = TaskOutcome::DONE;
+    TaskPriority priority = TaskPriority::BACKGROUND;
+    TaskResource resource = TaskResource::CPU;
+    QDateTime creationTime;
+    QDateTime startTime;    // Invalid if it never left the queue
+    qint64 queueTime = 0;   // ms
+    qint64 wallTime = 0;    // ms
+    quint64 cpuTime = 0;    // us, of all the threads of the task
+    quint64 samples = 0;    // Processed samples
+    quint64 bytes = 0;
+    qreal meanRate = 0;     // Samples per second
+    qreal peakRate = 0;
+
+    static QString outcomeString(TaskOutcome);
+  };
+
   //
-  // CancellableTaskContext acquires ownership on
-  // CancellableTask and the thread in which runs
+  // CancellableTaskContext acquires ownership on CancellableTask. The
+  // thread in which it runs is borrowed from the controller's pool.
   //
 
   class CancellableTaskContext {
       QThread *mThread = nullptr;
       CancellableTask *mTask = nullptr;
+      TaskPriority mPriority;
       QDateTime mCreationTime;
+      QDateTime mStartTime;
       QDateTime mLastUpdate;
+      QElapsedTimer mWallTimer;
       qreal mRate = 0; // Processing rate
+      qreal mPeakRate = 0;
+      qreal mEta = -1;
       QString mTitle;
       QString mLastProgressMessage;
       qreal mLastProgressValue = 0;
       int mIndex = -1;
 
-      void connectAll(void);
-
     public:
-      CancellableTaskContext(CancellableTask *, QString const &);
+      CancellableTaskContext(
+          CancellableTask *,
+          QString const &,
+          TaskPriority);
       ~CancellableTaskContext();
 
-      void start(void);
+      void start(QThread *);
+      bool running(void) const;
+      QThread *thread(void) const;
       CancellableTask *task(void) const;
+      TaskPriority priority(void) const;
       QString title(void) const;
 
       void assignIndex(int);
@@ -62,6 +113,10 @@ namespace Suscan {
       qreal progressValue(void) const;
       QDateTime creationTime(void) const;
       qreal processingRate(void) const;
+
+      // Seconds to completion, negative if unknown
+      qreal eta(void) const;
+      TaskTelemetry telemetry(TaskOutcome) const;
   };
 
   class MultitaskController : public QObject
@@ -73,11 +128,24 @@ namespace Suscan {
       QVector<CancellableTaskContext *> taskVec;
       QMap<CancellableTask *, CancellableTaskContext *> reverseTaskMap;
 
+      // Thread pool. Threads are created on demand and kept afterwards.
+      std::list<QThread *> threads;
+      std::list<QThread *> idleThreads;
+      int cpuSlots;
+      int diskSlots;
+      int runningCpu = 0;
+      int runningDisk = 0;
+
       CancellableTaskContext *findTask(CancellableTask *) const;
       void connectNewTask(CancellableTask *);
       void repopulateTaskVector(void);
 
-      void removeTaskContext(CancellableTaskContext *);
+      int &runningCounter(TaskResource);
+      bool canStart(CancellableTaskContext const *);
+      void startTask(CancellableTaskContext *);
+      void schedule(void);
+
+      bool removeTaskContext(CancellableTaskContext *, TaskOutcome);
 
     public:
       explicit MultitaskController(QObject *parent = nullptr);
@@ -85,14 +153,19 @@ namespace Suscan {
 
       void pushTask(
           CancellableTask *,
-          QString const &);
+          QString const &,
+          TaskPriority = TaskPriority::BACKGROUND);
       void getTaskVector(QVector<CancellableTaskContext *> &) const;
       void cancelAll(void);
       void cancelByIndex(int);
       void cleanup(void);
 
+      int runningCount(void) const;
+      int queuedCount(void) const;
+
     signals:
       void taskAdded(CancellableTask *);
+      void taskStarted(int);
       void taskRemoved(CancellableTask *);
 
       void taskProgress(int, qreal, QString);
@@ -100,6 +173,9 @@ namespace Suscan {
       void taskCancelled(int);
       void taskError(int, QString);
 
+      // Right before taskDone, taskCancelled or taskError
+      void taskFinished(Suscan::TaskTelemetry);
+
       void cancel(void);
 
     public slots:
@@ -110,4 +186,6 @@ namespace Suscan {
   };
 }
 
+Q_DECLARE_METATYPE(Suscan::TaskTelemetry);
+
 #endif // MULTITASKCONTROLLER_H
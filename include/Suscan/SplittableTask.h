@@ -0,0 +1,92 @@
+//
+//    SplittableTask.h: Tasks that run over ranges in parallel
+//    Copyright (C) 2020 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SPLITTABLETASK_H
+#define SPLITTABLETASK_H
+
+#include <Suscan/CancellableTask.h>
+#include <functional>
+
+// Items handed to the range pool in every call to work()
+#define SUSCAN_SPLITTABLE_TASK_DEFAULT_BLOCK   (1 << 20)
+
+// Pieces shorter than this are not worth waking up a thread for
+#define SUSCAN_SPLITTABLE_TASK_DEFAULT_PIECE   (1 << 14)
+
+namespace Suscan {
+  // Runs func over [first, first + len) split in at most parallelPieces()
+  // contiguous pieces of at least minPiece items, using a pool of threads
+  // shared by all callers, and waits for all of them. Returns the CPU time
+  // (in microseconds) that pool threads spent on it, which the calling
+  // thread's own CPU time does not include.
+  quint64 parallelFor(
+      size_t first,
+      size_t len,
+      size_t minPiece,
+      std::function<void (size_t, size_t)> const &func);
+
+  unsigned int parallelPieces(void);
+
+  //
+  // Base class for tasks whose work is separable over ranges of items
+  // (usually samples). Every work() call takes the next block of the range,
+  // splits it in contiguous pieces that are processed at the same time by
+  // a pool of threads shared by all tasks, and then calls blockDone() from
+  // the task thread to merge and deliver the results.
+  //
+  class SplittableTask : public CancellableTask
+  {
+    Q_OBJECT
+
+    size_t rangeFirst = 0;
+    size_t rangeEnd = 0;
+    size_t p = 0;
+    size_t blockLength = SUSCAN_SPLITTABLE_TASK_DEFAULT_BLOCK;
+    size_t pieceLength = SUSCAN_SPLITTABLE_TASK_DEFAULT_PIECE;
+    QString failure;
+
+  protected:
+    // Items from first (inclusive) to end (exclusive)
+    void setRange(size_t first, size_t end);
+    void setBlockLength(size_t);
+    void setMinPieceLength(size_t);
+
+    size_t getRangeFirst(void) const;
+    size_t getRangeEnd(void) const;
+
+    // Called from several threads at once, on disjoint pieces of a block.
+    // Must not touch anything that other pieces write to.
+    virtual void processRange(size_t first, size_t len) = 0;
+
+    // Called from the task thread once all pieces of a block are done
+    virtual void blockDone(size_t first, size_t len);
+
+    // Called from blockDone() to stop the task and emit error(message)
+    // instead of carrying on with the next block
+    void fail(QString const &message);
+
+  public:
+    explicit SplittableTask(QObject *parent = nullptr);
+    virtual ~SplittableTask() override;
+
+    // Emits done() after the last block
+    virtual bool work(void) override;
+  };
+}
+
+#endif // SPLITTABLETASK_H
@@ -28,14 +28,20 @@
 #include "HistogramDialog.h"
 #include "SamplerDialog.h"
 #include "DopplerDialog.h"
+#include "BatchExportDialog.h"
 
 #include "WaveSampler.h"
+#include "SampleBus.h"
+#include "SamplePipeline.h"
 
 #define TIME_WINDOW_MAX_SELECTION     4096
 #define TIME_WINDOW_MAX_DOPPLER_ITERS 200
 #define TIME_WINDOW_SPEED_OF_LIGHT    3e8
 #define TIME_WINDOW_EXTRA_WIDTH       72
 
+// Low-pass filter of the sampler when translating while measuring
+#define TIME_WINDOW_XLATE_FILTER_ORDER 4
+
 namespace Ui {
   class TimeWindow;
 }
@@ -49,6 +55,7 @@ namespace SigDigger {
     HistogramDialog *histogramDialog = nullptr;
     SamplerDialog *samplerDialog = nullptr;
     DopplerDialog *dopplerDialog = nullptr;
+    BatchExportDialog *batchExportDialog = nullptr;
 
     Ui::TimeWindow *ui = nullptr;
 
@@ -58,10 +65,27 @@ namespace SigDigger {
 
     qreal     fs;
 
-    std::vector<SUCOMPLEX> const *data;
-    std::vector<SUCOMPLEX> processedData;
+    // Sample vectors are shared with background tasks (e.g. exports).
+    // Shared vectors are never modified: they are replaced instead.
+    std::shared_ptr<std::vector<SUCOMPLEX>> processedData =
+        std::make_shared<std::vector<SUCOMPLEX>>();
+    std::shared_ptr<const std::vector<SUCOMPLEX>> data = processedData;
+    std::shared_ptr<const std::vector<SUCOMPLEX>> displayData = processedData;
+
+    // Selection of the last Doppler computation, tracked over time next
+    std::shared_ptr<const std::vector<SUCOMPLEX>> dopplerData;
+    size_t dopplerStart = 0;
+    size_t dopplerLen = 0;
+
+    // Interval the sampler streams through the carrier translator. Empty
+    // unless translating while measuring with the Gardner clock.
+    SampleBuffer samplingStream;
+    SUFLOAT samplingXlate = 0;
+    SUFLOAT samplingCutoff = 0;
 
-    std::vector<SUCOMPLEX> const *displayData = &processedData;
+    // Translated interval for the manual clocks, which average arbitrary
+    // windows of samples and cannot read them as a stream
+    std::vector<SUCOMPLEX> samplingData;
 
     SUCOMPLEX min;
     SUCOMPLEX max;
@@ -94,13 +118,21 @@ namespace SigDigger {
     void fineTuneSelSetEnabled(bool);
 
     void populateSamplingProperties(SamplingProperties &prop);
+    SampleBuffer getSamplingBuffer(SamplingProperties const &prop) const;
+    SUFLOAT getXlateOnTheFlyFreq(void) const;
+    SamplePipeline *makeXlatePipeline(
+        SampleBuffer const &source,
+        SUFLOAT relFreq,
+        SUFLOAT relCutoff) const;
     void startSampling(void);
 
     void setDisplayData(
-        std::vector<SUCOMPLEX> const *displayData,
+        std::shared_ptr<const std::vector<SUCOMPLEX>> const &displayData,
         bool keepView = false);
     const SUCOMPLEX *getDisplayData(void) const;
     size_t getDisplayDataLength(void) const;
+    SampleBuffer getDisplayBuffer(void) const;
+    SUCOMPLEX *allocProcessedData(void);
 
     static void adjustButtonToSize(
             QPushButton *button,
@@ -111,7 +143,9 @@ namespace SigDigger {
     ~TimeWindow();
 
     void setCenterFreq(SUFREQ center);
-    void setData(std::vector<SUCOMPLEX> const &data, qreal fs);
+    void setData(
+        std::shared_ptr<const std::vector<SUCOMPLEX>> const &data,
+        qreal fs);
     void setPalette(std::string const &);
     void setPaletteOffset(unsigned int);
     void setPaletteContrast(int);
@@ -140,6 +174,10 @@ namespace SigDigger {
 
     void onSaveAll(void);
     void onSaveSelection(void);
+    void onAddToBatch(void);
+    void onBatchExport(void);
+    void onBatchSelectionsChanged(void);
+    void onBatchExportRequested(void);
     void onFit(void);
     void onToggleAutoFit(void);
     void onZoomToSelection(void);
@@ -163,10 +201,12 @@ namespace SigDigger {
     void onGuessCarrier(void);
     void onSyncCarrier(void);
     void onResetCarrier(void);
+    void onToggleXlateOnTheFly(void);
 
     void onTriggerHistogram(void);
     void onHistogramBlanked(void);
     void onHistogramSamples(const float *data, unsigned int len);
+    void onHistogramValues(QVector<float> values);
 
     void onTriggerSampler(void);
     void onResample(void);
@@ -25,6 +25,7 @@
 #include <AppConfig.h>
 #include <QMessageBox>
 #include <BookmarkInfo.h>
+#include <DataSaverStats.h>
 
 #define SIGDIGGER_UI_MEDIATOR_DEFAULT_MIN_FREQ 0
 #define SIGDIGGER_UI_MEDIATOR_DEFAULT_MAX_FREQ 6000000000
@@ -113,6 +114,7 @@ namespace SigDigger {
         float *data,
         size_t size);
     void setCaptureSize(quint64 size);
+    void setCaptureStats(DataSaverStats const &stats);
     void refreshDevicesDone(void);
 
     QMessageBox::StandardButton shouldReduceRate(
@@ -153,12 +155,12 @@ namespace SigDigger {
     void setAudioRecordState(bool);
     void setAudioRecordSize(quint64 size);
     void setAudioRecordIORate(qreal rate);
+    void setAudioRecordStats(DataSaverStats const &stats);
     void setIORate(qreal rate);
     void saveUIConfig(void);
     void setProfile(Suscan::Source::Config const &config);
     void setPanSpectrumRunning(bool state);
     void resetRawInspector(qreal fs);
-    void feedRawInspector(const SUCOMPLEX *, size_t size);
 
     // Overriden methods
     Suscan::Serializable *allocConfig() override;
@@ -179,6 +181,7 @@ namespace SigDigger {
     void channelBandwidthChanged(qreal bw);
 
     void toggleRecord(void);
+    void preRollChanged(void);
     void throttleConfigChanged(void);
     void gainChanged(QString name, float val);
     void toggleIQReverse(void);
@@ -234,6 +237,8 @@ namespace SigDigger {
     void onTriggerBandPlan(void);
     void onTriggerLogMessages(void);
     void onTriggerBackgroundTasks(void);
+    void onTriggerRecordings(void);
+    void onTriggerCaptureOverview(void);
     void onAddBookmark(void);
     void onBookmarkAccepted(void);
     void onOpenBookmarkManager(void);
@@ -251,6 +256,7 @@ namespace SigDigger {
 
     // Source panel
     void onToggleRecord(void);
+    void onPreRollChanged(void);
     void onThrottleConfigChanged(void);
     void onGainChanged(QString name, float val);
     void onToggleDCRemove(void);
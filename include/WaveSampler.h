@@ -29,6 +29,9 @@
 #define SIGDIGGER_WAVESAMPLER_MAX_MF_SPAN         1024
 #define SIGDIGGER_WAVESAMPLER_MF_PERIODS          6
 
+// Samples averaged by a thread before splitting a block pays off
+#define SIGDIGGER_WAVESAMPLER_MIN_PIECE_SAMPLES    16384
+
 namespace SigDigger {
   struct WaveSampleSet {
     SUCOMPLEX block[SIGDIGGER_WAVESAMPLER_FEEDER_BLOCK_LENGTH];
@@ -56,6 +59,7 @@ namespace SigDigger {
 
     WaveSampleSet set;
 
+    SUCOMPLEX sampleSymbol(long p, SUCOMPLEX &prev) const;
     bool sampleManual(void);
     bool sampleGardner(void);
 
@@ -75,4 +79,6 @@ namespace SigDigger {
   };
 }
 
+Q_DECLARE_METATYPE(SigDigger::WaveSampleSet);
+
 #endif // WAVESAMPLER_H
@@ -4,6 +4,7 @@
 #include <QWidget>
 #include <sigutils/types.h>
 #include "ColorConfig.h"
+#include "SampleBus.h"
 
 class ThrottleControl;
 class QPushButton;
@@ -28,6 +29,7 @@ namespace SigDigger {
 
     const SUCOMPLEX *getDisplayData(void) const;
     size_t getDisplayDataLength(void) const;
+    SampleBuffer getExportBuffer(qint64 start, qint64 end) const;
 
     int getPeriodicDivision(void) const;
 
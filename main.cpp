@@ -22,6 +22,8 @@
 #include <iostream>
 #include <QFont>
 #include "Loader.h"
+#include <FftService.h>
+#include <RecordingService.h>
 
 #include <sigutils/version.h>
 #include <analyzer/version.h>
@@ -50,11 +52,16 @@ runSigDigger(QApplication &app)
   Application main_app;
   Loader loader(&main_app);
 
+  // Loads FFTW wisdom before anyone asks for a plan
+  FftService::getInstance();
+
   loader.load();
 
   ret = app.exec();
 
   Suscan::Singleton::get_instance()->killBackgroundTaskController();
+  RecordingService::getInstance()->shutdown();
+  FftService::getInstance()->shutdown();
 
   std::cout << "Saving config..." << std::endl;
 